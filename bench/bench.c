@@ -0,0 +1,244 @@
+/**
+ * Host benchmark harness (see bench.h).
+ */
+#define _POSIX_C_SOURCE 199309L
+
+#include "bench.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/utsname.h>
+#include <time.h>
+
+#define BENCH_WARMUP 3
+
+static const bench_case_t *cases[BENCH_MAX_CASES];
+static bench_result_t results[BENCH_MAX_CASES];
+static int case_count = 0;
+static int result_count = 0;
+
+static uint64_t samples[BENCH_MAX_ITERATIONS];
+static uint64_t deviations[BENCH_MAX_ITERATIONS];
+
+uint64_t bench_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+uint32_t bench_rand(uint32_t *state)
+{
+    uint32_t x = *state ? *state : 0x2545F491u;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+/* Fixed CPU work, run with every suite: bench_compare.py scales the baseline by how
+ * fast this ran, which cancels most machine-wide drift (CPU clock, shared hosts). */
+static volatile uint32_t reference_sink;
+
+static int run_reference(void)
+{
+    uint32_t state = 1, acc = 0;
+    for (int i = 0; i < 20000; i++)
+        acc += bench_rand(&state) >> 7;
+    reference_sink = acc;
+    return 0;
+}
+
+static const bench_case_t reference = {BENCH_REFERENCE_CASE, 200, 0, NULL, run_reference, NULL};
+
+int bench_add(const bench_case_t *bench)
+{
+    if (case_count >= BENCH_MAX_CASES || bench == NULL || bench->run == NULL)
+        return -1;
+    cases[case_count++] = bench;
+    return 0;
+}
+
+static int compare_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+/* Nearest-rank percentile of sorted values */
+static uint64_t percentile(const uint64_t *sorted, uint32_t n, uint32_t pct)
+{
+    uint32_t rank = (uint32_t)(((uint64_t)n * pct + 99) / 100);
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+typedef struct
+{
+    uint64_t median, mad, p99, min, max, mean;
+} round_stats_t;
+
+static round_stats_t rounds_of[BENCH_MAX_CASES][BENCH_MAX_ROUNDS];
+
+static void summarize_round(round_stats_t *st, uint32_t n)
+{
+    uint64_t total = 0;
+    for (uint32_t i = 0; i < n; i++)
+        total += samples[i];
+    qsort(samples, n, sizeof(samples[0]), compare_u64);
+    st->median = percentile(samples, n, 50);
+    st->p99 = percentile(samples, n, 99);
+    st->min = samples[0];
+    st->max = samples[n - 1];
+    st->mean = total / n;
+    for (uint32_t i = 0; i < n; i++)
+        deviations[i] = (samples[i] > st->median) ? samples[i] - st->median : st->median - samples[i];
+    qsort(deviations, n, sizeof(deviations[0]), compare_u64);
+    st->mad = percentile(deviations, n, 50);
+}
+
+/* One round: setup, warm-up, timed iterations, teardown */
+static int run_round(const bench_case_t *bench, uint32_t n, round_stats_t *st)
+{
+    if (bench->setup != NULL && bench->setup() != 0)
+        return -1;
+    int status = 0;
+    for (int i = 0; i < BENCH_WARMUP && status == 0; i++)
+        status = bench->run();
+    for (uint32_t i = 0; i < n && status == 0; i++)
+    {
+        uint64_t start = bench_now_ns();
+        status = bench->run();
+        samples[i] = bench_now_ns() - start;
+    }
+    if (bench->teardown != NULL)
+        bench->teardown();
+    if (status != 0)
+        return -1;
+    summarize_round(st, n);
+    return 0;
+}
+
+/* Median of one field over the rounds */
+static uint64_t median_of(const round_stats_t *st, uint32_t rounds, size_t offset)
+{
+    uint64_t values[BENCH_MAX_ROUNDS];
+    for (uint32_t r = 0; r < rounds; r++)
+        values[r] = *(const uint64_t *)((const uint8_t *)&st[r] + offset);
+    qsort(values, rounds, sizeof(values[0]), compare_u64);
+    return percentile(values, rounds, 50);
+}
+
+static void summarize(bench_result_t *r, const round_stats_t *st, uint32_t rounds)
+{
+    uint64_t total = 0;
+    r->min = st[0].min;
+    r->max = st[0].max;
+    for (uint32_t i = 0; i < rounds; i++)
+    {
+        total += st[i].mean;
+        if (st[i].min < r->min)
+            r->min = st[i].min;
+        if (st[i].max > r->max)
+            r->max = st[i].max;
+    }
+    r->mean = total / rounds;
+    r->median = median_of(st, rounds, offsetof(round_stats_t, median));
+    r->mad = median_of(st, rounds, offsetof(round_stats_t, mad));
+    r->p99 = median_of(st, rounds, offsetof(round_stats_t, p99));
+}
+
+int bench_run_all(const char *filter, uint32_t rounds, FILE *log)
+{
+    if (rounds < 1)
+        rounds = 1;
+    if (rounds > BENCH_MAX_ROUNDS)
+        rounds = BENCH_MAX_ROUNDS;
+
+    if (case_count == 0 || cases[0] != &reference)
+    {
+        if (case_count >= BENCH_MAX_CASES)
+            return case_count;
+        memmove(&cases[1], &cases[0], (size_t)case_count * sizeof(cases[0]));
+        cases[0] = &reference;
+        case_count++;
+    }
+
+    result_count = 0;
+    for (int i = 0; i < case_count; i++)
+    {
+        if (filter != NULL && cases[i] != &reference && strstr(cases[i]->name, filter) == NULL)
+            continue;
+        bench_result_t *r = &results[result_count++];
+        memset(r, 0, sizeof(*r));
+        r->bench = cases[i];
+        r->rounds = rounds;
+        r->iterations = cases[i]->iterations ? cases[i]->iterations : 1;
+        if (r->iterations > BENCH_MAX_ITERATIONS)
+            r->iterations = BENCH_MAX_ITERATIONS;
+    }
+
+    for (uint32_t round = 0; round < rounds; round++)
+    {
+        for (int i = 0; i < result_count; i++)
+        {
+            bench_result_t *r = &results[i];
+            if (r->status == 0 && run_round(r->bench, r->iterations, &rounds_of[i][round]) != 0)
+                r->status = -1;
+        }
+    }
+
+    int failed = 0;
+    if (log != NULL)
+        fprintf(log, "%-24s %6s %12s %10s %12s %12s %9s\n", "case", "iters", "median ns", "mad ns", "min ns",
+                "p99 ns", "MB/s");
+    for (int i = 0; i < result_count; i++)
+    {
+        bench_result_t *r = &results[i];
+        if (r->status != 0)
+        {
+            failed++;
+            if (log != NULL)
+                fprintf(log, "%-24s FAILED\n", r->bench->name);
+            continue;
+        }
+        summarize(r, rounds_of[i], rounds);
+        if (log != NULL)
+        {
+            double mbps = (r->bench->bytes && r->median) ? (double)r->bench->bytes * 1000.0 / (double)r->median : 0.0;
+            fprintf(log, "%-24s %6u %12llu %10llu %12llu %12llu %9.1f\n", r->bench->name,
+                    (unsigned)(r->iterations * r->rounds), (unsigned long long)r->median, (unsigned long long)r->mad,
+                    (unsigned long long)r->min, (unsigned long long)r->p99, mbps);
+        }
+    }
+    return failed;
+}
+
+int bench_write_json(const char *path)
+{
+    FILE *f = fopen(path, "w");
+    if (f == NULL)
+        return -1;
+    struct utsname host;
+    if (uname(&host) != 0)
+        memset(&host, 0, sizeof(host));
+    fprintf(f, "{\n  \"suite\": \"host\",\n  \"machine\": \"%s %s\",\n  \"unit\": \"ns\",\n  \"cases\": [", host.sysname,
+            host.machine);
+    int first = 1;
+    for (int i = 0; i < result_count; i++)
+    {
+        const bench_result_t *r = &results[i];
+        if (r->status != 0)
+            continue;
+        fprintf(f,
+                "%s\n    {\"name\": \"%s\", \"rounds\": %u, \"iterations\": %u, \"bytes\": %u, \"median\": %llu, \"mad\": %llu, "
+                "\"mean\": %llu, \"min\": %llu, \"max\": %llu, \"p99\": %llu}",
+                first ? "" : ",", r->bench->name, (unsigned)r->rounds, (unsigned)r->iterations, (unsigned)r->bench->bytes,
+                (unsigned long long)r->median, (unsigned long long)r->mad, (unsigned long long)r->mean,
+                (unsigned long long)r->min, (unsigned long long)r->max, (unsigned long long)r->p99);
+        first = 0;
+    }
+    fprintf(f, "\n  ]\n}\n");
+    return fclose(f) == 0 ? 0 : -1;
+}
@@ -0,0 +1,92 @@
+/**
+ * Host benchmark harness: named cases, timed per iteration with CLOCK_MONOTONIC.
+ *
+ * A round of a case runs setup(), a few warm-up iterations, `iterations` timed calls of
+ * run() and teardown(). Rounds are interleaved across cases so a burst of load on the
+ * machine hits one round of several cases rather than every sample of one. The result
+ * keeps, in nanoseconds, the median of the round medians, the median of the round median
+ * absolute deviations (MAD) and p99s, the mean, min and max. bench_write_json() writes
+ * every case for python_scripts/bench_compare.py, which gates against bench/baselines/.
+ * A fixed CPU-bound reference case (BENCH_REFERENCE_CASE) always runs first so the
+ * comparison can factor out how fast the machine was during the run.
+ *
+ * Cases register themselves from bench_*_register() (bench_main.c).
+ */
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BENCH_MAX_CASES 32
+#define BENCH_MAX_ITERATIONS 4096
+#define BENCH_MAX_ROUNDS 15
+#define BENCH_DEFAULT_ROUNDS 5
+#define BENCH_REFERENCE_CASE "ref.cpu" /* always run; see bench.c */
+
+typedef struct
+{
+    const char *name;       /* "<group>.<case>", e.g. "fatfs.seq_read" */
+    uint32_t iterations;    /* timed calls of run() (at most BENCH_MAX_ITERATIONS) */
+    uint32_t bytes;         /* processed per iteration, for MB/s (0: not a throughput case) */
+    int (*setup)(void);     /* optional; returns 0 on success */
+    int (*run)(void);       /* one iteration; returns 0 on success */
+    void (*teardown)(void); /* optional */
+} bench_case_t;
+
+typedef struct
+{
+    const bench_case_t *bench;
+    int status; /* 0, or -1 if setup / an iteration failed */
+    uint32_t rounds;
+    uint32_t iterations; /* per round */
+    uint64_t median;
+    uint64_t mad;
+    uint64_t mean;
+    uint64_t min;
+    uint64_t max;
+    uint64_t p99;
+} bench_result_t;
+
+/** Register a case (the struct must stay valid). Returns 0, or -1 if the table is full. */
+int bench_add(const bench_case_t *bench);
+
+/**
+ * Run rounds (1..BENCH_MAX_ROUNDS) of every registered case whose name contains filter
+ * (NULL: all). Returns the number of failed cases.
+ */
+int bench_run_all(const char *filter, uint32_t rounds, FILE *log);
+
+/** Write the results of the last bench_run_all() as JSON. Returns 0 on success. */
+int bench_write_json(const char *path);
+
+/** Monotonic time in nanoseconds. */
+uint64_t bench_now_ns(void);
+
+/** Deterministic pseudo-random numbers (xorshift32) so runs read the same data. */
+uint32_t bench_rand(uint32_t *state);
+
+/** Format and mount the RAM disk volume (once; bench_fatfs.c). Returns 0 on success. */
+int bench_fs_init(void);
+
+/* Suites (bench_*.c). Each returns 0, or -1 if it could not register / prepare its data. */
+int bench_fatfs_register(void);
+int bench_ivf_register(void);
+int bench_uart_register(void);
+int bench_seek_register(void);
+#ifdef BENCH_MODEL
+int bench_model_register(void);
+
+/** Classify a 32x32x3 image with the default model (bench_model.cc). -1 on failure. */
+int bench_model_predict(const uint8_t *image);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BENCH_H */
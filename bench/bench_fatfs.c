@@ -0,0 +1,334 @@
+/**
+ * FatFs cases: sequential and random image reads from one file on an exFAT RAM disk,
+ * laid out like the CIFAR-10 images on the SD card (32x32x3 bytes each), and random
+ * reads of the same images as one file per image vs. a packed dataset (dataset.h) on
+ * the FAT volume vs. the same dataset in a raw partition (rawpart.h, on drive 1).
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "bench.h"
+#include "crc32.h"
+#include "dataset.h"
+#include "diskio.h"
+#include "ff.h"
+#include "ramdisk.h"
+#include "rawpart.h"
+
+#define BENCH_DISK_SECTORS 131072 /* 64 MB (4 KB exFAT clusters) */
+#define BENCH_IMAGE_BYTES (32 * 32 * 3)
+#define BENCH_IMAGE_COUNT 1000
+#define BENCH_IMAGES_PER_ITER 64
+#define BENCH_IMAGE_PATH "images.bin"
+#define BENCH_IMAGE_DIR "img"
+#define BENCH_DATASET_PATH "images.ids"
+#define BENCH_RAW_DRIVE 1
+#define BENCH_RAW_LBA 2048 /* partition start, as make_sd_image.py places it */
+#define BENCH_RAW_DATA 8   /* first extent sector (superblock in sector 0) */
+
+static FATFS fs;
+static FIL image_file;
+static uint8_t image[BENCH_IMAGE_BYTES];
+static uint32_t next_image = 0;
+static uint32_t rand_state = 1;
+static dataset_t dataset;
+
+int bench_fs_init(void)
+{
+    static int mounted = 0;
+    if (mounted)
+        return 0;
+    static BYTE work[FF_MAX_SS * 8];
+    const MKFS_PARM opt = {FM_EXFAT, 0, 0, 0, 0};
+    if (ramdisk_init(BENCH_DISK_SECTORS) != 0 || f_mkfs("", &opt, work, sizeof(work)) != FR_OK ||
+        f_mount(&fs, "", 1) != FR_OK)
+        return -1;
+    mounted = 1;
+    return 0;
+}
+
+/* Image i: a deterministic pattern, so reads can be checked */
+static void fill_image(uint8_t *data, uint32_t i)
+{
+    for (uint32_t b = 0; b < BENCH_IMAGE_BYTES; b++)
+        data[b] = (uint8_t)(i * 31u + b);
+}
+
+static int write_images(void)
+{
+    FIL f;
+    UINT written;
+    if (f_open(&f, BENCH_IMAGE_PATH, FA_WRITE | FA_CREATE_ALWAYS) != FR_OK)
+        return -1;
+    for (uint32_t i = 0; i < BENCH_IMAGE_COUNT; i++)
+    {
+        fill_image(image, i);
+        if (f_write(&f, image, BENCH_IMAGE_BYTES, &written) != FR_OK || written != BENCH_IMAGE_BYTES)
+        {
+            f_close(&f);
+            return -1;
+        }
+    }
+    return f_close(&f) == FR_OK ? 0 : -1;
+}
+
+static int read_image(uint32_t i)
+{
+    UINT read;
+    if (f_lseek(&image_file, (FSIZE_t)i * BENCH_IMAGE_BYTES) != FR_OK ||
+        f_read(&image_file, image, BENCH_IMAGE_BYTES, &read) != FR_OK || read != BENCH_IMAGE_BYTES)
+        return -1;
+    return (image[0] == (uint8_t)(i * 31u)) ? 0 : -1;
+}
+
+static int setup(void)
+{
+    static int written = 0;
+    if (bench_fs_init() != 0 || (!written && write_images() != 0))
+        return -1;
+    written = 1;
+    next_image = 0;
+    rand_state = 1;
+    return f_open(&image_file, BENCH_IMAGE_PATH, FA_READ) == FR_OK ? 0 : -1;
+}
+
+static void teardown(void)
+{
+    f_close(&image_file);
+}
+
+static int run_seq_read(void)
+{
+    for (int n = 0; n < BENCH_IMAGES_PER_ITER; n++)
+    {
+        if (read_image(next_image) != 0)
+            return -1;
+        next_image = (next_image + 1) % BENCH_IMAGE_COUNT;
+    }
+    return 0;
+}
+
+static int run_random_read(void)
+{
+    for (int n = 0; n < BENCH_IMAGES_PER_ITER; n++)
+    {
+        if (read_image(bench_rand(&rand_state) % BENCH_IMAGE_COUNT) != 0)
+            return -1;
+    }
+    return 0;
+}
+
+/* Old SD layout: img/<i>.bin, one file per image */
+static int write_image_files(void)
+{
+    FIL f;
+    UINT written;
+    char path[24];
+    FRESULT fr = f_mkdir(BENCH_IMAGE_DIR);
+    if (fr != FR_OK && fr != FR_EXIST)
+        return -1;
+    for (uint32_t i = 0; i < BENCH_IMAGE_COUNT; i++)
+    {
+        snprintf(path, sizeof(path), "%s/%u.bin", BENCH_IMAGE_DIR, (unsigned)i);
+        fill_image(image, i);
+        if (f_open(&f, path, FA_WRITE | FA_CREATE_ALWAYS) != FR_OK)
+            return -1;
+        fr = f_write(&f, image, BENCH_IMAGE_BYTES, &written);
+        if (f_close(&f) != FR_OK || fr != FR_OK || written != BENCH_IMAGE_BYTES)
+            return -1;
+    }
+    return 0;
+}
+
+/* The same images packed as python_scripts/pack_images.py does */
+static int write_dataset(void)
+{
+    static uint8_t labels[BENCH_IMAGE_COUNT];
+    static const uint8_t zeros[DATASET_SECTOR];
+    dataset_header_t h;
+    FIL f;
+    UINT written;
+    for (uint32_t i = 0; i < BENCH_IMAGE_COUNT; i++)
+        labels[i] = (uint8_t)(i % 10);
+    memset(&h, 0, sizeof(h));
+    h.magic = DATASET_MAGIC;
+    h.count = BENCH_IMAGE_COUNT;
+    h.width = 32;
+    h.height = 32;
+    h.channels = 3;
+    h.image_bytes = BENCH_IMAGE_BYTES;
+    h.stride = (BENCH_IMAGE_BYTES + DATASET_SECTOR - 1) / DATASET_SECTOR * DATASET_SECTOR;
+    h.data_offset = (sizeof(h) + BENCH_IMAGE_COUNT + DATASET_SECTOR - 1) / DATASET_SECTOR * DATASET_SECTOR;
+    h.labels_crc32 = crc32_update(0, labels, sizeof(labels));
+    if (f_open(&f, BENCH_DATASET_PATH, FA_WRITE | FA_CREATE_ALWAYS) != FR_OK)
+        return -1;
+    int status = (f_write(&f, &h, sizeof(h), &written) == FR_OK && f_write(&f, labels, sizeof(labels), &written) == FR_OK &&
+                  f_lseek(&f, h.data_offset) == FR_OK) ? 0 : -1;
+    for (uint32_t i = 0; i < BENCH_IMAGE_COUNT && status == 0; i++)
+    {
+        fill_image(image, i);
+        if (f_write(&f, image, BENCH_IMAGE_BYTES, &written) != FR_OK || written != BENCH_IMAGE_BYTES ||
+            f_write(&f, zeros, h.stride - BENCH_IMAGE_BYTES, &written) != FR_OK)
+            status = -1;
+    }
+    if (f_close(&f) != FR_OK)
+        status = -1;
+    return status;
+}
+
+static int setup_files(void)
+{
+    static int written = 0;
+    if (bench_fs_init() != 0 || (!written && write_image_files() != 0))
+        return -1;
+    written = 1;
+    rand_state = 1;
+    return 0;
+}
+
+static int run_file_per_image(void)
+{
+    char path[24];
+    for (int n = 0; n < BENCH_IMAGES_PER_ITER; n++)
+    {
+        uint32_t i = bench_rand(&rand_state) % BENCH_IMAGE_COUNT;
+        FIL f;
+        UINT read;
+        snprintf(path, sizeof(path), "%s/%u.bin", BENCH_IMAGE_DIR, (unsigned)i);
+        if (f_open(&f, path, FA_READ) != FR_OK)
+            return -1;
+        FRESULT fr = f_read(&f, image, BENCH_IMAGE_BYTES, &read);
+        f_close(&f);
+        if (fr != FR_OK || read != BENCH_IMAGE_BYTES || image[0] != (uint8_t)(i * 31u))
+            return -1;
+    }
+    return 0;
+}
+
+static int prepare_dataset(void)
+{
+    static int written = 0;
+    if (bench_fs_init() != 0 || (!written && write_dataset() != 0))
+        return -1;
+    written = 1;
+    return 0;
+}
+
+static int setup_dataset(void)
+{
+    if (prepare_dataset() != 0)
+        return -1;
+    rand_state = 1;
+    return dataset_open(&dataset, BENCH_DATASET_PATH);
+}
+
+static void teardown_dataset(void)
+{
+    dataset_close(&dataset);
+}
+
+static void store_le32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+/* Drive 1: MBR and a raw partition holding the dataset file as extent "images",
+ * the layout python_scripts/make_sd_image.py writes */
+static int write_raw_partition(void)
+{
+    static uint8_t buf[64 * DATASET_SECTOR];
+    rawpart_superblock_t sb;
+    FIL f;
+    UINT n;
+    if (f_open(&f, BENCH_DATASET_PATH, FA_READ) != FR_OK)
+        return -1;
+    uint32_t bytes = (uint32_t)f_size(&f);
+    uint32_t sectors = BENCH_RAW_DATA + (bytes + DATASET_SECTOR - 1) / DATASET_SECTOR;
+    uint32_t crc = 0;
+    int status = ramdisk_init_drive(BENCH_RAW_DRIVE, BENCH_RAW_LBA + sectors);
+    for (LBA_t lba = BENCH_RAW_LBA + BENCH_RAW_DATA; status == 0; lba += sizeof(buf) / DATASET_SECTOR)
+    {
+        memset(buf, 0, sizeof(buf));
+        if (f_read(&f, buf, sizeof(buf), &n) != FR_OK)
+            status = -1;
+        else if (n == 0)
+            break;
+        else
+        {
+            crc = crc32_update(crc, buf, n);
+            UINT count = (n + DATASET_SECTOR - 1) / DATASET_SECTOR;
+            status = disk_write(BENCH_RAW_DRIVE, buf, lba, count) == RES_OK ? 0 : -1;
+        }
+    }
+    f_close(&f);
+    if (status != 0)
+        return -1;
+
+    memset(&sb, 0, sizeof(sb));
+    sb.magic = RAWPART_MAGIC;
+    sb.extent_count = 1;
+    sb.sectors = sectors;
+    strcpy(sb.extents[0].name, "images");
+    sb.extents[0].start = BENCH_RAW_DATA;
+    sb.extents[0].sectors = sectors - BENCH_RAW_DATA;
+    sb.extents[0].bytes = bytes;
+    sb.extents[0].crc32 = crc;
+    sb.crc32 = crc32_update(0, sb.extents, sizeof(sb.extents[0]));
+    memset(buf, 0, DATASET_SECTOR);
+    memcpy(buf, &sb, sizeof(sb));
+    if (disk_write(BENCH_RAW_DRIVE, buf, BENCH_RAW_LBA, 1) != RES_OK)
+        return -1;
+
+    memset(buf, 0, DATASET_SECTOR);
+    uint8_t *entry = buf + 446;
+    entry[4] = RAWPART_MBR_TYPE;
+    store_le32(entry + 8, BENCH_RAW_LBA);
+    store_le32(entry + 12, sectors);
+    buf[510] = 0x55;
+    buf[511] = 0xAA;
+    return disk_write(BENCH_RAW_DRIVE, buf, 0, 1) == RES_OK ? 0 : -1;
+}
+
+static int setup_raw(void)
+{
+    static int written = 0;
+    if (prepare_dataset() != 0 || (!written && write_raw_partition() != 0))
+        return -1;
+    written = 1;
+    rand_state = 1;
+    const rawpart_extent_t *extent = (rawpart_mount(BENCH_RAW_DRIVE) == 0) ? rawpart_find("images") : NULL;
+    return extent != NULL ? dataset_open_raw(&dataset, extent) : -1;
+}
+
+static int run_dataset_read(void)
+{
+    for (int n = 0; n < BENCH_IMAGES_PER_ITER; n++)
+    {
+        uint32_t i = bench_rand(&rand_state) % BENCH_IMAGE_COUNT;
+        if (dataset_read(&dataset, i, 1, image, sizeof(image)) != 0 || image[0] != (uint8_t)(i * 31u) ||
+            dataset_label(&dataset, i) != (int)(i % 10))
+            return -1;
+    }
+    return 0;
+}
+
+static const bench_case_t seq_read = {"fatfs.seq_read", 200, BENCH_IMAGES_PER_ITER * BENCH_IMAGE_BYTES,
+                                      setup, run_seq_read, teardown};
+static const bench_case_t random_read = {"fatfs.random_read", 200, BENCH_IMAGES_PER_ITER * BENCH_IMAGE_BYTES,
+                                         setup, run_random_read, teardown};
+
+static const bench_case_t file_per_image = {"fatfs.file_per_image", 200, BENCH_IMAGES_PER_ITER * BENCH_IMAGE_BYTES,
+                                            setup_files, run_file_per_image, NULL};
+static const bench_case_t dataset_random = {"fatfs.dataset_read", 200, BENCH_IMAGES_PER_ITER * BENCH_IMAGE_BYTES,
+                                            setup_dataset, run_dataset_read, teardown_dataset};
+static const bench_case_t raw_random = {"raw.dataset_read", 200, BENCH_IMAGES_PER_ITER * BENCH_IMAGE_BYTES, setup_raw,
+                                        run_dataset_read, teardown_dataset};
+
+int bench_fatfs_register(void)
+{
+    return (bench_add(&seq_read) == 0 && bench_add(&random_read) == 0 && bench_add(&file_per_image) == 0 &&
+            bench_add(&dataset_random) == 0 && bench_add(&raw_random) == 0) ? 0 : -1;
+}
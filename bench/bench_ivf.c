@@ -0,0 +1,164 @@
+/**
+ * IVF cases on a synthetic index: nearest-centroid scan, bucket load from the RAM disk
+ * volume and the exhaustive L2 search of one bucket. Shapes follow the on-device index
+ * (128-d float embeddings, buckets stored back to back in one file, opened once with a
+ * fast-seek cluster map as an IVF reader should); the data is random.
+ */
+#include <float.h>
+#include <string.h>
+
+#include "bench.h"
+#include "fastseek.h"
+#include "ff.h"
+
+#define IVF_DIM 128
+#define IVF_CENTROIDS 64
+#define IVF_BUCKET_VECTORS 64
+#define IVF_QUERIES 16
+#define IVF_BUCKET_BYTES (IVF_BUCKET_VECTORS * (IVF_DIM * sizeof(float) + sizeof(int32_t)))
+#define IVF_INDEX_PATH "ivf.bin"
+
+static float centroids[IVF_CENTROIDS][IVF_DIM];
+static float queries[IVF_QUERIES][IVF_DIM];
+static struct
+{
+    float vectors[IVF_BUCKET_VECTORS][IVF_DIM];
+    int32_t labels[IVF_BUCKET_VECTORS];
+} bucket;
+static FIL index_file;
+static DWORD index_clmt[FASTSEEK_CLMT_LEN];
+static uint32_t rand_state = 7;
+static uint32_t query = 0;
+static volatile int32_t sink; /* keeps results live */
+
+static float rand_unit(void)
+{
+    return (float)(bench_rand(&rand_state) & 0xFFFFu) / 65536.0f - 0.5f;
+}
+
+static float l2(const float *a, const float *b)
+{
+    float sum = 0.0f;
+    for (int d = 0; d < IVF_DIM; d++)
+    {
+        float diff = a[d] - b[d];
+        sum += diff * diff;
+    }
+    return sum;
+}
+
+static int write_index(void)
+{
+    FIL f;
+    UINT written;
+    if (f_open(&f, IVF_INDEX_PATH, FA_WRITE | FA_CREATE_ALWAYS) != FR_OK)
+        return -1;
+    for (int b = 0; b < IVF_CENTROIDS; b++)
+    {
+        for (int v = 0; v < IVF_BUCKET_VECTORS; v++)
+        {
+            for (int d = 0; d < IVF_DIM; d++)
+                bucket.vectors[v][d] = centroids[b][d] + 0.1f * rand_unit();
+            bucket.labels[v] = v % 10;
+        }
+        if (f_write(&f, &bucket, IVF_BUCKET_BYTES, &written) != FR_OK || written != IVF_BUCKET_BYTES)
+        {
+            f_close(&f);
+            return -1;
+        }
+    }
+    return f_close(&f) == FR_OK ? 0 : -1;
+}
+
+static int setup(void)
+{
+    static int built = 0;
+    if (!built)
+    {
+        rand_state = 7;
+        for (int c = 0; c < IVF_CENTROIDS; c++)
+            for (int d = 0; d < IVF_DIM; d++)
+                centroids[c][d] = rand_unit();
+        for (int q = 0; q < IVF_QUERIES; q++)
+            for (int d = 0; d < IVF_DIM; d++)
+                queries[q][d] = rand_unit();
+        if (bench_fs_init() != 0 || write_index() != 0)
+            return -1;
+        built = 1;
+    }
+    rand_state = 7;
+    query = 0;
+    if (f_open(&index_file, IVF_INDEX_PATH, FA_READ) != FR_OK)
+        return -1;
+    fastseek_enable(&index_file, index_clmt, FASTSEEK_CLMT_LEN); /* plain seeks if fragmented */
+    return 0;
+}
+
+static void teardown(void)
+{
+    f_close(&index_file);
+}
+
+static int load_bucket(uint32_t b)
+{
+    UINT read;
+    if (f_lseek(&index_file, (FSIZE_t)b * IVF_BUCKET_BYTES) != FR_OK ||
+        f_read(&index_file, &bucket, IVF_BUCKET_BYTES, &read) != FR_OK || read != IVF_BUCKET_BYTES)
+        return -1;
+    return 0;
+}
+
+static int run_centroid(void)
+{
+    const float *q = queries[query++ % IVF_QUERIES];
+    float best = FLT_MAX;
+    int32_t best_c = -1;
+    for (int c = 0; c < IVF_CENTROIDS; c++)
+    {
+        float d = l2(q, centroids[c]);
+        if (d < best)
+        {
+            best = d;
+            best_c = c;
+        }
+    }
+    sink = best_c;
+    return 0;
+}
+
+static int run_bucket_load(void)
+{
+    return load_bucket(bench_rand(&rand_state) % IVF_CENTROIDS);
+}
+
+static int setup_search(void)
+{
+    return (setup() == 0 && load_bucket(0) == 0) ? 0 : -1;
+}
+
+static int run_search(void)
+{
+    const float *q = queries[query++ % IVF_QUERIES];
+    float best = FLT_MAX;
+    int32_t label = -1;
+    for (int v = 0; v < IVF_BUCKET_VECTORS; v++)
+    {
+        float d = l2(q, bucket.vectors[v]);
+        if (d < best)
+        {
+            best = d;
+            label = bucket.labels[v];
+        }
+    }
+    sink = label;
+    return 0;
+}
+
+static const bench_case_t centroid = {"ivf.centroid", 2000, 0, setup, run_centroid, teardown};
+static const bench_case_t bucket_load = {"ivf.bucket_load", 1000, IVF_BUCKET_BYTES, setup, run_bucket_load, teardown};
+static const bench_case_t search = {"ivf.search", 2000, 0, setup_search, run_search, teardown};
+
+int bench_ivf_register(void)
+{
+    return (bench_add(&centroid) == 0 && bench_add(&bucket_load) == 0 && bench_add(&search) == 0) ? 0 : -1;
+}
@@ -0,0 +1,51 @@
+/**
+ * Host benchmark suite entry point.
+ *
+ *     bench_host [-o results.json] [-f filter] [-r rounds]
+ *
+ * Prints a table and writes JSON for python_scripts/bench_compare.py. Returns non-zero
+ * if a case failed to run (regressions are judged by bench_compare.py).
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+
+int main(int argc, char **argv)
+{
+    const char *out = "results.json";
+    const char *filter = NULL;
+    uint32_t rounds = BENCH_DEFAULT_ROUNDS;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+            out = argv[++i];
+        else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc)
+            filter = argv[++i];
+        else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+            rounds = (uint32_t)atoi(argv[++i]);
+        else
+        {
+            fprintf(stderr, "usage: %s [-o results.json] [-f filter] [-r rounds]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (bench_fatfs_register() != 0 || bench_ivf_register() != 0 || bench_uart_register() != 0 ||
+        bench_seek_register() != 0)
+        return 1;
+#ifdef BENCH_MODEL
+    if (bench_model_register() != 0)
+        return 1;
+#endif
+
+    int failed = bench_run_all(filter, rounds, stdout);
+    if (bench_write_json(out) != 0)
+    {
+        fprintf(stderr, "cannot write %s\n", out);
+        return 1;
+    }
+    printf("results: %s\n", out);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,54 @@
+/**
+ * Model cases (BENCH_MODEL, needs a host TFLM library): preprocessing, the embedding
+ * Invoke() and reading the embedding of the built-in model, on the bundled test image.
+ * The project kernels use their portable C paths on the host, so these track the
+ * relative cost of changes, not device cycles.
+ */
+#include "bench.h"
+#include "cifar10_test_images.h"
+#include "model/model_inference.h"
+
+#define BENCH_EMBEDDING_DIM 128
+
+static float embedding[BENCH_EMBEDDING_DIM];
+
+static int setup(void)
+{
+    static int ready = 0;
+    if (!ready && model_init() != 0)
+        return -1;
+    ready = 1;
+    model_preprocess_for_embedding(cifar10_test_images[0]);
+    return model_invoke_for_embedding();
+}
+
+static int run_preprocess(void)
+{
+    model_preprocess_for_embedding(cifar10_test_images[0]);
+    return 0;
+}
+
+static int run_invoke(void)
+{
+    return model_invoke_for_embedding();
+}
+
+static int run_embedding_get(void)
+{
+    model_get_embedding(embedding, BENCH_EMBEDDING_DIM);
+    return 0;
+}
+
+static const bench_case_t preprocess = {"model.preprocess", 1000, 0, setup, run_preprocess, nullptr};
+static const bench_case_t invoke = {"model.invoke", 100, 0, setup, run_invoke, nullptr};
+static const bench_case_t embedding_get = {"model.embedding_get", 1000, 0, setup, run_embedding_get, nullptr};
+
+int bench_model_register(void)
+{
+    return (bench_add(&preprocess) == 0 && bench_add(&invoke) == 0 && bench_add(&embedding_get) == 0) ? 0 : -1;
+}
+
+int bench_model_predict(const uint8_t *image)
+{
+    return model_predict_class(image);
+}
@@ -0,0 +1,165 @@
+/**
+ * Seek cases: random image-sized reads from files of 1, 4 and 16 MB on the RAM disk
+ * volume, with FatFs following the FAT chain on each seek (seek.chain.*) and with a
+ * fast-seek cluster link map built at open (seek.clmt.*, fastseek.h).
+ *
+ * The files are written interleaved in 512 KB pieces, so each is fragmented and has a
+ * real FAT chain, as on a card that has been written to before (a contiguous exFAT file
+ * needs no FAT reads, which hides the chain walk). Both grow with the file size, map
+ * seeks much more slowly: from 1 to 16 MB, 16 reads took 20 to 230 us with chain seeks
+ * and 5 to 16 us with the map on the dev host.
+ */
+#include <stddef.h>
+
+#include "bench.h"
+#include "fastseek.h"
+#include "ff.h"
+
+#define SEEK_FILES 3
+#define SEEK_PIECE (512 * 1024)
+#define SEEK_READ_BYTES (32 * 32 * 3)
+#define SEEK_READS_PER_ITER 16
+
+typedef struct
+{
+    const char *path;
+    uint32_t bytes;
+    FIL chain; /* plain FIL: seeks walk the FAT chain */
+    FIL fast;  /* same file with a cluster link map */
+    DWORD clmt[FASTSEEK_CLMT_LEN];
+} seek_file_t;
+
+static seek_file_t files[SEEK_FILES] = {
+    {"seek1.bin", 1u << 20},
+    {"seek4.bin", 4u << 20},
+    {"seek16.bin", 16u << 20},
+};
+static uint8_t piece[SEEK_PIECE];
+static uint8_t buf[SEEK_READ_BYTES];
+static uint32_t rand_state = 3;
+
+/* Byte at offset o of every file: checked after each read */
+static uint8_t pattern(uint32_t o)
+{
+    return (uint8_t)(o >> 9);
+}
+
+/* Round-robin 512 KB pieces until every file is complete */
+static int write_files(void)
+{
+    FIL out[SEEK_FILES];
+    UINT written;
+    int status = 0;
+    for (int i = 0; i < SEEK_FILES; i++)
+    {
+        if (f_open(&out[i], files[i].path, FA_WRITE | FA_CREATE_ALWAYS) != FR_OK)
+            return -1;
+    }
+    for (uint32_t offset = 0; offset < files[SEEK_FILES - 1].bytes && status == 0; offset += SEEK_PIECE)
+    {
+        for (uint32_t b = 0; b < SEEK_PIECE; b++)
+            piece[b] = pattern(offset + b);
+        for (int i = 0; i < SEEK_FILES && status == 0; i++)
+        {
+            if (offset < files[i].bytes &&
+                (f_write(&out[i], piece, SEEK_PIECE, &written) != FR_OK || written != SEEK_PIECE))
+                status = -1;
+        }
+    }
+    for (int i = 0; i < SEEK_FILES; i++)
+    {
+        if (f_close(&out[i]) != FR_OK)
+            status = -1;
+    }
+    return status;
+}
+
+static int setup(void)
+{
+    static int written = 0;
+    if (bench_fs_init() != 0 || (!written && write_files() != 0))
+        return -1;
+    written = 1;
+    rand_state = 3;
+    for (int i = 0; i < SEEK_FILES; i++)
+    {
+        seek_file_t *f = &files[i];
+        if (f_open(&f->chain, f->path, FA_READ) != FR_OK || f_open(&f->fast, f->path, FA_READ) != FR_OK ||
+            fastseek_enable(&f->fast, f->clmt, FASTSEEK_CLMT_LEN) != 0)
+            return -1;
+    }
+    return 0;
+}
+
+static void teardown(void)
+{
+    for (int i = 0; i < SEEK_FILES; i++)
+    {
+        f_close(&files[i].chain);
+        f_close(&files[i].fast);
+    }
+}
+
+static int random_reads(FIL *fp, uint32_t bytes)
+{
+    UINT read;
+    for (int n = 0; n < SEEK_READS_PER_ITER; n++)
+    {
+        uint32_t offset = bench_rand(&rand_state) % (bytes - SEEK_READ_BYTES);
+        if (f_lseek(fp, offset) != FR_OK || f_read(fp, buf, SEEK_READ_BYTES, &read) != FR_OK ||
+            read != SEEK_READ_BYTES || buf[0] != pattern(offset))
+            return -1;
+    }
+    return 0;
+}
+
+static int run_chain_1mb(void)
+{
+    return random_reads(&files[0].chain, files[0].bytes);
+}
+
+static int run_chain_4mb(void)
+{
+    return random_reads(&files[1].chain, files[1].bytes);
+}
+
+static int run_chain_16mb(void)
+{
+    return random_reads(&files[2].chain, files[2].bytes);
+}
+
+static int run_clmt_1mb(void)
+{
+    return random_reads(&files[0].fast, files[0].bytes);
+}
+
+static int run_clmt_4mb(void)
+{
+    return random_reads(&files[1].fast, files[1].bytes);
+}
+
+static int run_clmt_16mb(void)
+{
+    return random_reads(&files[2].fast, files[2].bytes);
+}
+
+#define SEEK_BYTES (SEEK_READS_PER_ITER * SEEK_READ_BYTES)
+
+static const bench_case_t cases[] = {
+    {"seek.chain.1mb", 200, SEEK_BYTES, setup, run_chain_1mb, teardown},
+    {"seek.chain.4mb", 200, SEEK_BYTES, setup, run_chain_4mb, teardown},
+    {"seek.chain.16mb", 200, SEEK_BYTES, setup, run_chain_16mb, teardown},
+    {"seek.clmt.1mb", 200, SEEK_BYTES, setup, run_clmt_1mb, teardown},
+    {"seek.clmt.4mb", 200, SEEK_BYTES, setup, run_clmt_4mb, teardown},
+    {"seek.clmt.16mb", 200, SEEK_BYTES, setup, run_clmt_16mb, teardown},
+};
+
+int bench_seek_register(void)
+{
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+    {
+        if (bench_add(&cases[i]) != 0)
+            return -1;
+    }
+    return 0;
+}
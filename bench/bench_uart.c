@@ -0,0 +1,131 @@
+/**
+ * UART protocol round trip through a pty: the host side sends an 'I' request (command
+ * byte + 3072 image bytes) and waits for the 12-byte {label, distance, tflite_label}
+ * reply, framed as in main.cc. A device thread on the other end answers it; with
+ * BENCH_MODEL it classifies the image with the model, otherwise it only checksums it,
+ * so the case measures the transport and framing.
+ */
+#define _DEFAULT_SOURCE
+
+#include <pthread.h>
+#include <pty.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "crc32.h"
+
+#define UART_CMD_IMAGE 'I'
+#define UART_CMD_QUIT 0 /* bench only: stops the device thread */
+#define UART_IMAGE_BYTES (32 * 32 * 3)
+
+typedef struct __attribute__((packed))
+{
+    int32_t label;
+    float distance;
+    int32_t tflite_label;
+} uart_image_resp_t;
+
+static int host_fd = -1, device_fd = -1;
+static pthread_t device_thread;
+static uint8_t request[1 + UART_IMAGE_BYTES];
+
+static int read_full(int fd, void *buf, size_t len)
+{
+    uint8_t *p = (uint8_t *)buf;
+    while (len > 0)
+    {
+        ssize_t n = read(fd, p, len);
+        if (n <= 0)
+            return -1;
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+static int write_full(int fd, const void *buf, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)buf;
+    while (len > 0)
+    {
+        ssize_t n = write(fd, p, len);
+        if (n <= 0)
+            return -1;
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+static void *device_main(void *arg)
+{
+    (void)arg;
+    static uint8_t image[UART_IMAGE_BYTES];
+    uint8_t cmd;
+    while (read_full(device_fd, &cmd, 1) == 0 && cmd == UART_CMD_IMAGE)
+    {
+        if (read_full(device_fd, image, sizeof(image)) != 0)
+            break;
+        uart_image_resp_t resp;
+#ifdef BENCH_MODEL
+        resp.tflite_label = bench_model_predict(image);
+#else
+        resp.tflite_label = (int32_t)(crc32_update(0, image, sizeof(image)) % 10u);
+#endif
+        resp.label = resp.tflite_label;
+        resp.distance = 0.0f;
+        if (write_full(device_fd, &resp, sizeof(resp)) != 0)
+            break;
+    }
+    return NULL;
+}
+
+static int setup(void)
+{
+    struct termios raw;
+    if (openpty(&host_fd, &device_fd, NULL, NULL, NULL) != 0)
+        return -1;
+    if (tcgetattr(device_fd, &raw) == 0)
+    {
+        cfmakeraw(&raw);
+        tcsetattr(device_fd, TCSANOW, &raw);
+        tcsetattr(host_fd, TCSANOW, &raw);
+    }
+    request[0] = UART_CMD_IMAGE;
+    for (int i = 0; i < UART_IMAGE_BYTES; i++)
+        request[1 + i] = (uint8_t)(i * 7);
+    if (pthread_create(&device_thread, NULL, device_main, NULL) != 0)
+    {
+        close(host_fd);
+        close(device_fd);
+        return -1;
+    }
+    return 0;
+}
+
+static void teardown(void)
+{
+    uint8_t quit = UART_CMD_QUIT;
+    write_full(host_fd, &quit, 1);
+    pthread_join(device_thread, NULL);
+    close(host_fd);
+    close(device_fd);
+}
+
+static int run_round_trip(void)
+{
+    uart_image_resp_t resp;
+    if (write_full(host_fd, request, sizeof(request)) != 0 || read_full(host_fd, &resp, sizeof(resp)) != 0)
+        return -1;
+    return (resp.tflite_label >= 0) ? 0 : -1;
+}
+
+static const bench_case_t round_trip = {"uart.image_round_trip", 500, sizeof(request), setup, run_round_trip,
+                                        teardown};
+
+int bench_uart_register(void)
+{
+    return bench_add(&round_trip);
+}
@@ -0,0 +1,97 @@
+/**
+ * Test-set evaluation on the host (src/eval.cc, the code behind the firmware's EVAL=1).
+ *
+ *     eval_host [-n max_images] sdcard.img | test.ids
+ *
+ * A .img argument is taken as a raw image of the SD card (FAT/exFAT, EVAL_SD_PATH at the
+ * root). Any other file is the packed test set itself (python_scripts/pack_images.py): it
+ * is copied to a fresh RAM disk as EVAL_SD_PATH first. Accuracy matches the device (same model, same
+ * preprocessing); latencies are host times.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "eval.h"
+#include "ff.h"
+#include "model/model_inference.h"
+#include "profiler.h"
+#include "ramdisk.h"
+
+#define EVAL_DISK_SECTORS 131072 /* 64 MB, room for the packed test set (31 MB) */
+
+static FATFS fs;
+
+static int has_suffix(const char *s, const char *suffix)
+{
+    size_t n = strlen(s), m = strlen(suffix);
+    return n >= m && strcmp(s + n - m, suffix) == 0;
+}
+
+/* Format a RAM disk and copy the packed test set to it as EVAL_SD_PATH */
+static int import_dataset(const char *path)
+{
+    static BYTE work[FF_MAX_SS * 8];
+    static uint8_t buf[64 * 1024];
+    const MKFS_PARM opt = {FM_EXFAT, 0, 0, 0, 0};
+    if (ramdisk_init(EVAL_DISK_SECTORS) != 0 || f_mkfs("", &opt, work, sizeof(work)) != FR_OK ||
+        f_mount(&fs, "", 1) != FR_OK)
+        return -1;
+    FILE *in = fopen(path, "rb");
+    if (in == NULL)
+        return -1;
+    FIL out;
+    int status = (f_open(&out, EVAL_SD_PATH, FA_WRITE | FA_CREATE_ALWAYS) == FR_OK) ? 0 : -1;
+    size_t n;
+    while (status == 0 && (n = fread(buf, 1, sizeof(buf), in)) > 0)
+    {
+        UINT written;
+        if (f_write(&out, buf, (UINT)n, &written) != FR_OK || written != n)
+            status = -1;
+    }
+    fclose(in);
+    if (f_close(&out) != FR_OK)
+        status = -1;
+    return status;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t max_images = 0;
+    const char *path = nullptr;
+    int usage = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+            max_images = (uint32_t)atoi(argv[++i]);
+        else if (path == nullptr)
+            path = argv[i];
+        else
+            usage = 1;
+    }
+    if (path == nullptr || usage)
+    {
+        fprintf(stderr, "usage: %s [-n max_images] sdcard.img | test.ids\n", argv[0]);
+        return 2;
+    }
+
+    int ready = has_suffix(path, ".img") ? (ramdisk_load(path) == 0 && f_mount(&fs, "", 1) == FR_OK ? 0 : -1)
+                                         : import_dataset(path);
+    if (ready != 0)
+    {
+        fprintf(stderr, "cannot load %s\n", path);
+        return 1;
+    }
+    if (model_init() != 0)
+    {
+        fprintf(stderr, "model init failed\n");
+        return 1;
+    }
+
+    static eval_result_t result;
+    profiler_reset();
+    if (eval_run(EVAL_SD_PATH, max_images, nullptr, &result) != 0)
+        return 1;
+    eval_report(&result);
+    return 0;
+}
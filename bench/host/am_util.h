@@ -0,0 +1,17 @@
+/**
+ * Host stand-in for the AmbiqSuite utilities the model sources use (bench_model.cc builds).
+ */
+#ifndef BENCH_HOST_AM_UTIL_H
+#define BENCH_HOST_AM_UTIL_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define am_util_stdio_printf printf
+
+static inline void am_hal_delay_us(uint32_t us)
+{
+    (void)us;
+}
+
+#endif /* BENCH_HOST_AM_UTIL_H */
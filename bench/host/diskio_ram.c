@@ -0,0 +1,108 @@
+/**
+ * FatFs disk I/O for the host benchmarks: drives are RAM disks (replaces
+ * ff16/source/diskio.c, which talks to the SD card over SPI). Transfers are plain
+ * memcpy, so the FatFs cases measure the file system's own CPU cost.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ff.h"
+#include "diskio.h"
+#include "ramdisk.h"
+
+#define RAMDISK_SECTOR_SIZE 512
+
+static BYTE *disks[RAMDISK_DRIVES];
+static LBA_t disk_sectors[RAMDISK_DRIVES];
+
+int ramdisk_init_drive(uint8_t pdrv, uint32_t sectors)
+{
+    if (pdrv >= RAMDISK_DRIVES)
+        return -1;
+    free(disks[pdrv]);
+    disks[pdrv] = (BYTE *)calloc(sectors, RAMDISK_SECTOR_SIZE);
+    disk_sectors[pdrv] = disks[pdrv] ? sectors : 0;
+    return disks[pdrv] ? 0 : -1;
+}
+
+int ramdisk_init(uint32_t sectors)
+{
+    return ramdisk_init_drive(0, sectors);
+}
+
+int ramdisk_load(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL)
+        return -1;
+    int status = -1;
+    if (fseek(f, 0, SEEK_END) == 0)
+    {
+        long size = ftell(f);
+        rewind(f);
+        if (size >= RAMDISK_SECTOR_SIZE && ramdisk_init((uint32_t)(size / RAMDISK_SECTOR_SIZE)) == 0 &&
+            fread(disks[0], RAMDISK_SECTOR_SIZE, disk_sectors[0], f) == disk_sectors[0])
+            status = 0;
+    }
+    fclose(f);
+    return status;
+}
+
+DSTATUS disk_status(BYTE pdrv)
+{
+    return (pdrv < RAMDISK_DRIVES && disks[pdrv] != NULL) ? 0 : STA_NOINIT;
+}
+
+DSTATUS disk_initialize(BYTE pdrv)
+{
+    return disk_status(pdrv);
+}
+
+DRESULT disk_read(BYTE pdrv, BYTE *buff, LBA_t sector, UINT count)
+{
+    if (disk_status(pdrv) != 0)
+        return RES_NOTRDY;
+    if (sector + count > disk_sectors[pdrv])
+        return RES_PARERR;
+    memcpy(buff, disks[pdrv] + (size_t)sector * RAMDISK_SECTOR_SIZE, (size_t)count * RAMDISK_SECTOR_SIZE);
+    return RES_OK;
+}
+
+DRESULT disk_write(BYTE pdrv, const BYTE *buff, LBA_t sector, UINT count)
+{
+    if (disk_status(pdrv) != 0)
+        return RES_NOTRDY;
+    if (sector + count > disk_sectors[pdrv])
+        return RES_PARERR;
+    memcpy(disks[pdrv] + (size_t)sector * RAMDISK_SECTOR_SIZE, buff, (size_t)count * RAMDISK_SECTOR_SIZE);
+    return RES_OK;
+}
+
+DRESULT disk_ioctl(BYTE pdrv, BYTE cmd, void *buff)
+{
+    if (disk_status(pdrv) != 0)
+        return RES_NOTRDY;
+    switch (cmd)
+    {
+    case CTRL_SYNC:
+        return RES_OK;
+    case GET_SECTOR_COUNT:
+        *(LBA_t *)buff = disk_sectors[pdrv];
+        return RES_OK;
+    case GET_SECTOR_SIZE:
+        *(WORD *)buff = RAMDISK_SECTOR_SIZE;
+        return RES_OK;
+    case GET_BLOCK_SIZE:
+        *(DWORD *)buff = 1;
+        return RES_OK;
+    default:
+        return RES_PARERR;
+    }
+}
+
+DWORD get_fattime(void)
+{
+    /* 2025-01-01 00:00:00: fixed so the volume is identical between runs */
+    return ((DWORD)(2025 - 1980) << 25) | ((DWORD)1 << 21) | ((DWORD)1 << 16);
+}
@@ -0,0 +1,29 @@
+/**
+ * RAM disks behind the disk I/O layer on the host (diskio_ram.c): drive 0 holds the
+ * FatFs volume, further drives are only read through disk_read() (e.g. rawpart.h).
+ */
+#ifndef RAMDISK_H
+#define RAMDISK_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RAMDISK_DRIVES 2
+
+/** (Re)create drive 0 as a zeroed disk of sectors x 512 bytes. Returns 0 on success. */
+int ramdisk_init(uint32_t sectors);
+
+/** Same for drive pdrv (< RAMDISK_DRIVES). */
+int ramdisk_init_drive(uint8_t pdrv, uint32_t sectors);
+
+/** Replace drive 0 with the contents of an image file (e.g. dd of an SD card). Returns 0 on success. */
+int ramdisk_load(const char *path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RAMDISK_H */
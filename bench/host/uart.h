@@ -0,0 +1,7 @@
+/**
+ * Host stand-in for src/peripherals/uart.h, which ff16/source/ff.h includes; FatFs uses
+ * nothing from it.
+ */
+#ifndef BENCH_HOST_UART_H
+#define BENCH_HOST_UART_H
+#endif
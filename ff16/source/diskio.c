@@ -14,6 +14,8 @@
 #include "spi.h"
 #include "uart.h"
 #include "am_hal_rtc.h"
+#include "perf_mode.h"
+#include "profiler.h"
 
 void *phSPI_ = NULL;
 
@@ -129,11 +131,15 @@ DRESULT disk_read (
 
 	uint32_t block_num = (uint32_t)sector;
 	uint32_t status;
+	perf_mode_io_begin();	/* SPI wait: back to 96 MHz inside bursts */
+	PROFILE_BEGIN("sd.read");
 	if (count == 1) {
 		status = sd_spi_read_single_block(phSPI_, block_num, buff, 512);
 	} else {
 		status = sd_spi_read_multi_block(phSPI_, block_num, count, buff, count * 512);
 	}
+	PROFILE_END("sd.read");
+	perf_mode_io_end();
 	if (status != AM_HAL_STATUS_SUCCESS) {
 		res = RES_ERROR;
 	}
@@ -191,11 +197,15 @@ DRESULT disk_write (
 	
 	uint32_t block_num = (uint32_t)sector;
 	uint32_t status;
+	perf_mode_io_begin();
+	PROFILE_BEGIN("sd.write");
 	if (count == 1) {
 		status = sd_spi_write_single_block(phSPI_, block_num, buff, 512);
 	} else {
 		status = sd_spi_write_multi_block(phSPI_, block_num, count, buff, count * 512);
 	}
+	PROFILE_END("sd.write");
+	perf_mode_io_end();
 	if (status != AM_HAL_STATUS_SUCCESS) {
 		res = RES_ERROR;
 	}
@@ -0,0 +1,121 @@
+#!/usr/bin/env python3
+"""
+Compare host benchmark results (bench/, `make -C bench run`) with a stored baseline and
+fail on regressions.
+
+Baseline medians are first scaled by how fast the reference case (ref.cpu, fixed CPU
+work run with every suite) ran this time, to cancel machine-wide drift. A case then
+regresses when its median exceeds the scaled baseline by more than the larger of
+  - --min-rel of the baseline median (run-to-run drift of the machine), and
+  - --k standard deviations, estimated from the larger MAD of the two runs
+    (1.4826 x MAD; the spread within a run).
+Faster cases are reported but never fail. Cases missing from the results (e.g. the model
+cases in a build without TFLM) are listed and skipped; new cases are listed. --require
+makes a baseline without cases of that prefix an error (make -C bench check passes
+--require model. when TFLM_LIB is set), so new cases can't go ungated.
+
+Usage:
+    python bench_compare.py bench/build/results.json bench/baselines/host.json
+    python bench_compare.py results.json baseline.json --min-rel 0.1 --k 4 --no-normalize
+    python bench_compare.py results.json bench/baselines/host-tflm.json --require model.
+Exit status: 0 if nothing regressed, 1 on regressions, 2 on unreadable input or a baseline
+missing required cases.
+"""
+
+import argparse
+import json
+import sys
+
+MAD_TO_SIGMA = 1.4826
+REFERENCE_CASE = 'ref.cpu'  # BENCH_REFERENCE_CASE in bench/bench.h
+
+
+def load_cases(path):
+    """{case name: result dict} of a bench_host JSON file."""
+    with open(path) as f:
+        data = json.load(f)
+    return {case['name']: case for case in data.get('cases', [])}
+
+
+def allowed_increase(expected, base, cur, min_rel, k, scale):
+    """Largest median increase (ns) over expected still counted as noise."""
+    sigma = MAD_TO_SIGMA * max(base.get('mad', 0) * scale, cur.get('mad', 0))
+    return max(min_rel * expected, k * sigma)
+
+
+def machine_scale(results, baseline):
+    """Reference case time now / in the baseline (1.0 if either lacks it)."""
+    cur, base = results.get(REFERENCE_CASE), baseline.get(REFERENCE_CASE)
+    if cur is None or base is None or base['median'] <= 0:
+        return 1.0
+    return cur['median'] / base['median']
+
+
+def compare(results, baseline, min_rel, k, scale):
+    """Print a table; returns the names of regressed cases."""
+    regressed = []
+    print(f"machine speed vs baseline: x{1.0 / scale:.2f} (baseline scaled by {scale:.3f})\n")
+    print(f"{'case':<24} {'base ns':>12} {'now ns':>12} {'change':>8} {'limit':>8}  verdict")
+    for name in sorted(set(baseline) | set(results)):
+        base, cur = baseline.get(name), results.get(name)
+        if name == REFERENCE_CASE:
+            continue
+        if base is None:
+            print(f"{name:<24} {'-':>12} {cur['median']:>12} {'':>8} {'':>8}  new")
+            continue
+        if cur is None:
+            print(f"{name:<24} {base['median']:>12} {'-':>12} {'':>8} {'':>8}  not run")
+            continue
+        expected = base['median'] * scale
+        delta = cur['median'] - expected
+        limit = allowed_increase(expected, base, cur, min_rel, k, scale)
+        change = 100.0 * delta / expected if expected else 0.0
+        limit_pct = 100.0 * limit / expected if expected else 0.0
+        if delta > limit:
+            verdict = 'REGRESSION'
+            regressed.append(name)
+        elif -delta > limit:
+            verdict = 'faster'
+        else:
+            verdict = 'ok'
+        print(f"{name:<24} {base['median']:>12} {cur['median']:>12} {change:>+7.1f}% {limit_pct:>7.1f}%  {verdict}")
+    return regressed
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Gate host benchmark results against a baseline")
+    parser.add_argument('results', help="bench_host JSON output")
+    parser.add_argument('baseline', help="stored baseline (bench/baselines/*.json)")
+    parser.add_argument('--min-rel', type=float, default=0.25,
+                        help="relative median increase always tolerated (default 0.25)")
+    parser.add_argument('--k', type=float, default=3.0,
+                        help="tolerated increase in standard deviations (default 3)")
+    parser.add_argument('--no-normalize', action='store_true',
+                        help="compare raw medians (don't scale by the reference case)")
+    parser.add_argument('--require', action='append', default=[], metavar='PREFIX',
+                        help="fail unless the baseline has cases whose name starts with PREFIX")
+    args = parser.parse_args()
+
+    try:
+        results = load_cases(args.results)
+        baseline = load_cases(args.baseline)
+    except (OSError, ValueError, KeyError) as e:
+        print(f"error: {e}", file=sys.stderr)
+        return 2
+    missing = [prefix for prefix in args.require if not any(name.startswith(prefix) for name in baseline)]
+    if missing:
+        print(f"error: {args.baseline} has no {', '.join(p + '*' for p in missing)} cases; "
+              "record them with make -C bench baseline (same TFLM_LIB)", file=sys.stderr)
+        return 2
+
+    scale = 1.0 if args.no_normalize else machine_scale(results, baseline)
+    regressed = compare(results, baseline, args.min_rel, args.k, scale)
+    if regressed:
+        print(f"\n{len(regressed)} regression(s): {', '.join(regressed)}")
+        return 1
+    print("\nno regressions")
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
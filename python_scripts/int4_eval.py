@@ -0,0 +1,148 @@
+#!/usr/bin/env python3
+"""
+Accuracy / latency comparison of an int8 model and its int4 conversion on the CIFAR-10
+test set.
+
+Host: runs the int8 model and the --simulate output of quantize_int4.py (same arithmetic
+as the device int4 kernels) on the TFLite interpreter and reports top-1 accuracy and
+agreement.
+
+Device (--port, make UART_TEST=1 build): hot-swaps the int8 and then the int4 model onto
+the board in one session (each update is staged in the loader slot the running model is not
+in, so no reboot is needed in between), sends the images pre-quantized ('Q' queries) and
+reports on-device accuracy, agreement with the host and the mean round trip. The two models
+end up in different slots (SRAM and MRAM weights), so compare Invoke() cycles from the
+PROFILING boot benchmark (put the int4 model.bin on the SD card), not the round trips.
+
+Usage:
+    python int4_eval.py model.tflite model_int4_sim.tflite [--count 1000]
+    python int4_eval.py model.tflite model_int4_sim.tflite --port /dev/cu.usbmodem* \\
+        --device-int4 model_int4.tflite [--count 200]
+Requires: tensorflow, numpy (and pyserial for --port)
+"""
+
+import argparse
+import pickle
+import struct
+import time
+
+import numpy as np
+import tensorflow as tf
+
+from extract_cifar10_image import download_cifar10_test
+
+IMAGENET_MEAN = np.array([0.485, 0.456, 0.406], dtype=np.float32)
+IMAGENET_STD = np.array([0.229, 0.224, 0.225], dtype=np.float32)
+
+CMD_INPUT_INFO = b'H'
+CMD_IMAGE_INT8 = b'Q'
+INPUT_INFO_FORMAT = '<ifi4iiI3f3f'  # type, scale, zero_point, dims, layout, bytes, mean, std
+LAYOUT_NHWC = 1
+
+
+def load_test_set(count):
+    with open(download_cifar10_test(), 'rb') as f:
+        batch = pickle.load(f, encoding='bytes')
+    images = batch[b'data'][:count].reshape(-1, 3, 32, 32).transpose(0, 2, 3, 1)  # HWC uint8
+    labels = np.array(batch[b'labels'][:count])
+    return images, labels
+
+
+class HostModel:
+    """Same normalization as model_io.h, in the model's input layout and type."""
+
+    def __init__(self, path):
+        self.interpreter = tf.lite.Interpreter(model_path=path)
+        self.interpreter.allocate_tensors()
+        self.input = self.interpreter.get_input_details()[0]
+        self.output = self.interpreter.get_output_details()[0]
+        self.nchw = self.input['shape'][1] == 3
+
+    def input_tensor(self, image):
+        x = (image.astype(np.float32) / 255.0 - IMAGENET_MEAN) / IMAGENET_STD
+        if self.nchw:
+            x = x.transpose(2, 0, 1)
+        if self.input['dtype'] == np.int8:
+            scale, zero_point = self.input['quantization']
+            x = np.clip(np.round(x / scale) + zero_point, -128, 127).astype(np.int8)
+        return x[np.newaxis].astype(self.input['dtype'])
+
+    def predict(self, image):
+        self.interpreter.set_tensor(self.input['index'], self.input_tensor(image))
+        self.interpreter.invoke()
+        return int(np.argmax(self.interpreter.get_tensor(self.output['index'])[0]))
+
+
+def evaluate_host(path, images, labels):
+    model = HostModel(path)
+    preds = np.array([model.predict(img) for img in images])
+    return preds, float(np.mean(preds == labels))
+
+
+def evaluate_device(port, path, images, labels):
+    from uart_update_model import read_reply, update_model
+
+    with open(path, 'rb') as f:
+        update_model(port, f.read())
+    port.write(CMD_INPUT_INFO)
+    if not read_reply(port):
+        raise RuntimeError("no input info from board")
+    info = struct.unpack(INPUT_INFO_FORMAT, port.read(struct.calcsize(INPUT_INFO_FORMAT)))
+    dtype, scale, zero_point = info[0:3]
+    layout, mean, std = info[7], np.array(info[9:12]), np.array(info[12:15])
+    if dtype != 9:
+        raise RuntimeError("board model does not take int8 input")
+
+    def board_input(image):
+        """The swapped-in model's own normalization, quantization and layout."""
+        x = (image.astype(np.float32) / 255.0 - mean) / std
+        if layout != LAYOUT_NHWC:
+            x = x.transpose(2, 0, 1)
+        return np.clip(np.round(x / scale) + zero_point, -128, 127).astype(np.int8)
+
+    preds = []
+    start = time.time()
+    for img in images:
+        port.write(CMD_IMAGE_INT8 + board_input(img).tobytes())
+        _, _, tflite_label = struct.unpack('<ifi', port.read(12))
+        preds.append(tflite_label)
+    per_query_ms = 1000.0 * (time.time() - start) / len(images)
+    preds = np.array(preds)
+    return preds, float(np.mean(preds == labels)), per_query_ms
+
+
+def main():
+    parser = argparse.ArgumentParser(description='int8 vs int4 accuracy/latency on CIFAR-10')
+    parser.add_argument('int8_model')
+    parser.add_argument('int4_sim_model', help='quantize_int4.py --simulate output')
+    parser.add_argument('--count', type=int, default=10000, help='test images to use')
+    parser.add_argument('--port', help='serial port of a UART_TEST=1 board')
+    parser.add_argument('--device-int4', help='int4 model (custom ops) to run on the board')
+    parser.add_argument('--baud', type=int, default=115200)
+    args = parser.parse_args()
+
+    images, labels = load_test_set(args.count)
+    print(f"{len(images)} CIFAR-10 test images")
+
+    int8_preds, int8_acc = evaluate_host(args.int8_model, images, labels)
+    int4_preds, int4_acc = evaluate_host(args.int4_sim_model, images, labels)
+    print(f"Host int8: {int8_acc:.2%}")
+    print(f"Host int4: {int4_acc:.2%} ({100 * (int4_acc - int8_acc):+.2f} pts, "
+          f"{np.mean(int4_preds == int8_preds):.2%} agree with int8)")
+
+    if args.port is None:
+        return
+    import serial
+
+    runs = [('int8', args.int8_model, int8_preds)]
+    if args.device_int4:
+        runs.append(('int4', args.device_int4, int4_preds))
+    with serial.Serial(args.port, args.baud, timeout=10) as port:
+        for name, path, host_preds in runs:
+            preds, acc, ms = evaluate_device(port, path, images, labels)
+            print(f"Device {name}: {acc:.2%}, {np.mean(preds == host_preds):.2%} match host, "
+                  f"{ms:.1f} ms/query (incl. UART)")
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,164 @@
+#!/usr/bin/env python3
+"""
+Build the cascade gate classifier (make CASCADE=1, src/model/model_cascade.h).
+
+Trains a small CNN on CIFAR-10 with the device preprocessing (model_io.h: /255, ImageNet
+mean/std, NHWC), converts it to a full-integer int8 .tflite (int8 input, int8 softmax
+output) and optionally writes it as src/model/gate_model_data.cc. It only uses ops the
+gate resolver registers (Conv2D, DepthwiseConv2D, pooling, Reshape, FullyConnected,
+Softmax).
+
+From the repo root (make CASCADE=1 runs both steps when the files are missing):
+    python python_scripts/make_gate_model.py -o gate_int8.tflite [--epochs 30]
+    python python_scripts/make_gate_model.py --from gate_int8.tflite --cc src/model/gate_model_data.cc
+Requires: tensorflow, numpy (training only; --from needs neither)
+"""
+
+import argparse
+import math
+import os
+import pickle
+
+IMAGENET_MEAN = (0.485, 0.456, 0.406)
+IMAGENET_STD = (0.229, 0.224, 0.225)
+REPRESENTATIVE_IMAGES = 500
+
+
+def load_cifar10():
+    from extract_cifar10_image import download_cifar10_test
+    import numpy as np
+
+    test_file = download_cifar10_test()  # also extracts data_batch_1..5
+    base = os.path.dirname(test_file)
+
+    def load(names):
+        images, labels = [], []
+        for name in names:
+            with open(os.path.join(base, name), 'rb') as f:
+                batch = pickle.load(f, encoding='bytes')
+            images.append(batch[b'data'].reshape(-1, 3, 32, 32).transpose(0, 2, 3, 1))
+            labels += batch[b'labels']
+        return np.concatenate(images), np.array(labels)
+
+    train = load([f'data_batch_{i}' for i in range(1, 6)])
+    test = load(['test_batch'])
+    return train, test
+
+
+def normalize(images):
+    import numpy as np
+    x = images.astype(np.float32) / 255.0
+    return (x - np.array(IMAGENET_MEAN, np.float32)) / np.array(IMAGENET_STD, np.float32)
+
+
+def build_model():
+    import tensorflow as tf
+    layers = tf.keras.layers
+
+    def separable(x, filters, stride):
+        x = layers.DepthwiseConv2D(3, strides=stride, padding='same', use_bias=False)(x)
+        x = layers.BatchNormalization()(x)
+        x = layers.ReLU()(x)
+        x = layers.Conv2D(filters, 1, use_bias=False)(x)
+        x = layers.BatchNormalization()(x)
+        return layers.ReLU()(x)
+
+    inputs = tf.keras.Input((32, 32, 3))
+    x = layers.Conv2D(16, 3, strides=2, padding='same', use_bias=False)(inputs)  # 16x16
+    x = layers.BatchNormalization()(x)
+    x = layers.ReLU()(x)
+    x = separable(x, 32, 1)
+    x = separable(x, 64, 2)  # 8x8
+    x = separable(x, 64, 1)
+    x = separable(x, 128, 2)  # 4x4
+    x = layers.AveragePooling2D(4)(x)  # AVERAGE_POOL_2D, not MEAN
+    x = layers.Flatten()(x)
+    x = layers.Dense(10)(x)
+    outputs = layers.Softmax()(x)
+    return tf.keras.Model(inputs, outputs)
+
+
+def train(epochs):
+    import tensorflow as tf
+
+    (x_train, y_train), (x_test, y_test) = load_cifar10()
+    x_train, x_test = normalize(x_train), normalize(x_test)
+
+    model = build_model()
+    model.compile(optimizer=tf.keras.optimizers.Adam(2e-3),
+                  loss='sparse_categorical_crossentropy', metrics=['accuracy'])
+    augment = tf.keras.Sequential([tf.keras.layers.RandomFlip('horizontal'),
+                                   tf.keras.layers.RandomTranslation(0.1, 0.1)])
+    data = (tf.data.Dataset.from_tensor_slices((x_train, y_train)).shuffle(10000).batch(128)
+            .map(lambda x, y: (augment(x, training=True), y)).prefetch(2))
+    schedule = tf.keras.callbacks.LearningRateScheduler(
+        lambda epoch: 1e-3 * (1 + math.cos(math.pi * epoch / epochs)))
+    model.fit(data, epochs=epochs, validation_data=(x_test, y_test), callbacks=[schedule], verbose=2)
+
+    def representative():
+        for image in x_train[:REPRESENTATIVE_IMAGES]:
+            yield [image[None]]
+
+    converter = tf.lite.TFLiteConverter.from_keras_model(model)
+    converter.optimizations = [tf.lite.Optimize.DEFAULT]
+    converter.representative_dataset = representative
+    converter.target_spec.supported_ops = [tf.lite.OpsSet.TFLITE_BUILTINS_INT8]
+    converter.inference_input_type = tf.int8
+    converter.inference_output_type = tf.int8
+    tflite = converter.convert()
+
+    interpreter = tf.lite.Interpreter(model_content=tflite)
+    interpreter.allocate_tensors()
+    inp = interpreter.get_input_details()[0]
+    out = interpreter.get_output_details()[0]
+    scale, zero_point = inp['quantization']
+    correct = 0
+    for image, label in zip(x_test, y_test):
+        q = (image / scale + zero_point).round().clip(-128, 127).astype('int8')
+        interpreter.set_tensor(inp['index'], q[None])
+        interpreter.invoke()
+        correct += int(interpreter.get_tensor(out['index'])[0].argmax() == label)
+    print(f"int8 gate: {len(tflite)} bytes, test accuracy {correct / len(y_test):.4f}")
+    return tflite
+
+
+def write_cc(tflite, path):
+    lines = ['// Cascade gate classifier, generated by python_scripts/make_gate_model.py',
+             '#include "gate_model_data.h"',
+             'alignas(16) const unsigned char g_gate_model_data[] = {']
+    for i in range(0, len(tflite), 12):
+        row = ', '.join(f'0x{b:02x}' for b in tflite[i:i + 12])
+        lines.append(f'    {row},' if i + 12 < len(tflite) else f'    {row}}};')
+    lines.append(f'const unsigned int g_gate_model_data_len = {len(tflite)};')
+    with open(path, 'w') as f:
+        f.write('\n'.join(lines) + '\n')
+    print(f"Wrote {path}: {len(tflite)} bytes")
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Cascade gate classifier')
+    parser.add_argument('-o', '--output', help='write the int8 .tflite here')
+    parser.add_argument('--from', dest='source', help='use this .tflite instead of training')
+    parser.add_argument('--cc', help='write the model as a C array (gate_model_data.cc)')
+    parser.add_argument('--epochs', type=int, default=30)
+    args = parser.parse_args()
+    if not args.output and not args.cc:
+        parser.error('nothing to write: give -o and/or --cc')
+
+    if args.source:
+        with open(args.source, 'rb') as f:
+            tflite = f.read()
+        if tflite[4:8] != b'TFL3':
+            raise SystemExit(f"{args.source} is not a TFLite flatbuffer")
+    else:
+        tflite = train(args.epochs)
+    if args.output:
+        with open(args.output, 'wb') as f:
+            f.write(tflite)
+        print(f"Wrote {args.output}")
+    if args.cc:
+        write_cc(tflite, args.cc)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,170 @@
+#!/usr/bin/env python3
+"""
+Build an SD card image with a FAT volume and a raw data partition (see src/utils/rawpart.h).
+
+Layout: MBR; partition 1 (type 0x07, exFAT) at 1 MiB for config, model.bin and logs;
+partition 2 (type 0xDA) right after it, 1 MiB aligned. Sector 0 of partition 2 is the
+superblock (magic "RAW1", extent count, partition sectors, CRC-32 of the extent table,
+then up to 15 extents of name[16], start, sectors, bytes, crc32); each extent's data
+starts on an --align sector boundary.
+
+Partition 1 is copied from --fat-image (e.g. made with mkfs.exfat / mformat on a file)
+or left zeroed: then format it in place, giving its size in KiB so the raw partition
+is left alone, e.g. for --fat-mb 32:
+    mkfs.fat --offset 2048 sd.img 32768
+The firmware mounts the FAT volume as before and finds partition 2 by its type. Write
+the result to the card with dd (or balenaEtcher).
+
+Usage:
+    python make_sd_image.py -o sd.img --fat-mb 32 --extent images=images.ids
+    python make_sd_image.py -o sd.img --fat-image fat.img --extent images=images.ids --size-mb 1024
+    python make_sd_image.py --list sd.img
+"""
+
+import argparse
+import struct
+import sys
+import zlib
+
+SECTOR = 512
+PART_ALIGN = 2048  # sectors (1 MiB)
+FAT_TYPE = 0x07
+RAW_TYPE = 0xDA
+RAW_MAGIC = b'RAW1'
+MAX_EXTENTS = 15
+NAME_LEN = 16
+SUPERBLOCK = struct.Struct('<4sIII')
+EXTENT = struct.Struct('<16sIIII')
+
+
+def round_up(n, to):
+    return (n + to - 1) // to * to
+
+
+def mbr(partitions):
+    """Sector 0: four partition entries ((type, first LBA, sectors) or None) + signature."""
+    data = bytearray(SECTOR)
+    for i, part in enumerate(partitions):
+        if part is None:
+            continue
+        ptype, lba, sectors = part
+        # CHS fields unused (0xFE/0xFF/0xFF: "use LBA")
+        entry = struct.pack('<B3sB3sII', 0, b'\xfe\xff\xff', ptype, b'\xfe\xff\xff', lba, sectors)
+        data[446 + 16 * i:446 + 16 * (i + 1)] = entry
+    data[510:512] = b'\x55\xaa'
+    return bytes(data)
+
+
+def superblock(extents, sectors):
+    table = b''.join(EXTENT.pack(name.encode().ljust(NAME_LEN, b'\0'), start, count, len(data),
+                                 zlib.crc32(data) & 0xFFFFFFFF)
+                     for name, start, count, data in extents)
+    header = SUPERBLOCK.pack(RAW_MAGIC, len(extents), sectors, zlib.crc32(table) & 0xFFFFFFFF)
+    return (header + table).ljust(SECTOR, b'\0')
+
+
+def build(args):
+    extents = []
+    for spec in args.extent:
+        name, sep, path = spec.partition('=')
+        if not sep or not name or len(name.encode()) > NAME_LEN:
+            raise ValueError(f"bad --extent {spec} (want name=file, name up to {NAME_LEN} bytes)")
+        with open(path, 'rb') as f:
+            extents.append((name, f.read()))
+    if len(extents) > MAX_EXTENTS:
+        raise ValueError(f"at most {MAX_EXTENTS} extents")
+
+    fat = b''
+    if args.fat_image:
+        with open(args.fat_image, 'rb') as f:
+            fat = f.read()
+    fat_bytes = len(fat) if fat else args.fat_mb * 1024 * 1024
+    fat_sectors = round_up(round_up(fat_bytes, SECTOR) // SECTOR, PART_ALIGN)
+    fat_lba = PART_ALIGN
+    raw_lba = fat_lba + fat_sectors
+
+    # Superblock, then each extent on an align boundary
+    placed, next_sector = [], args.align
+    for name, data in extents:
+        count = round_up(max(len(data), 1), SECTOR) // SECTOR
+        placed.append((name, next_sector, count, data))
+        next_sector = round_up(next_sector + count, args.align)
+    raw_sectors = next_sector
+    if args.size_mb:
+        total = args.size_mb * 1024 * 1024 // SECTOR
+        if total < raw_lba + raw_sectors:
+            raise ValueError(f"--size-mb {args.size_mb} is too small ({(raw_lba + raw_sectors) * SECTOR} bytes needed)")
+        raw_sectors = total - raw_lba  # the raw partition takes the rest of the card
+
+    with open(args.output, 'wb') as f:
+        f.write(mbr([(FAT_TYPE, fat_lba, fat_sectors), (RAW_TYPE, raw_lba, raw_sectors), None, None]))
+        f.seek(fat_lba * SECTOR)
+        f.write(fat)
+        f.seek(raw_lba * SECTOR)
+        f.write(superblock(placed, raw_sectors))
+        for _, start, _, data in placed:
+            f.seek((raw_lba + start) * SECTOR)
+            f.write(data)
+        f.truncate((raw_lba + raw_sectors) * SECTOR)
+
+    print(f"Wrote {args.output}: FAT partition LBA {fat_lba} ({fat_sectors} sectors{'' if fat else ', unformatted'}), "
+          f"raw partition LBA {raw_lba} ({raw_sectors} sectors)")
+    for name, start, count, data in placed:
+        print(f"  {name:<16} sector {start:>8}  {len(data):>10} bytes")
+
+
+def list_image(path):
+    with open(path, 'rb') as f:
+        table = f.read(SECTOR)
+        if table[510:512] != b'\x55\xaa':
+            raise ValueError(f"{path}: no MBR")
+        for i in range(4):
+            ptype, lba, sectors = struct.unpack_from('<4xB3xII', table, 446 + 16 * i)
+            if ptype != RAW_TYPE:
+                continue
+            f.seek(lba * SECTOR)
+            block = f.read(SECTOR)
+            magic, count, part_sectors, crc = SUPERBLOCK.unpack_from(block)
+            extents_raw = block[SUPERBLOCK.size:SUPERBLOCK.size + count * EXTENT.size]
+            ok = magic == RAW_MAGIC and count <= MAX_EXTENTS and part_sectors == sectors and \
+                zlib.crc32(extents_raw) & 0xFFFFFFFF == crc
+            print(f"raw partition {i + 1}: LBA {lba}, {sectors} sectors, superblock {'ok' if ok else 'BAD'}")
+            for k in range(count if ok else 0):
+                name, start, n, size, data_crc = EXTENT.unpack_from(extents_raw, k * EXTENT.size)
+                f.seek((lba + start) * SECTOR)
+                data_ok = zlib.crc32(f.read(size)) & 0xFFFFFFFF == data_crc
+                name = name.rstrip(b'\0').decode()
+                print(f"  {name:<16} sector {start:>8}  {size:>10} bytes  "
+                      f"crc {'ok' if data_ok else 'BAD'}")
+            return 0 if ok else 1
+    print(f"{path}: no raw partition (type 0x{RAW_TYPE:02X})")
+    return 1
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Build an SD card image with a raw data partition")
+    parser.add_argument('-o', '--output', help="image to write")
+    parser.add_argument('--extent', action='append', default=[], help="name=file, stored in the raw partition")
+    parser.add_argument('--fat-image', help="FAT/exFAT volume image for partition 1")
+    parser.add_argument('--fat-mb', type=int, default=32, help="partition 1 size in MiB without --fat-image (default 32)")
+    parser.add_argument('--size-mb', type=int, default=0, help="total image size (default: just large enough)")
+    parser.add_argument('--align', type=int, default=8, help="extent alignment in sectors (default 8 = 4 KiB)")
+    parser.add_argument('--list', metavar='IMAGE', help="print the raw partition of an image and check its CRCs")
+    args = parser.parse_args()
+
+    try:
+        if args.list:
+            return list_image(args.list)
+        if not args.output or not args.extent:
+            parser.error("need -o and at least one --extent (or --list)")
+        if args.align < 1:
+            parser.error("--align must be at least 1")
+        build(args)
+    except (OSError, ValueError) as e:
+        print(f"error: {e}", file=sys.stderr)
+        return 2
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,112 @@
+"""
+Helpers for rewriting .tflite models on the host (used by sparsify_model.py and
+friends). Works on the flatbuffer object API from TensorFlow.
+"""
+
+import numpy as np
+from tensorflow.lite.python import schema_py_generated as schema
+from tensorflow.lite.tools import flatbuffer_utils
+
+BUILTIN_CONV_2D = schema.BuiltinOperator.CONV_2D
+BUILTIN_DEPTHWISE_CONV_2D = schema.BuiltinOperator.DEPTHWISE_CONV_2D
+BUILTIN_FULLY_CONNECTED = schema.BuiltinOperator.FULLY_CONNECTED
+BUILTIN_CUSTOM = schema.BuiltinOperator.CUSTOM
+
+# schema Padding (SAME=0, VALID=1) -> TfLitePadding (Same=1, Valid=2)
+TFLITE_PADDING = {schema.Padding.SAME: 1, schema.Padding.VALID: 2}
+
+
+def read_model(path):
+    return flatbuffer_utils.read_model(path)
+
+
+def write_model(model, path):
+    flatbuffer_utils.write_model(model, path)
+
+
+def model_size(path):
+    with open(path, 'rb') as f:
+        return len(f.read())
+
+
+def builtin_code(model, op):
+    """Newer schemas keep small codes in deprecatedBuiltinCode."""
+    opcode = model.operatorCodes[op.opcodeIndex]
+    return max(opcode.builtinCode, opcode.deprecatedBuiltinCode)
+
+
+def custom_opcode_index(model, name):
+    """Index of the custom operator code 'name', added if missing."""
+    for i, opcode in enumerate(model.operatorCodes):
+        code = max(opcode.builtinCode, opcode.deprecatedBuiltinCode)
+        if code == BUILTIN_CUSTOM and opcode.customCode in (name, name.encode()):
+            return i
+    opcode = schema.OperatorCodeT()
+    opcode.builtinCode = BUILTIN_CUSTOM
+    opcode.deprecatedBuiltinCode = BUILTIN_CUSTOM
+    opcode.customCode = name
+    opcode.version = 1
+    model.operatorCodes.append(opcode)
+    return len(model.operatorCodes) - 1
+
+
+def tensor_data(model, tensor, dtype):
+    """Constant tensor contents as a numpy array of its shape (None if not constant)."""
+    buf = model.buffers[tensor.buffer]
+    if buf.data is None or len(buf.data) == 0:
+        return None
+    return np.frombuffer(bytes(bytearray(buf.data)), dtype=dtype).reshape(tensor.shape)
+
+
+def tensor_scales(tensor, channels):
+    """Per-channel scales (a per-tensor scale is repeated)."""
+    scales = list(tensor.quantization.scale)
+    if len(scales) == 1:
+        scales = scales * channels
+    return np.asarray(scales, dtype=np.float32)
+
+
+def replace_with_custom_op(model, subgraph, op, name, inputs, options):
+    """Turn op into custom op 'name' with the given inputs and raw custom options."""
+    op.opcodeIndex = custom_opcode_index(model, name)
+    op.inputs = list(inputs)
+    op.builtinOptionsType = schema.BuiltinOptions.NONE
+    op.builtinOptions = None
+    op.customOptions = np.frombuffer(options, dtype=np.uint8)
+    op.customOptionsFormat = schema.CustomOptionsFormat.FLEXBUFFERS
+
+
+def remove_unused_tensors(model, subgraph):
+    """Drop tensors no op or subgraph I/O refers to, and empty their buffers. TFLM
+    rejects non-constant tensors without a lifetime, and this frees the weight bytes."""
+    used = set(subgraph.inputs) | set(subgraph.outputs)
+    for op in subgraph.operators:
+        used.update(i for i in op.inputs if i >= 0)
+        used.update(op.outputs)
+        if op.intermediates is not None:
+            used.update(op.intermediates)
+    remap = {}
+    kept = []
+    dropped = []
+    for i, tensor in enumerate(subgraph.tensors):
+        if i in used:
+            remap[i] = len(kept)
+            kept.append(tensor)
+        else:
+            dropped.append(tensor)
+    subgraph.tensors = kept
+    kept_buffers = {t.buffer for sg in model.subgraphs for t in sg.tensors}
+    for tensor in dropped:
+        if tensor.buffer > 0 and tensor.buffer not in kept_buffers:
+            model.buffers[tensor.buffer].data = None
+
+    def fix(indices):
+        return [remap[i] if i >= 0 else i for i in indices]
+
+    subgraph.inputs = fix(subgraph.inputs)
+    subgraph.outputs = fix(subgraph.outputs)
+    for op in subgraph.operators:
+        op.inputs = fix(op.inputs)
+        op.outputs = fix(op.outputs)
+        if op.intermediates is not None:
+            op.intermediates = fix(op.intermediates)
@@ -0,0 +1,117 @@
+#!/usr/bin/env python3
+"""
+Pack images into one dataset file for the SD card (see src/utils/dataset.h).
+
+Layout: a 32-byte header (magic "IDS1", count, width, height, channels, image bytes,
+stride, data offset, CRC-32 of the labels), one label byte per image (0xFF: unknown),
+zero padding to a 512-byte boundary, then the images, each padded to whole 512-byte
+sectors. Copy the output to the SD card root as images.ids.
+
+Inputs, in order:
+  - CIFAR-10 binary batches (cifar-10-batches-bin/*.bin): label byte + 3072 image bytes
+    per record, labels kept;
+  - directories of raw image files (e.g. the old img/0.bin, img/1.bin, ...), taken in
+    numeric order without labels.
+
+Usage:
+    python pack_images.py cifar-10-batches-bin/test_batch.bin -n 20 -o images.ids
+    python pack_images.py img/ --dims 32x32x3
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+import zlib
+
+MAGIC = b'IDS1'
+HEADER = struct.Struct('<4sIHHHHIIII')
+SECTOR = 512
+NO_LABEL = 0xFF
+
+
+def round_up(n, to):
+    return (n + to - 1) // to * to
+
+
+def read_cifar_batch(path, image_bytes):
+    """[(label, image bytes)] of a CIFAR-10 binary batch."""
+    record = 1 + image_bytes
+    with open(path, 'rb') as f:
+        data = f.read()
+    if len(data) % record != 0:
+        raise ValueError(f"{path}: size {len(data)} is not a multiple of {record}-byte records")
+    return [(data[i], data[i + 1:i + record]) for i in range(0, len(data), record)]
+
+
+def read_image_dir(path, image_bytes):
+    """[(NO_LABEL, image bytes)] of the .bin files in path, in numeric order."""
+    def key(name):
+        m = re.match(r'(\d+)', name)
+        return (int(m.group(1)) if m else sys.maxsize, name)
+    images = []
+    for name in sorted((n for n in os.listdir(path) if n.endswith('.bin')), key=key):
+        with open(os.path.join(path, name), 'rb') as f:
+            data = f.read()
+        if len(data) != image_bytes:
+            raise ValueError(f"{name}: {len(data)} bytes, expected {image_bytes}")
+        images.append((NO_LABEL, data))
+    return images
+
+
+def pack_images(images, dims, out_path):
+    width, height, channels = dims
+    image_bytes = width * height * channels
+    count = len(images)
+    labels = bytes(label for label, _ in images)
+    stride = round_up(image_bytes, SECTOR)
+    data_offset = round_up(HEADER.size + count, SECTOR)
+    header = HEADER.pack(MAGIC, count, width, height, channels, 0, image_bytes, stride, data_offset,
+                         zlib.crc32(labels) & 0xFFFFFFFF)
+    with open(out_path, 'wb') as f:
+        f.write(header)
+        f.write(labels)
+        f.write(bytes(data_offset - HEADER.size - count))
+        for _, image in images:
+            f.write(image)
+            f.write(bytes(stride - image_bytes))
+    size = data_offset + count * stride
+    print(f"Wrote {out_path}: {count} images ({width}x{height}x{channels}), stride {stride}, "
+          f"data at {data_offset}, {size} bytes")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Pack images into an SD card dataset file")
+    parser.add_argument('inputs', nargs='+', help="CIFAR-10 binary batches and/or directories of raw images")
+    parser.add_argument('-o', '--output', default='images.ids', help="output file (default images.ids)")
+    parser.add_argument('-n', '--count', type=int, default=0, help="pack only the first N images")
+    parser.add_argument('--dims', default='32x32x3', help="WIDTHxHEIGHTxCHANNELS (default 32x32x3)")
+    args = parser.parse_args()
+
+    dims = tuple(int(d) for d in args.dims.lower().split('x'))
+    if len(dims) != 3 or min(dims) <= 0 or max(dims) > 0xFFFF:
+        parser.error(f"bad --dims {args.dims}")
+    image_bytes = dims[0] * dims[1] * dims[2]
+
+    images = []
+    try:
+        for path in args.inputs:
+            if os.path.isdir(path):
+                images += read_image_dir(path, image_bytes)
+            else:
+                images += read_cifar_batch(path, image_bytes)
+    except (OSError, ValueError) as e:
+        print(f"error: {e}", file=sys.stderr)
+        return 1
+    if args.count > 0:
+        images = images[:args.count]
+    if not images:
+        print("error: no images", file=sys.stderr)
+        return 1
+    pack_images(images, dims, args.output)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
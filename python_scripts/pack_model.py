@@ -0,0 +1,36 @@
+#!/usr/bin/env python3
+"""
+Package a .tflite model for loading from the SD card (see src/model/model_loader.h).
+
+Writes a 16-byte header (magic "MDL1", size, CRC-32, reserved) followed by the
+model bytes. Copy the output to the SD card root as model.bin.
+
+Usage: python pack_model.py <model.tflite> [output.bin]
+"""
+
+import struct
+import sys
+import zlib
+
+MAGIC = b'MDL1'
+
+
+def pack_model(tflite_path, out_path):
+    with open(tflite_path, 'rb') as f:
+        data = f.read()
+    if data[4:8] != b'TFL3':
+        raise ValueError(f"{tflite_path} is not a TFLite flatbuffer")
+
+    crc = zlib.crc32(data) & 0xFFFFFFFF
+    header = MAGIC + struct.pack('<III', len(data), crc, 0)
+    with open(out_path, 'wb') as f:
+        f.write(header)
+        f.write(data)
+    print(f"Wrote {out_path}: {len(data)} bytes, crc {crc:08x}")
+
+
+if __name__ == '__main__':
+    if len(sys.argv) < 2:
+        print("Usage: python pack_model.py <model.tflite> [output.bin]")
+        sys.exit(1)
+    pack_model(sys.argv[1], sys.argv[2] if len(sys.argv) > 2 else 'model.bin')
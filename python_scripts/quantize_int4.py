@@ -0,0 +1,170 @@
+#!/usr/bin/env python3
+"""
+Re-quantize the int8 CONV_2D / DEPTHWISE_CONV_2D / FULLY_CONNECTED weights of a .tflite
+model to per-channel symmetric int4 and pack them two per byte
+(src/model/kernels/int4_kernels.h). Converted ops become custom ops INT4_CONV_2D /
+INT4_DEPTHWISE_CONV_2D / INT4_FULLY_CONNECTED; biases are rescaled to the new filter scales.
+
+--simulate also writes a plain int8 model holding the same int4 values (filter scale = int4
+scale). It runs on the host TFLite interpreter with the same arithmetic as the device
+kernels, which is what int4_eval.py uses to measure accuracy.
+
+Usage:
+    python quantize_int4.py <model.tflite> <out.tflite> [--simulate sim.tflite] [--skip-ops 0,27]
+"""
+
+import argparse
+import struct
+
+import numpy as np
+
+import model_rewrite as mr
+
+INT4_WEIGHTS_MAGIC = 0x31573449  # "I4W1"
+INT4_OP_CONV_2D = 0
+INT4_OP_DEPTHWISE_CONV_2D = 1
+INT4_OP_FULLY_CONNECTED = 2
+
+CUSTOM_NAMES = {
+    INT4_OP_CONV_2D: 'INT4_CONV_2D',
+    INT4_OP_DEPTHWISE_CONV_2D: 'INT4_DEPTHWISE_CONV_2D',
+    INT4_OP_FULLY_CONNECTED: 'INT4_FULLY_CONNECTED',
+}
+
+
+def requantize(weights, scales, axis):
+    """int8 weights + per-channel scales -> (int4 values in int8, int4 scales, relative RMS error)."""
+    shape = [1] * weights.ndim
+    shape[axis] = -1
+    real = weights.astype(np.float32) * scales.reshape(shape)
+    other = tuple(i for i in range(weights.ndim) if i != axis)
+    max_abs = np.abs(real).max(axis=other)
+    scales4 = np.where(max_abs > 0, max_abs / 7.0, scales).astype(np.float32)
+    q4 = np.clip(np.round(real / scales4.reshape(shape)), -7, 7).astype(np.int8)
+    err = np.sqrt(np.mean((q4 * scales4.reshape(shape) - real) ** 2)) / max(np.sqrt(np.mean(real ** 2)), 1e-12)
+    return q4, scales4, float(err)
+
+
+def pack_nibbles(rows):
+    """[rows, n] int4 values -> [rows, n/2] bytes, low nibble first (n must be even)."""
+    u = (rows.astype(np.int16) & 0xF).astype(np.uint8)
+    return (u[:, 0::2] | (u[:, 1::2] << 4)).astype(np.uint8)
+
+
+def pack_weights(kind, q4):
+    if kind == INT4_OP_DEPTHWISE_CONV_2D:
+        # [1, kh, kw, C] -> per tap, C padded to even
+        taps = q4.reshape(-1, q4.shape[-1])
+        padded = np.zeros((taps.shape[0], taps.shape[1] + taps.shape[1] % 2), dtype=np.int8)
+        padded[:, :taps.shape[1]] = taps
+        return pack_nibbles(padded).tobytes()
+    # [out, ...] OHWI -> per output channel, K padded to a multiple of 8
+    rows = q4.reshape(q4.shape[0], -1)
+    k8 = (rows.shape[1] + 7) // 8 * 8
+    padded = np.zeros((rows.shape[0], k8), dtype=np.int8)
+    padded[:, :rows.shape[1]] = rows
+    return pack_nibbles(padded).tobytes()
+
+
+def header(kind, q4, opts, in_channels):
+    if kind == INT4_OP_FULLY_CONNECTED:
+        out_channels, kh, kw = q4.shape[0], 1, 1
+        padding, stride, dilation = 0, (1, 1), (1, 1)
+    else:
+        out_channels = q4.shape[-1] if kind == INT4_OP_DEPTHWISE_CONV_2D else q4.shape[0]
+        kh, kw = q4.shape[1], q4.shape[2]
+        padding = mr.TFLITE_PADDING[opts.padding]
+        stride = (opts.strideW, opts.strideH)
+        dilation = (opts.dilationWFactor, opts.dilationHFactor)
+    activation = opts.fusedActivationFunction if opts is not None else 0
+    return struct.pack('<IBBBBhhhhiiii', INT4_WEIGHTS_MAGIC, kind, padding, activation, 0,
+                       stride[0], stride[1], dilation[0], dilation[1], out_channels, kh, kw, in_channels)
+
+
+def set_tensor_data(model, tensor, array):
+    model.buffers[tensor.buffer].data = np.frombuffer(array.tobytes(), dtype=np.uint8)
+
+
+def quantize(model, skip_ops, simulate):
+    report = []
+    op_index = 0
+    for subgraph in model.subgraphs:
+        for op in subgraph.operators:
+            index, op_index = op_index, op_index + 1
+            code = mr.builtin_code(model, op)
+            kind = {mr.BUILTIN_CONV_2D: INT4_OP_CONV_2D,
+                    mr.BUILTIN_DEPTHWISE_CONV_2D: INT4_OP_DEPTHWISE_CONV_2D,
+                    mr.BUILTIN_FULLY_CONNECTED: INT4_OP_FULLY_CONNECTED}.get(code)
+            if kind is None or index in skip_ops:
+                continue
+            input_t = subgraph.tensors[op.inputs[0]]
+            filter_t = subgraph.tensors[op.inputs[1]]
+            if input_t.type != mr.schema.TensorType.INT8 or filter_t.type != mr.schema.TensorType.INT8:
+                continue
+            weights = mr.tensor_data(model, filter_t, np.int8)
+            if weights is None:
+                continue
+            opts = op.builtinOptions
+            axis = 3 if kind == INT4_OP_DEPTHWISE_CONV_2D else 0
+            if kind == INT4_OP_DEPTHWISE_CONV_2D and input_t.shape[3] != weights.shape[3]:
+                continue  # depth multiplier > 1 stays int8
+
+            scales8 = mr.tensor_scales(filter_t, weights.shape[axis])
+            q4, scales4, err = requantize(weights, scales8, axis)
+
+            # Bias was quantized with input_scale * filter_scale
+            bias = op.inputs[2] if len(op.inputs) > 2 else -1
+            if bias >= 0:
+                bias_t = subgraph.tensors[bias]
+                bias_data = mr.tensor_data(model, bias_t, np.int32)
+                if bias_data is not None:
+                    rescaled = np.round(bias_data.astype(np.float64) * scales8 / scales4)
+                    set_tensor_data(model, bias_t, np.clip(rescaled, -2**31, 2**31 - 1).astype('<i4'))
+                    bias_t.quantization.scale = list(input_t.quantization.scale[0] * scales4)
+                    bias_t.quantization.zeroPoint = [0] * len(scales4)
+
+            in_channels = weights.reshape(weights.shape[0], -1).shape[1] if kind == INT4_OP_FULLY_CONNECTED \
+                else input_t.shape[3]
+            packed = pack_weights(kind, q4)
+            report.append((CUSTOM_NAMES[kind], tuple(weights.shape), weights.size, len(packed), err))
+            if simulate:
+                set_tensor_data(model, filter_t, q4)
+                filter_t.quantization.scale = list(scales4)
+                filter_t.quantization.zeroPoint = [0] * len(scales4)
+                filter_t.quantization.quantizedDimension = axis
+                continue
+            options = header(kind, q4, opts, in_channels) + scales4.astype('<f4').tobytes() + packed
+            mr.replace_with_custom_op(model, subgraph, op, CUSTOM_NAMES[kind], [op.inputs[0], bias], options)
+        if not simulate:
+            mr.remove_unused_tensors(model, subgraph)
+    return report
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Int4 packed-weight conversion')
+    parser.add_argument('model')
+    parser.add_argument('output')
+    parser.add_argument('--simulate', help='also write an int8 model with the int4 values (host accuracy)')
+    parser.add_argument('--skip-ops', default='',
+                        help='comma-separated operator indices to keep int8 (e.g. first conv, classifier)')
+    args = parser.parse_args()
+    skip_ops = {int(i) for i in args.skip_ops.split(',') if i.strip()}
+
+    model = mr.read_model(args.model)
+    report = quantize(model, skip_ops, simulate=False)
+    mr.write_model(model, args.output)
+    if args.simulate:
+        sim = mr.read_model(args.model)
+        quantize(sim, skip_ops, simulate=True)
+        mr.write_model(sim, args.simulate)
+
+    print(f"{'layer':<24} {'weights':>16} {'int8 B':>8} {'int4 B':>8} {'rel err':>8}")
+    for name, shape, int8_bytes, int4_bytes, err in report:
+        shape_str = 'x'.join(str(d) for d in shape)
+        print(f"{name:<24} {shape_str:>16} {int8_bytes:>8} {int4_bytes:>8} {err:>8.2%}")
+    before, after = mr.model_size(args.model), mr.model_size(args.output)
+    print(f"Model: {before} -> {after} bytes ({100.0 * (before - after) / before:.1f}% smaller)")
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,125 @@
+#!/usr/bin/env python3
+"""
+Convert the int8 CONV_2D / FULLY_CONNECTED weights of a pruned .tflite model to the
+1x4 block-sparse encoding of src/model/kernels/sparse_kernels.h.
+
+Layers whose share of non-zero 1x4 blocks is above --max-density stay dense (the CMSIS-NN
+kernels win there). Converted ops become custom ops SPARSE_CONV_2D /
+SPARSE_FULLY_CONNECTED with the encoded weights in their custom options.
+
+Usage:
+    python sparsify_model.py <pruned.tflite> <out.tflite> [--max-density 0.6]
+
+Then either regenerate model_data.cc (xxd -i) or pack it for the SD card
+(pack_model.py) and compare against the dense model in the PROFILING boot benchmark.
+"""
+
+import argparse
+import struct
+
+import numpy as np
+
+import model_rewrite as mr
+
+SPARSE_WEIGHTS_MAGIC = 0x31575053  # "SPW1"
+SPARSE_OP_CONV_2D = 0
+SPARSE_OP_FULLY_CONNECTED = 1
+
+
+def encode_blocks(weights):
+    """weights [out, K] int8 -> (bitmap words [out, words], values bytes, nnz blocks)."""
+    out_channels, k = weights.shape
+    blocks = (k + 3) // 4
+    padded = np.zeros((out_channels, blocks * 4), dtype=np.int8)
+    padded[:, :k] = weights
+    padded = padded.reshape(out_channels, blocks, 4)
+    nonzero = np.any(padded != 0, axis=2)
+
+    words = (blocks + 31) // 32
+    bitmap = np.zeros((out_channels, words), dtype=np.uint32)
+    for b in range(blocks):
+        bitmap[:, b // 32] |= nonzero[:, b].astype(np.uint32) << np.uint32(b % 32)
+    values = padded[nonzero]  # row order: channel by channel, block by block
+    return bitmap, values.tobytes(), int(nonzero.sum())
+
+
+def sparse_options(op_kind, weights_ohwi, scales, padding=1, activation=0,
+                   stride=(1, 1), dilation=(1, 1)):
+    out_channels = weights_ohwi.shape[0]
+    if weights_ohwi.ndim == 4:
+        _, kh, kw, cin = weights_ohwi.shape
+    else:
+        kh, kw, cin = 1, 1, weights_ohwi.shape[1]
+    bitmap, values, nnz = encode_blocks(weights_ohwi.reshape(out_channels, -1))
+    header = struct.pack('<IBBBBhhhhiiiii', SPARSE_WEIGHTS_MAGIC, op_kind, padding, activation, 0,
+                         stride[0], stride[1], dilation[0], dilation[1],
+                         out_channels, kh, kw, cin, nnz)
+    options = header + scales.astype('<f4').tobytes() + bitmap.astype('<u4').tobytes() + values
+    blocks = (kh * kw * cin + 3) // 4
+    return options, nnz, out_channels * blocks
+
+
+def sparsify(model, max_density):
+    report = []
+    for subgraph in model.subgraphs:
+        for op in subgraph.operators:
+            code = mr.builtin_code(model, op)
+            if code not in (mr.BUILTIN_CONV_2D, mr.BUILTIN_FULLY_CONNECTED):
+                continue
+            input_t = subgraph.tensors[op.inputs[0]]
+            filter_t = subgraph.tensors[op.inputs[1]]
+            if input_t.type != mr.schema.TensorType.INT8 or filter_t.type != mr.schema.TensorType.INT8:
+                continue
+            weights = mr.tensor_data(model, filter_t, np.int8)
+            if weights is None:
+                continue
+            scales = mr.tensor_scales(filter_t, weights.shape[0])
+            bias = op.inputs[2] if len(op.inputs) > 2 else -1
+
+            opts = op.builtinOptions
+            if code == mr.BUILTIN_CONV_2D:
+                options, nnz, dense = sparse_options(
+                    SPARSE_OP_CONV_2D, weights, scales, mr.TFLITE_PADDING[opts.padding],
+                    opts.fusedActivationFunction, (opts.strideW, opts.strideH),
+                    (opts.dilationWFactor, opts.dilationHFactor))
+                name = 'SPARSE_CONV_2D'
+            else:
+                options, nnz, dense = sparse_options(
+                    SPARSE_OP_FULLY_CONNECTED, weights, scales,
+                    activation=opts.fusedActivationFunction if opts is not None else 0)
+                name = 'SPARSE_FULLY_CONNECTED'
+
+            density = nnz / dense
+            entry = (name.replace('SPARSE_', '').lower(), tuple(weights.shape), density, weights.size, len(options))
+            if density > max_density:
+                report.append(entry + (False,))
+                continue
+            mr.replace_with_custom_op(model, subgraph, op, name, [op.inputs[0], bias], options)
+            report.append(entry + (True,))
+        mr.remove_unused_tensors(model, subgraph)
+    return report
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Block-sparse int8 weight conversion')
+    parser.add_argument('model')
+    parser.add_argument('output')
+    parser.add_argument('--max-density', type=float, default=0.6,
+                        help='convert layers with at most this share of non-zero 1x4 blocks')
+    args = parser.parse_args()
+
+    model = mr.read_model(args.model)
+    report = sparsify(model, args.max_density)
+    mr.write_model(model, args.output)
+
+    print(f"{'layer':<18} {'weights':>20} {'density':>8} {'dense B':>9} {'sparse B':>9}")
+    for kind, shape, density, dense_bytes, sparse_bytes, converted in report:
+        shape_str = 'x'.join(str(d) for d in shape)
+        sparse_str = str(sparse_bytes) if converted else 'kept'
+        print(f"{kind:<18} {shape_str:>20} {density:>8.1%} {dense_bytes:>9} {sparse_str:>9}")
+    before, after = mr.model_size(args.model), mr.model_size(args.output)
+    print(f"Model: {before} -> {after} bytes ({100.0 * (before - after) / before:.1f}% smaller)")
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,103 @@
+#!/usr/bin/env python3
+"""
+Profile-guided TCM placement: pick the library code sections worth moving to TCM and
+write them as libs/tcm_sections.ld (included in the .tcm section of linker_script.ld).
+
+Inputs: the linker map (build/output.map, for section sizes) and a PROFILING boot log
+(for cycles per kind): the per-layer lines of the kernel scratch / depthwise reports
+("conv ... N cyc/invoke") and the IVF query lines (centroid + bucket search cycles).
+Kinds are ranked by cycles per byte of code and their sections added until the budget
+is used.
+
+Usage: python tcm_plan.py <output.map> <boot_log.txt> [--budget 32768] > libs/tcm_sections.ld
+"""
+
+import argparse
+import re
+import sys
+
+from tcm_report import parse_map
+
+# Code behind each profiled kind, matched against input section names (-ffunction-sections)
+KIND_PATTERNS = {
+    'conv': [r'arm_convolve', r'arm_nn_mat_mult', r'arm_q7_to_q15'],
+    'dw': [r'arm_depthwise', r'arm_nn_depthwise'],
+    'fc': [r'arm_fully_connected', r'arm_nn_vec_mat_mult'],
+    'ivf': [r'distance', r'centroid'],
+}
+
+LAYER_RE = re.compile(r'^(conv|dw|fc)\b.*?(\d+) cyc/invoke')
+IVF_RE = re.compile(r'IVF: \d+ cyc \(.*?cen:(\d+) .*?search:(\d+)')
+
+
+def profile_cycles(path):
+    cycles = {kind: 0 for kind in KIND_PATTERNS}
+    with open(path, errors='replace') as f:
+        for line in f:
+            m = LAYER_RE.match(line.strip())
+            if m:
+                cycles[m.group(1)] += int(m.group(2))
+                continue
+            m = IVF_RE.search(line)
+            if m:
+                cycles['ivf'] += int(m.group(1)) + int(m.group(2))
+    return cycles
+
+
+def candidates(sections):
+    """-> {kind: [(section name, size)]} from the .text and .tcm output sections.
+
+    Sections placed by the current libs/tcm_sections.ld sit in .tcm, not .text; they are
+    candidates too, so re-planning can keep them."""
+    sizes = {}
+    for out in sections:
+        if out['name'] not in ('.text', '.tcm'):
+            continue
+        for name, _, size, _ in out['inputs']:
+            if name.startswith('.text.') and size > 0:
+                sizes[name] = sizes.get(name, 0) + size  # *(name) takes every object's copy
+    found = {kind: [] for kind in KIND_PATTERNS}
+    for name, size in sizes.items():
+        for kind, patterns in KIND_PATTERNS.items():
+            if any(re.search(p, name) for p in patterns):
+                found[kind].append((name, size))
+                break
+    return found
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Profile-guided TCM placement')
+    parser.add_argument('map')
+    parser.add_argument('profile', help='PROFILING boot log')
+    parser.add_argument('--budget', type=int, default=32 * 1024, help='TCM bytes for library code')
+    args = parser.parse_args()
+
+    cycles = profile_cycles(args.profile)
+    found = candidates(parse_map(args.map))
+
+    # Kinds by cycles per byte of code; small (inner loop) sections first within a kind
+    ranked = []
+    for kind, secs in found.items():
+        size = sum(s for _, s in secs)
+        if cycles[kind] > 0 and size > 0:
+            ranked.append((cycles[kind] / size, kind, sorted(secs, key=lambda s: s[1])))
+    ranked.sort(reverse=True)
+
+    used = 0
+    print("/*\n * Generated by python_scripts/tcm_plan.py (budget %d bytes).\n"
+          " * Included in the .tcm output section of libs/linker_script.ld.\n */" % args.budget)
+    for _, kind, secs in ranked:
+        print(f"/* {kind}: {cycles[kind]} cycles profiled */")
+        for name, size in secs:
+            if used + size > args.budget:
+                continue
+            used += size
+            print(f"*({name}) /* {size} bytes */")
+    print(f"TCM plan: {used} of {args.budget} bytes", file=sys.stderr)
+    for kind in KIND_PATTERNS:
+        print(f"  {kind:<5} {cycles[kind]:>12} cycles, {sum(s for _, s in found[kind]):>7} code bytes",
+              file=sys.stderr)
+
+
+if __name__ == '__main__':
+    main()
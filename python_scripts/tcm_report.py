@@ -0,0 +1,91 @@
+#!/usr/bin/env python3
+"""
+TCM budget report from the linker map file (run by the Makefile after linking).
+
+Prints every output section in MCU_TCM (.tcm, .stack, .heap, .data, .bss), the total
+against the 384KB TCM, and the largest input sections placed in .tcm.
+
+Usage: python tcm_report.py <output.map> [--top 15]
+"""
+
+import argparse
+import re
+
+TCM_ORIGIN = 0x10000000
+TCM_LENGTH = 393216
+
+OUTPUT_RE = re.compile(r'^(\.\S+)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+))?')
+INPUT_RE = re.compile(r'^ (\.\S+)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*))?$')
+CONT_RE = re.compile(r'^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)(?:\s+(\S.*))?$')
+
+
+def parse_map(path):
+    """-> list of output sections {name, addr, size, inputs: [(name, addr, size, file)]}."""
+    with open(path, errors='replace') as f:
+        lines = f.read().splitlines()
+    try:
+        lines = lines[lines.index('Linker script and memory map') + 1:]
+    except ValueError:
+        pass
+
+    sections = []
+    current = None
+    pending = None  # (kind, name) whose address/size is on the next line
+    for line in lines:
+        if pending is not None:
+            m = CONT_RE.match(line)
+            kind, name = pending
+            pending = None
+            if m:
+                addr, size = int(m.group(1), 16), int(m.group(2), 16)
+                if kind == 'output':
+                    current = {'name': name, 'addr': addr, 'size': size, 'inputs': []}
+                    sections.append(current)
+                elif current is not None:
+                    current['inputs'].append((name, addr, size, m.group(3) or ''))
+                continue
+        m = OUTPUT_RE.match(line)
+        if m:
+            if m.group(2) is None:
+                pending = ('output', m.group(1))
+            else:
+                current = {'name': m.group(1), 'addr': int(m.group(2), 16), 'size': int(m.group(3), 16),
+                           'inputs': []}
+                sections.append(current)
+            continue
+        m = INPUT_RE.match(line)
+        if m and current is not None:
+            if m.group(2) is None:
+                pending = ('input', m.group(1))
+            else:
+                current['inputs'].append((m.group(1), int(m.group(2), 16), int(m.group(3), 16), m.group(4)))
+    return sections
+
+
+def in_tcm(section):
+    return TCM_ORIGIN <= section['addr'] < TCM_ORIGIN + TCM_LENGTH and section['size'] > 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description='TCM budget report')
+    parser.add_argument('map')
+    parser.add_argument('--top', type=int, default=15, help='largest .tcm input sections to list')
+    args = parser.parse_args()
+
+    sections = [s for s in parse_map(args.map) if in_tcm(s)]
+    total = sum(s['size'] for s in sections)
+    print(f"TCM usage ({TCM_LENGTH // 1024} KB):")
+    for s in sections:
+        print(f"  {s['name']:<12} {s['size']:>8} bytes")
+    print(f"  {'total':<12} {total:>8} bytes ({100.0 * total / TCM_LENGTH:.1f}%), "
+          f"{TCM_LENGTH - total} free")
+
+    tcm = next((s for s in sections if s['name'] == '.tcm'), None)
+    if tcm is not None and tcm['inputs']:
+        print("Largest .tcm entries:")
+        for name, _, size, obj in sorted(tcm['inputs'], key=lambda i: -i[2])[:args.top]:
+            print(f"  {size:>8}  {name}  {obj.split('/')[-1]}")
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,126 @@
+#!/usr/bin/env python3
+"""
+Fetch the event trace from a board (make TRACE=1 UART_TEST=1 build) and convert it to
+Chrome trace_event JSON (open in https://ui.perfetto.dev or chrome://tracing).
+
+The dump (UART 'T', format in src/utils/trace.h) holds the zone names and up to
+TRACE_EVENTS events with cycle timestamps; each event carries the core clock, so
+cycles are converted to microseconds across 96 / 192 MHz switches.
+
+Usage:
+    python trace_dump.py --port /dev/cu.usbmodem* [--save trace.bin] -o trace.json
+    python trace_dump.py trace.bin -o trace.json
+Requires: pyserial (for --port)
+"""
+
+import argparse
+import json
+import struct
+
+CMD_TRACE_DUMP = b'T'
+TRACE_MAGIC = 0x31435254  # "TRC1"
+HEADER_FORMAT = '<IIII'   # magic, zone_count, event_count, dropped
+EVENT_FORMAT = '<QHBBI'   # timestamp, zone, type, clock_mhz, arg
+
+EVENT_BEGIN, EVENT_END, EVENT_INSTANT, EVENT_CLOCK = range(4)
+
+
+def fetch(port_name, baud):
+    """Request a dump; returns the raw bytes (header, names, events)."""
+    import serial
+    from uart_update_model import read_reply
+
+    with serial.Serial(port_name, baud, timeout=10) as port:
+        port.write(CMD_TRACE_DUMP)
+        if not read_reply(port):
+            raise RuntimeError("board was built without TRACE=1")
+        header = port.read(struct.calcsize(HEADER_FORMAT))
+        _, zone_count, event_count, _ = struct.unpack(HEADER_FORMAT, header)
+        data = bytearray(header)
+        for _ in range(zone_count):
+            n = port.read(1)
+            data += n + port.read(n[0])
+        data += port.read(event_count * struct.calcsize(EVENT_FORMAT))
+        return bytes(data)
+
+
+def parse(data):
+    """-> (zone names, [(timestamp, zone, type, clock_mhz, arg)], dropped)."""
+    header_size = struct.calcsize(HEADER_FORMAT)
+    magic, zone_count, event_count, dropped = struct.unpack_from(HEADER_FORMAT, data)
+    if magic != TRACE_MAGIC:
+        raise ValueError("not a trace dump")
+    pos = header_size
+    names = []
+    for _ in range(zone_count):
+        n = data[pos]
+        names.append(data[pos + 1:pos + 1 + n].decode('ascii', errors='replace'))
+        pos += 1 + n
+    size = struct.calcsize(EVENT_FORMAT)
+    if len(data) < pos + event_count * size:
+        raise ValueError(f"truncated dump: {event_count} events announced")
+    events = [struct.unpack_from(EVENT_FORMAT, data, pos + i * size) for i in range(event_count)]
+    return names, events, dropped
+
+
+def to_chrome(names, events):
+    """Chrome trace_event list; time runs at the clock recorded with the previous event."""
+    out = []
+    t_us = 0.0
+    open_zones = {}
+    prev = None
+    for ts, zone, kind, mhz, arg in events:
+        if prev is not None and ts > prev[0]:
+            t_us += (ts - prev[0]) / max(prev[3], 1)
+        prev = (ts, zone, kind, mhz, arg)
+        name = names[zone] if zone < len(names) else f"zone{zone}"
+        event = {'name': name, 'ts': round(t_us, 3), 'pid': 0, 'tid': 0}
+        if kind == EVENT_BEGIN:
+            open_zones[zone] = open_zones.get(zone, 0) + 1
+            event['ph'] = 'B'
+        elif kind == EVENT_END:
+            if not open_zones.get(zone):
+                continue  # its begin was overwritten
+            open_zones[zone] -= 1
+            event['ph'] = 'E'
+        elif kind == EVENT_CLOCK:
+            event.update(ph='C', name='core clock', args={'MHz': arg / 1e6})
+            out.append(event)
+            continue
+        else:
+            event.update(ph='i', s='t')
+        if arg:
+            event['args'] = {'arg': arg}
+        out.append(event)
+    return out
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Board event trace -> Chrome trace JSON')
+    parser.add_argument('dump', nargs='?', help='saved binary dump (instead of --port)')
+    parser.add_argument('--port', help='serial port of a TRACE=1 UART_TEST=1 board')
+    parser.add_argument('--baud', type=int, default=115200)
+    parser.add_argument('--save', help='also write the raw dump here')
+    parser.add_argument('-o', '--output', default='trace.json')
+    args = parser.parse_args()
+
+    if args.port:
+        data = fetch(args.port, args.baud)
+    elif args.dump:
+        with open(args.dump, 'rb') as f:
+            data = f.read()
+    else:
+        parser.error('give a dump file or --port')
+    if args.save:
+        with open(args.save, 'wb') as f:
+            f.write(data)
+
+    names, events, dropped = parse(data)
+    trace = to_chrome(names, events)
+    with open(args.output, 'w') as f:
+        json.dump({'traceEvents': trace, 'displayTimeUnit': 'ms'}, f)
+    print(f"{len(events)} events ({dropped} overwritten before the dump), {len(names)} zones -> {args.output}")
+
+
+if __name__ == '__main__':
+    main()
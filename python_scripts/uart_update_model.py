@@ -0,0 +1,108 @@
+#!/usr/bin/env python3
+"""
+Hot-swap the model on a running board (make UART_TEST=1 build) over UART.
+
+Streams the .tflite in CRC-checked chunks; the board stages it in the loader slot its
+running model is not in (SRAM or MRAM, alternating between updates), dry-runs it and
+switches without a reboot. The old model keeps serving until the switch succeeds.
+
+Usage: python uart_update_model.py <port> <model.tflite> [--baud 115200]
+Requires: pip install pyserial
+"""
+
+import argparse
+import struct
+import sys
+import zlib
+
+import serial
+
+CMD_MODEL_UPDATE = b'U'
+ACK = 0x06
+NAK = 0x15
+MAGIC = b'MDL1'
+CHUNK_SIZE = 1024
+MAX_RETRIES = 5
+
+# Status in the board's 12-byte response {int32 status, uint32 size, uint32 downtime_us}
+STATUS_OK = 0
+STATUS_RESEND = 1
+STATUS_ABORTED = -3
+
+
+def read_reply(port):
+    """Skip log text until ACK/NAK. Returns True for ACK."""
+    while True:
+        b = port.read(1)
+        if not b:
+            raise TimeoutError("no reply from board")
+        if b[0] in (ACK, NAK):
+            return b[0] == ACK
+
+
+def read_resp(port):
+    """Response block after a NAK (and after the final ACK): (status, size, downtime_us)."""
+    resp = port.read(12)
+    if len(resp) != 12:
+        raise TimeoutError("truncated response from board")
+    return struct.unpack('<iII', resp)
+
+
+def failure(status):
+    if status == STATUS_ABORTED:
+        return "board timed out or lost sync; previous model still active"
+    return f"model rejected (status {status}); previous model still active"
+
+
+def update_model(port, data):
+    if data[4:8] != b'TFL3':
+        raise ValueError("not a TFLite flatbuffer")
+    crc = zlib.crc32(data) & 0xFFFFFFFF
+    port.write(CMD_MODEL_UPDATE + MAGIC + struct.pack('<III', len(data), crc, 0))
+    if not read_reply(port):
+        raise RuntimeError(failure(read_resp(port)[0]))
+
+    for offset in range(0, len(data), CHUNK_SIZE):
+        chunk = data[offset:offset + CHUNK_SIZE]
+        frame = struct.pack('<H', len(chunk)) + chunk + struct.pack('<I', zlib.crc32(chunk) & 0xFFFFFFFF)
+        for _ in range(MAX_RETRIES):
+            port.write(frame)
+            if read_reply(port):
+                break
+            status = read_resp(port)[0]
+            if status != STATUS_RESEND:
+                raise RuntimeError(failure(status))
+        else:
+            # The board is still waiting for this chunk: let its read timeout drop the update
+            raise RuntimeError(f"chunk at offset {offset} rejected {MAX_RETRIES} times; "
+                               "previous model still active")
+        print(f"\r{offset + len(chunk)}/{len(data)} bytes", end='', flush=True)
+    print()
+
+    ok = read_reply(port)
+    status, size, downtime_us = read_resp(port)
+    if not ok or status != STATUS_OK:
+        raise RuntimeError(failure(status))
+    print(f"Model switched: {size} bytes, downtime {downtime_us / 1000:.1f} ms")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[1])
+    parser.add_argument('port')
+    parser.add_argument('model')
+    parser.add_argument('--baud', type=int, default=115200)
+    args = parser.parse_args()
+
+    with open(args.model, 'rb') as f:
+        data = f.read()
+    # Validation + interpreter rebuild on the board can take a few seconds
+    with serial.Serial(args.port, args.baud, timeout=30) as port:
+        try:
+            update_model(port, data)
+        except (RuntimeError, TimeoutError, ValueError) as e:
+            print(f"Update failed: {e}")
+            sys.exit(1)
+
+
+if __name__ == '__main__':
+    main()
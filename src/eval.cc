@@ -0,0 +1,163 @@
+#include "eval.h"
+
+#ifdef EVAL
+
+#include "dataset.h"
+#include "model/model_inference.h"
+#include "perf_mode.h"
+#include "profiler.h"
+#include "am_util.h"
+#ifndef EVAL_NO_IVF
+#include "ivf/ivf_retrieval.h"
+#endif
+
+#include <string.h>
+
+// Images per dataset_read(): one seek, then whole sectors as multi-block transfers
+constexpr int kEvalChunkRecords = 16;
+constexpr uint32_t kEvalProgressEvery = 1000;
+
+alignas(4) static uint8_t images[kEvalChunkRecords * kInputSize] __attribute__((section(".shared_bss")));
+static dataset_t eval_set;
+
+static double percent(uint32_t n, uint32_t total)
+{
+    return total ? 100.0 * n / total : 0.0;
+}
+
+#ifndef EVAL_NO_IVF
+// IVF step timer: burst clock cycles, also across the bucket reads at 96 MHz
+static uint32_t ivf_cycles(void)
+{
+    return (uint32_t)perf_mode_burst_cycles();
+}
+
+// IVF step breakdown (measured inside ivf_retrieve_closest with ivf_cycles) as eval zones
+static void add_ivf_steps(const ivf_profile_t *p)
+{
+    const uint32_t hz = perf_mode_burst_hz();
+    profiler_zone_add(profiler_zone("eval.ivf.embedding"), p->embedding_cyc, hz);
+    profiler_zone_add(profiler_zone("eval.ivf.centroid"), p->centroid_cyc, hz);
+    profiler_zone_add(profiler_zone("eval.ivf.bucket_load"), p->bucket_load_cyc, hz);
+    profiler_zone_add(profiler_zone("eval.ivf.search"), p->search_cyc, hz);
+}
+#endif
+
+// One image: TFLite head and IVF retrieval, scored against label
+static void eval_image(const uint8_t *image, int label, float *ivf_workspace, eval_result_t *result)
+{
+    perf_mode_burst_begin();
+#ifndef EVAL_NO_IVF
+    int32_t ivf_label = -1;
+    float distance = -1.f;
+    ivf_profile_t ivf_profile;
+    PROFILE_BEGIN("eval.ivf");
+    int ret = ivf_retrieve_closest(image, ivf_workspace, &ivf_label, &distance, &ivf_profile, ivf_cycles);
+    PROFILE_END("eval.ivf");
+#else
+    (void)ivf_workspace;
+#endif
+    PROFILE_BEGIN("eval.tflite");
+    int tflite_label = model_predict_class(image);
+    PROFILE_END("eval.tflite");
+    perf_mode_burst_end();
+
+    result->images++;
+    result->class_images[label]++;
+    if (tflite_label == label)
+    {
+        result->tflite_correct++;
+        result->class_tflite_correct[label]++;
+    }
+#ifndef EVAL_NO_IVF
+    if (ret != 0)
+    {
+        result->ivf_failed++;
+        return;
+    }
+    add_ivf_steps(&ivf_profile);
+    if (ivf_label == label)
+    {
+        result->ivf_correct++;
+        result->class_ivf_correct[label]++;
+    }
+#endif
+}
+
+int eval_run(const char *path, uint32_t max_images, float *ivf_workspace, eval_result_t *result)
+{
+    memset(result, 0, sizeof(*result));
+    if (dataset_open(&eval_set, path) != 0)
+        return -1;
+    if (eval_set.header.image_bytes != (uint32_t)kInputSize || dataset_stride(&eval_set) != (uint32_t)kInputSize)
+    {
+        am_util_stdio_printf("[eval] %s: %lu bytes per image, expected %d\r\n", path,
+                             (unsigned long)eval_set.header.image_bytes, kInputSize);
+        dataset_close(&eval_set);
+        return -1;
+    }
+    uint32_t total = dataset_count(&eval_set);
+    if (max_images > 0 && max_images < total)
+        total = max_images;
+    am_util_stdio_printf("[eval] %lu images from %s\r\n", (unsigned long)total, path);
+
+    int status = 0;
+    uint32_t done = 0;
+    while (done < total && status == 0)
+    {
+        uint32_t n = total - done;
+        if (n > (uint32_t)kEvalChunkRecords)
+            n = kEvalChunkRecords;
+        PROFILE_BEGIN("eval.read"); // per chunk of kEvalChunkRecords images
+        int read = dataset_read(&eval_set, done, n, images, sizeof(images));
+        PROFILE_END("eval.read");
+        if (read != 0)
+        {
+            am_util_stdio_printf("[eval] Read failed at image %lu\r\n", (unsigned long)done);
+            status = -1;
+            break;
+        }
+        for (uint32_t i = 0; i < n; i++)
+        {
+            int label = dataset_label(&eval_set, done + i);
+            if (label < 0 || label >= kCategoryCount)
+            {
+                am_util_stdio_printf("[eval] No valid label for image %lu\r\n", (unsigned long)(done + i));
+                status = -1;
+                break;
+            }
+            eval_image(images + i * kInputSize, label, ivf_workspace, result);
+            if (result->images % kEvalProgressEvery == 0)
+                am_util_stdio_printf("[eval] %lu/%lu  tflite %.2f%%  ivf %.2f%%\r\n", (unsigned long)result->images,
+                                     (unsigned long)total, percent(result->tflite_correct, result->images),
+                                     percent(result->ivf_correct, result->images));
+        }
+        done += n;
+    }
+    dataset_close(&eval_set);
+    return status;
+}
+
+void eval_report(const eval_result_t *result)
+{
+    am_util_stdio_printf("\r\n--- Evaluation ---\r\n");
+    am_util_stdio_printf("images:      %lu\r\n", (unsigned long)result->images);
+    am_util_stdio_printf("TFLite top-1: %lu (%.2f%%)\r\n", (unsigned long)result->tflite_correct,
+                         percent(result->tflite_correct, result->images));
+#ifndef EVAL_NO_IVF
+    am_util_stdio_printf("IVF top-1:    %lu (%.2f%%), %lu failed\r\n", (unsigned long)result->ivf_correct,
+                         percent(result->ivf_correct, result->images), (unsigned long)result->ivf_failed);
+#endif
+    am_util_stdio_printf("%-12s %6s %9s %9s\r\n", "class", "images", "tflite %", "ivf %");
+    for (int c = 0; c < kCategoryCount; c++)
+    {
+        am_util_stdio_printf("%-12s %6lu %9.2f %9.2f\r\n", kCategoryLabels[c], (unsigned long)result->class_images[c],
+                             percent(result->class_tflite_correct[c], result->class_images[c]),
+                             percent(result->class_ivf_correct[c], result->class_images[c]));
+    }
+#ifdef PROFILING
+    profiler_report(); // eval.* zones: per-stage latency percentiles
+#endif
+}
+
+#endif // EVAL
@@ -0,0 +1,46 @@
+#ifndef EVAL_H_
+#define EVAL_H_
+
+// Test-set evaluation (make EVAL=1, implies PROFILING): streams the CIFAR-10 test set from
+// a packed dataset file (src/utils/dataset.h) on the mounted FatFs volume through the
+// TFLite head and IVF retrieval, and reports top-1 accuracy of both (overall and per
+// class) and latency percentiles per stage (profiler zones eval.*).
+//
+// Pack the CIFAR-10 binary test batch with its labels and copy it to the SD card as
+// EVAL_SD_PATH:
+//     python python_scripts/pack_images.py cifar-10-batches-bin/test_batch.bin -o test.ids
+// On the host, bench/eval_host runs the same code on a disk image or on that file directly.
+
+#include <stdint.h>
+
+#include "model/model_settings.h"
+
+#ifdef EVAL
+
+#ifndef EVAL_SD_PATH
+#define EVAL_SD_PATH "test.ids"
+#endif
+
+typedef struct
+{
+    uint32_t images;         // evaluated
+    uint32_t tflite_correct; // top-1 matches
+    uint32_t ivf_correct;    // retrieved label matches
+    uint32_t ivf_failed;     // retrieval errors (counted as wrong)
+    uint32_t class_images[kCategoryCount];
+    uint32_t class_tflite_correct[kCategoryCount];
+    uint32_t class_ivf_correct[kCategoryCount];
+} eval_result_t;
+
+// Evaluate the first max_images images of the dataset at path (0: all; each needs a
+// label). ivf_workspace is the bucket buffer ivf_retrieve_closest() needs (unused in
+// EVAL_NO_IVF builds). Prints progress every 1000 images. Returns 0 on success, -1 if the
+// dataset can't be opened or read, or an image has no label.
+int eval_run(const char *path, uint32_t max_images, float *ivf_workspace, eval_result_t *result);
+
+// Print accuracy (overall and per class) and the profiler report.
+void eval_report(const eval_result_t *result);
+
+#endif // EVAL
+
+#endif // EVAL_H_
@@ -3,41 +3,46 @@
 #include "hal/am_hal_gpio.h"
 #include "am_util.h"
 #include "uart.h"
+#include "tcm.h"
+#include "perf_mode.h"
+#include "profiler.h"
+#include "trace.h"
+#include "mem_report.h"
+#include "dataset.h"
+#include "rawpart.h"
 #include "ff.h"
 #include "model/model_inference.h"
+#include "model/model_loader.h"
 #include "model/model_settings.h"
+#include "eval.h"
 #include "cifar10_test_images.h"
 #include "ivf/ivf_retrieval.h"
+#ifdef MODEL_CASCADE
+#include "model/model_cascade.h"
+#endif
 #include <cstdio>
 #include <cstring>
 
-#define SD_IMAGE_DIR "img"
-#define SD_NUM_IMAGES 20
+#define SD_DATASET_PATH "images.ids" /* python_scripts/pack_images.py */
+#define RAW_IMAGES_EXTENT "images"      /* same file in the raw partition (python_scripts/make_sd_image.py) */
+#define MODEL_SD_PATH "model.bin"
 #define SD_IMAGE_BYTES (INPUT_HEIGHT * INPUT_WIDTH * INPUT_CHANNELS)
+/* Set SD_BATCH_SIZE > 0 (make BATCH=N) to also submit the SD images to TFLite in batches. */
+#ifndef SD_BATCH_SIZE
+#define SD_BATCH_SIZE 0
+#endif
 
 /* Enable PROFILING (e.g. make CFLAGS+=-DPROFILING) to disable per-query prints and report timing. */
 #ifdef PROFILING
-/* DWT cycle counter: enable once so we can measure IVF and TFLite query time. */
-static void profiler_init(void)
+/* Calibration test: measure a known delay to verify the DWT cycle counter matches the core clock. */
+static void profiler_calibrate_delay(uint32_t delay_us)
 {
-    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
-    DWT->CYCCNT = 0;
-    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
-}
-static inline uint32_t profiler_cycles(void) { return DWT->CYCCNT; }
+    const uint32_t clock_mhz = perf_mode_clock_hz() / 1000000u;
+    const uint32_t expected_cycles = delay_us * clock_mhz; // e.g. 100ms at 96 MHz = 9,600,000 cycles
 
-/* Calibration test: measure a known delay (100ms) to verify DWT cycle counter matches CPU clock. */
-static void profiler_calibrate(void)
-{
-    am_util_stdio_printf("\r\n--- DWT Cycle Counter Calibration ---\r\n");
-
-    // Test 1: Measure 100ms delay (100000 microseconds)
-    const uint32_t delay_us = 100000;                     // 100ms
-    const uint32_t expected_cycles_96mhz = delay_us * 96; // At 96 MHz: 100ms = 9,600,000 cycles
-
-    uint32_t t0 = profiler_cycles();
+    uint32_t t0 = profiler_get_cycles();
     am_hal_delay_us(delay_us);
-    uint32_t t1 = profiler_cycles();
+    uint32_t t1 = profiler_get_cycles();
     uint32_t measured_cycles = t1 - t0;
 
     // Calculate effective clock rate (MHz)
@@ -45,62 +50,337 @@ static void profiler_calibrate(void)
 
     am_util_stdio_printf("Delay test: %u us delay\r\n", delay_us);
     am_util_stdio_printf("Measured: %lu cycles\r\n", (unsigned long)measured_cycles);
-    am_util_stdio_printf("Expected at 96 MHz: %lu cycles\r\n", (unsigned long)expected_cycles_96mhz);
+    am_util_stdio_printf("Expected at %lu MHz: %lu cycles\r\n", (unsigned long)clock_mhz,
+                         (unsigned long)expected_cycles);
     am_util_stdio_printf("Effective clock: %.2f MHz\r\n", effective_mhz);
+}
 
-    // Test 2: Measure 10ms delay for shorter test
-    const uint32_t delay_us2 = 10000;                       // 10ms
-    const uint32_t expected_cycles_96mhz2 = delay_us2 * 96; // At 96 MHz: 10ms = 960,000 cycles
+static void profiler_calibrate(void)
+{
+    am_util_stdio_printf("\r\n--- DWT Cycle Counter Calibration ---\r\n");
+    profiler_calibrate_delay(100000); // 100ms in the current (low power) mode
+    perf_mode_burst_begin();
+    profiler_calibrate_delay(10000); // 10ms at the burst clock
+    perf_mode_burst_end();
+    am_util_stdio_printf("--- End Calibration ---\r\n\r\n");
+}
 
-    t0 = profiler_cycles();
-    am_hal_delay_us(delay_us2);
-    t1 = profiler_cycles();
-    measured_cycles = t1 - t0;
-    effective_mhz = (float)measured_cycles / (float)delay_us2;
+/* Cycles at the burst clock: counted entirely inside a burst, or perf_mode_burst_cycles() differences */
+static double query_ms(uint64_t cycles)
+{
+    return profiler_cycles_to_ms(cycles, perf_mode_burst_hz());
+}
 
-    am_util_stdio_printf("Delay test 2: %u us delay\r\n", delay_us2);
-    am_util_stdio_printf("Measured: %lu cycles\r\n", (unsigned long)measured_cycles);
-    am_util_stdio_printf("Expected at 96 MHz: %lu cycles\r\n", (unsigned long)expected_cycles_96mhz2);
-    am_util_stdio_printf("Effective clock: %.2f MHz\r\n", effective_mhz);
-    am_util_stdio_printf("--- End Calibration ---\r\n\r\n");
+/* IVF step timer: burst clock cycles, also across the bucket / label reads at 96 MHz */
+static uint32_t ivf_cycles(void)
+{
+    return (uint32_t)perf_mode_burst_cycles();
 }
+
+/* Most recent sample of a zone */
+static uint64_t zone_last(const char *name)
+{
+    profiler_stats_t stats;
+    return (profiler_zone_stats(profiler_zone(name), &stats) == 0) ? stats.last : 0;
+}
+
+/* IVF step breakdown (measured inside ivf_retrieve_closest with ivf_cycles) as zones */
+static void add_ivf_profile(const ivf_profile_t *p)
+{
+    const uint32_t hz = perf_mode_burst_hz();
+    profiler_zone_add(profiler_zone("ivf.embedding"), p->embedding_cyc, hz);
+    profiler_zone_add(profiler_zone("ivf.emb.preprocess"), p->embedding_preprocess_cyc, hz);
+    profiler_zone_add(profiler_zone("ivf.emb.invoke"), p->embedding_invoke_cyc, hz);
+    profiler_zone_add(profiler_zone("ivf.emb.get"), p->embedding_get_cyc, hz);
+    profiler_zone_add(profiler_zone("ivf.centroid"), p->centroid_cyc, hz);
+    profiler_zone_add(profiler_zone("ivf.bucket_load"), p->bucket_load_cyc, hz);
+    profiler_zone_add(profiler_zone("ivf.search"), p->search_cyc, hz);
+    profiler_zone_add(profiler_zone("ivf.label_read"), p->label_read_cyc, hz);
+}
+
+#ifdef MODEL_CASCADE
+/* Gate hit rate and cycles saved; stage 1 cost per query = IVF + TFLite (query.full, SD
+ * reads included at their own clock), averaged over the escalated images */
+static void report_cascade(void)
+{
+    const cascade_stats_t *cs = model_cascade_stats();
+    profiler_stats_t full_stats;
+    if (profiler_zone_stats(profiler_zone("query.full"), &full_stats) != 0)
+    {
+        am_util_stdio_printf("Cascade: no query.full zone (profiler zones full)\r\n");
+        return;
+    }
+    uint32_t escalated = cs->queries - cs->gate_hits;
+    uint64_t avg_gate = cs->queries ? cs->gate_cycles / cs->queries : 0;
+    uint64_t avg_full = full_stats.mean;
+    uint64_t full_only = (uint64_t)cs->queries * avg_full;
+    uint64_t cascaded = cs->gate_cycles + (uint64_t)escalated * avg_full;
+    am_util_stdio_printf("--- Cascade ---\r\n");
+    am_util_stdio_printf("  gate hits:   %lu / %lu (%.1f%%), avg %llu cyc (%.2f ms)\r\n",
+                         (unsigned long)cs->gate_hits, (unsigned long)cs->queries,
+                         cs->queries ? 100.0 * cs->gate_hits / cs->queries : 0.0,
+                         (unsigned long long)avg_gate, query_ms(avg_gate));
+    am_util_stdio_printf("  full model:  %lu / %lu (%.1f%%), avg %llu cyc (%.2f ms)\r\n",
+                         (unsigned long)escalated, (unsigned long)cs->queries,
+                         cs->queries ? 100.0 * escalated / cs->queries : 0.0,
+                         (unsigned long long)avg_full, query_ms(avg_full));
+    if (full_only > cascaded)
+        am_util_stdio_printf("  saved:       %llu cyc (%.1f%% vs full model only)\r\n",
+                             (unsigned long long)(full_only - cascaded), 100.0 * (full_only - cascaded) / full_only);
+    else
+        am_util_stdio_printf("  saved:       none (gate overhead %llu cyc)\r\n",
+                             (unsigned long long)(cascaded - full_only));
+    am_util_stdio_printf("--- End Cascade ---\r\n\r\n");
+}
+#endif
 #endif
 
 static FATFS FatFs;
+static dataset_t sd_images;
+
+/**
+ * Open the packed SD images: the raw partition's images extent if the card has one,
+ * else SD_DATASET_PATH on the FAT volume. Returns the image count, 0 if missing or not
+ * model-sized.
+ */
+static uint32_t open_sd_images(void)
+{
+    const rawpart_extent_t *raw_images = (rawpart_mount(0) == 0) ? rawpart_find(RAW_IMAGES_EXTENT) : NULL;
+    if (raw_images != NULL)
+    {
+        if (dataset_open_raw(&sd_images, raw_images) != 0)
+            return 0;
+        am_util_stdio_printf("Images from the raw partition (%lu bytes).\r\n", (unsigned long)raw_images->bytes);
+    }
+    else if (dataset_open(&sd_images, SD_DATASET_PATH) != 0)
+        return 0;
+    if (sd_images.header.image_bytes != SD_IMAGE_BYTES || dataset_stride(&sd_images) != SD_IMAGE_BYTES)
+    {
+        am_util_stdio_printf("SD images: %lu bytes each, expected %d\r\n", (unsigned long)sd_images.header.image_bytes,
+                             SD_IMAGE_BYTES);
+        dataset_close(&sd_images);
+        return 0;
+    }
+    return dataset_count(&sd_images);
+}
 
-/** Read one 3072-byte image from SD path into buf. Returns 0 on success, -1 on error. */
-static int read_image_from_sd(const char *path, uint8_t *buf, size_t buf_size)
+#ifdef UART_TEST
+/* UART protocol: every request starts with a command byte. */
+#define UART_CMD_IMAGE 'I'        /* + 3072 image bytes -> {label, distance, tflite_label} */
+#define UART_CMD_IMAGE_TOPK 'K'   /* + uint8 k + 3072 image bytes -> 'I' reply + top-k */
+#define UART_CMD_IMAGE_INT8 'Q'   /* + input_bytes pre-quantized int8 input -> same reply */
+#define UART_CMD_INPUT_INFO 'H'   /* -> input_info_resp, see send_input_info() */
+#define UART_CMD_MODEL_UPDATE 'U' /* model hot-swap, see handle_model_update() */
+#define UART_CMD_TRACE_DUMP 'T'   /* -> ACK + event trace (trace.h), NAK if built without TRACE */
+/* ACK/NAK never occur in printf text, so the host can skip log lines up to them. An unknown
+ * command byte is answered NAK alone and nothing after it is read. */
+#define UART_ACK 0x06
+#define UART_NAK 0x15
+#define UART_MODEL_CHUNK_MAX 1024
+
+/*
+ * Handshake: input tensor parameters, so the host can normalize + quantize images itself
+ * and send them with UART_CMD_IMAGE_INT8 (type 9 = int8; other types only accept 'I').
+ */
+static void send_input_info(void)
 {
-    FIL file;
-    UINT n;
-    if (f_open(&file, path, FA_READ) != FR_OK)
-        return -1;
-    if (f_read(&file, buf, (UINT)buf_size, &n) != FR_OK || n != (UINT)buf_size)
+    model_input_info_t info = {};
+    model_get_input_info(&info);
+    struct __attribute__((packed))
     {
-        f_close(&file);
-        return -1;
+        int32_t type;
+        float scale;
+        int32_t zero_point;
+        int32_t dims[4]; /* tensor shape in its own layout */
+        int32_t layout;  /* 0: N, C, H, W; 1: N, H, W, C */
+        uint32_t bytes;
+        float mean[3];
+        float std[3];
+    } resp;
+    resp.type = info.type;
+    resp.scale = info.scale;
+    resp.zero_point = info.zero_point;
+    for (int i = 0; i < 4; i++)
+        resp.dims[i] = info.dims[i];
+    resp.layout = info.layout;
+    resp.bytes = (uint32_t)info.bytes;
+    for (int c = 0; c < 3; c++)
+    {
+        resp.mean[c] = info.mean[c];
+        resp.std[c] = info.std[c];
     }
-    f_close(&file);
-    return 0;
+    uint8_t reply = UART_ACK;
+    uart_write_bytes(&reply, 1);
+    uart_write_bytes((const uint8_t *)&resp, sizeof(resp));
+}
+
+/* Top-k block after a reply: uint8 count, then count x {uint8 class, uint16 Q15 probability} */
+static void send_topk(int k)
+{
+    int idx[kOutputSize];
+    uint16_t score[kOutputSize];
+    int n = (k > 0) ? model_get_topk(k, idx, score) : 0;
+    uint8_t count = (n > 0) ? (uint8_t)n : 0;
+    uart_write_bytes(&count, 1);
+    for (int i = 0; i < count; i++)
+    {
+        struct __attribute__((packed))
+        {
+            uint8_t cls;
+            uint16_t score;
+        } entry = {(uint8_t)idx[i], score[i]};
+        uart_write_bytes((const uint8_t *)&entry, sizeof(entry));
+    }
+}
+
+/* Pre-quantized query: TFLite classification only (IVF takes raw RGB), reply label -1. */
+static void handle_int8_query(void)
+{
+    model_input_info_t info = {};
+    model_get_input_info(&info);
+    size_t len = 0;
+    int8_t *input = model_get_input_int8(&len);
+    /* Straight into the input tensor; other input types are read and dropped to stay in sync */
+    if (input != nullptr)
+        uart_read_bytes((uint8_t *)input, (uint32_t)len);
+    else
+        for (size_t i = 0; i < info.bytes; i++)
+            uart_getchar();
+
+    struct __attribute__((packed))
+    {
+        int32_t label;
+        float distance;
+        int tflite_label;
+    } resp = {-1, -1.0f, (input != nullptr) ? model_predict_class_int8() : -1};
+    uart_write_bytes((const uint8_t *)&resp, sizeof(resp));
+}
+
+/*
+ * Model update: host sends a model_file_header_t (as in model.bin), then chunks of
+ * {uint16 len, data[len], uint32 crc32(data)}. The header and each chunk are answered ACK,
+ * or NAK + update_resp_t; after the last chunk the device validates the model, dry-runs it
+ * and switches, then answers ACK/NAK + update_resp_t. The model is staged into the loader
+ * slot the running model is not in, so the old model serves requests until the switch
+ * succeeds. Each read gives up after UART_MODEL_TIMEOUT_MS, aborting the update.
+ */
+#define UART_MODEL_TIMEOUT_MS 1000
+#define UPDATE_OK 0
+#define UPDATE_RESEND 1    /* chunk CRC mismatch: send the chunk again */
+#define UPDATE_REJECTED -1 /* bad header, or the model failed validation / dry run */
+#define UPDATE_ABORTED -3  /* read timeout or stream out of sync */
+
+typedef struct __attribute__((packed))
+{
+    int32_t status;
+    uint32_t size;
+    uint32_t downtime_us;
+} update_resp_t;
+
+static void send_update_reply(const update_resp_t *resp)
+{
+    uint8_t reply = (resp->status == UPDATE_OK) ? UART_ACK : UART_NAK;
+    uart_write_bytes(&reply, 1);
+    if (resp->status != UPDATE_OK)
+        uart_write_bytes((const uint8_t *)resp, sizeof(*resp));
+}
+
+static int read_update(void *data, uint32_t len)
+{
+    return uart_read_bytes_timeout((uint8_t *)data, len, UART_MODEL_TIMEOUT_MS);
+}
+
+static void handle_model_update(void)
+{
+    static uint8_t chunk[UART_MODEL_CHUNK_MAX];
+    model_file_header_t header;
+    update_resp_t resp = {UPDATE_OK, 0, 0};
+
+    if (read_update(&header, sizeof(header)) != 0)
+        resp.status = UPDATE_ABORTED;
+    else if (header.magic != MODEL_FILE_MAGIC ||
+             model_loader_stage_begin(header.size, header.crc32, model_active_data()) != 0)
+        resp.status = UPDATE_REJECTED;
+    send_update_reply(&resp);
+    if (resp.status != UPDATE_OK)
+    {
+        am_util_stdio_printf("Model update refused (%ld)\r\n", (long)resp.status);
+        return;
+    }
+
+    uint32_t received = 0;
+    while (received < header.size)
+    {
+        uint16_t len;
+        uint32_t chunk_crc;
+        if (read_update(&len, sizeof(len)) != 0 || len == 0 || len > UART_MODEL_CHUNK_MAX ||
+            read_update(chunk, len) != 0 || read_update(&chunk_crc, sizeof(chunk_crc)) != 0)
+        {
+            /* Host gone or stream out of sync: drop the update, the host restarts it */
+            resp.status = UPDATE_ABORTED;
+            send_update_reply(&resp);
+            am_util_stdio_printf("Model update aborted after %lu bytes\r\n", (unsigned long)received);
+            return;
+        }
+        resp.status = (model_loader_stage_write(chunk, len, chunk_crc) == 0) ? UPDATE_OK : UPDATE_RESEND;
+        if (resp.status == UPDATE_OK)
+            received += len;
+        send_update_reply(&resp);
+    }
+
+    unsigned int model_len = 0;
+    const unsigned char *model = model_loader_stage_finish(&model_len);
+    resp.status = UPDATE_REJECTED;
+    if (model != NULL)
+    {
+        uint32_t downtime_us = 0;
+        resp.status = (model_swap(model, model_len, &downtime_us) == 0) ? UPDATE_OK : UPDATE_REJECTED;
+        resp.size = model_len;
+        resp.downtime_us = downtime_us;
+        am_util_stdio_printf("Model update %s (%u bytes, downtime %lu us)\r\n",
+                             resp.status == UPDATE_OK ? "applied" : "rejected", model_len,
+                             (unsigned long)downtime_us);
+    }
+    /* The final reply always carries the response, ACK included */
+    uint8_t reply = (resp.status == UPDATE_OK) ? UART_ACK : UART_NAK;
+    uart_write_bytes(&reply, 1);
+    uart_write_bytes((const uint8_t *)&resp, sizeof(resp));
+}
+
+/* Event trace for python_scripts/trace_dump.py; recording restarts empty afterwards */
+static void handle_trace_dump(void)
+{
+#ifdef TRACE
+    uint8_t reply = UART_ACK;
+    uart_write_bytes(&reply, 1);
+    trace_dump(uart_write_bytes);
+#else
+    uint8_t reply = UART_NAK;
+    uart_write_bytes(&reply, 1);
+#endif
 }
+#endif
 
 int main(void)
 {
+#ifdef PROFILING
+    mem_paint_stack(); // stack high-water for mem_report()
+#endif
+    tcm_init(); // before any TCM_TEXT code runs
     am_bsp_low_power_init();
+#ifdef PROFILING
+    profiler_init(); // before anything records timestamps
+#endif
+    perf_mode_init(); // 96 MHz; Invoke() and IVF queries burst to 192 MHz
+#ifdef PROFILER_COUNTERS
+    profiler_counters_enable(1); // DWT stall / load-store / exception shares per zone
+#endif
     uart_init();
 
     am_util_stdio_printf("\r\n========================================\r\n");
     am_util_stdio_printf("CIFAR-10 IVF Retrieval on Apollo 4 Plus\r\n");
     am_util_stdio_printf("========================================\r\n\r\n");
 
-    // ML model initialization
-    if (model_init() != 0)
-    {
-        am_util_stdio_printf("Failed to initialize model. Halting.\r\n");
-        while (1)
-        {
-        }
-    }
 
     // SD card initialization
     // Please flash the micro SD card to exFAT system on your laptop; if not, init will fail.
@@ -113,6 +393,32 @@ int main(void)
     }
     am_util_stdio_printf("SD card file system mounted.\r\n");
 
+#ifdef PROFILING
+    profiler_calibrate(); // Verify DWT cycle counter matches CPU clock
+    model_benchmark_weight_placement(cifar10_test_images[0], 10, MODEL_SD_PATH);
+    model_benchmark_depthwise(cifar10_test_images[0], 10);
+    model_benchmark_scratch(cifar10_test_images[0], 10);
+    model_benchmark_perf_mode(cifar10_test_images[0], 10);
+#endif
+
+    // ML model initialization: SD card model if present and valid, else built-in
+    if (model_init_from_sd(MODEL_SD_PATH) != 0)
+    {
+        am_util_stdio_printf("Failed to initialize model. Halting.\r\n");
+        while (1)
+        {
+        }
+    }
+#ifdef MODEL_CASCADE
+    if (model_cascade_init() != 0)
+    {
+        am_util_stdio_printf("Failed to initialize cascade gate model. Halting.\r\n");
+        while (1)
+        {
+        }
+    }
+#endif
+
     // Sanity check for SD + FatFs
     // Read file "log.txt" from SD card and print first line on serial
     FIL file;
@@ -155,43 +461,63 @@ int main(void)
     int32_t label = -1;
     float distance = -1.f;
 
+#ifdef EVAL
+    {
+        // Whole test set: accuracy of both heads and per-stage latency
+        static eval_result_t eval_result;
+        profiler_reset();
+        if (eval_run(EVAL_SD_PATH, 0, bucket_buf, &eval_result) == 0)
+            eval_report(&eval_result);
+    }
+#endif
+
     am_util_stdio_printf("Ready to receive CIFAR-10 images over UART.\r\n");
 
     // Initialize and turn on user LED (LED0)
     am_hal_gpio_pinconfig(AM_BSP_GPIO_LED0, g_AM_BSP_GPIO_LED0);
     am_hal_gpio_state_write(AM_BSP_GPIO_LED0, AM_HAL_GPIO_OUTPUT_CLEAR);
 
+    const int sd_num_images = (int)open_sd_images();
 #ifdef PROFILING
-    profiler_init();
-    profiler_calibrate(); // Verify DWT cycle counter matches CPU clock
-    uint64_t total_ivf_cycles = 0;
-    uint64_t total_tflite_cycles = 0;
-    uint64_t total_embedding_cyc = 0, total_embedding_preprocess_cyc = 0;
-    uint64_t total_embedding_invoke_cyc = 0, total_embedding_get_cyc = 0;
-    uint64_t total_centroid_cyc = 0, total_bucket_load_cyc = 0;
-    uint64_t total_search_cyc = 0, total_label_read_cyc = 0;
+    profiler_reset(); // drop the boot benchmarks' samples
     int successful_iterations = 0;
 #endif
-    for (int i = 0; i < SD_NUM_IMAGES; i++)
-    // for (int j = 0; j < 18; j++)
+    for (int i = 0; i < sd_num_images; i++)
     {
-        // int i = 16;
 #ifndef PROFILING
-        am_util_stdio_printf("[%d/%d]\r\n", i, SD_NUM_IMAGES);
+        am_util_stdio_printf("[%d/%d]\r\n", i, sd_num_images);
 #endif
-        char path[24];
-        snprintf(path, sizeof(path), "%s/%d.bin", SD_IMAGE_DIR, i);
-        if (read_image_from_sd(path, image, SD_IMAGE_BYTES) != 0)
+        TRACE_INSTANT("sd.image", i);
+        PROFILE_BEGIN("sd.image");
+        int read_status = dataset_read(&sd_images, (uint32_t)i, 1, image, SD_IMAGE_BYTES);
+        PROFILE_END("sd.image");
+        if (read_status != 0)
         {
 #ifndef PROFILING
-            am_util_stdio_printf("Failed to read %s\r\n", path);
+            am_util_stdio_printf("Failed to read image %d of %s\r\n", i, SD_DATASET_PATH);
 #endif
             continue;
         }
+#ifdef MODEL_CASCADE
+        // Stage 0: confident gate answers skip the full model and IVF
+        int gate_label;
+        perf_mode_burst_begin();
+        int gate_hit = model_cascade_gate(image, &gate_label, NULL);
+        perf_mode_burst_end();
+        if (gate_hit == 1)
+        {
+#ifndef PROFILING
+            am_util_stdio_printf("Processed one image: gate label=%d\r\n", gate_label);
+#endif
+            continue;
+        }
+#endif
+        perf_mode_burst_begin(); // IVF search + classification at 192 MHz
 #ifdef PROFILING
         ivf_profile_t ivf_profile;
-        uint32_t t0 = profiler_cycles();
+        uint64_t query_start = perf_mode_burst_cycles();
 #endif
+        PROFILE_BEGIN("query.ivf");
         int ret = ivf_retrieve_closest(
             image,
             bucket_buf,
@@ -199,49 +525,39 @@ int main(void)
             &distance,
 #ifdef PROFILING
             &ivf_profile,
-            profiler_cycles
+            ivf_cycles
 #else
             NULL,
             NULL
 #endif
         );
-#ifdef PROFILING
-        uint32_t ivf_cycles = profiler_cycles() - t0;
-#endif
+        PROFILE_END("query.ivf");
 
-        int tflite_label;
+        PROFILE_BEGIN("query.tflite");
+        int tflite_label = model_predict_class(image);
+        PROFILE_END("query.tflite");
 #ifdef PROFILING
-        t0 = profiler_cycles();
+        profiler_zone_add(profiler_zone("query.full"), perf_mode_burst_cycles() - query_start, perf_mode_burst_hz());
 #endif
-        tflite_label = model_predict_class(image);
+        perf_mode_burst_end();
 #ifdef PROFILING
-        uint32_t tflite_cycles = profiler_cycles() - t0;
-        /* Report total IVF and per-step CPU cycles; 1 ms = 96k cycles */
+        /* Report total IVF and per-step CPU cycles (at perf_mode_burst_hz()) */
         am_util_stdio_printf("[%d] IVF: %lu cyc (emb:%lu cen:%lu bucket:%lu search:%lu label:%lu) TFLite: %lu cyc\r\n",
-                             i, (unsigned long)ivf_cycles,
+                             i, (unsigned long)zone_last("query.ivf"),
                              (unsigned long)ivf_profile.embedding_cyc,
                              (unsigned long)ivf_profile.centroid_cyc,
                              (unsigned long)ivf_profile.bucket_load_cyc,
                              (unsigned long)ivf_profile.search_cyc,
                              (unsigned long)ivf_profile.label_read_cyc,
-                             (unsigned long)tflite_cycles);
+                             (unsigned long)zone_last("query.tflite"));
         am_util_stdio_printf("  embedding: preprocess %lu (%.2f ms) invoke %lu (%.2f ms) get_emb %lu (%.2f ms)\r\n",
                              (unsigned long)ivf_profile.embedding_preprocess_cyc,
-                             (double)ivf_profile.embedding_preprocess_cyc / 96000.0,
+                             query_ms(ivf_profile.embedding_preprocess_cyc),
                              (unsigned long)ivf_profile.embedding_invoke_cyc,
-                             (double)ivf_profile.embedding_invoke_cyc / 96000.0,
+                             query_ms(ivf_profile.embedding_invoke_cyc),
                              (unsigned long)ivf_profile.embedding_get_cyc,
-                             (double)ivf_profile.embedding_get_cyc / 96000.0);
-        total_ivf_cycles += ivf_cycles;
-        total_tflite_cycles += tflite_cycles;
-        total_embedding_cyc += ivf_profile.embedding_cyc;
-        total_embedding_preprocess_cyc += ivf_profile.embedding_preprocess_cyc;
-        total_embedding_invoke_cyc += ivf_profile.embedding_invoke_cyc;
-        total_embedding_get_cyc += ivf_profile.embedding_get_cyc;
-        total_centroid_cyc += ivf_profile.centroid_cyc;
-        total_bucket_load_cyc += ivf_profile.bucket_load_cyc;
-        total_search_cyc += ivf_profile.search_cyc;
-        total_label_read_cyc += ivf_profile.label_read_cyc;
+                             query_ms(ivf_profile.embedding_get_cyc));
+        add_ivf_profile(&ivf_profile);
         successful_iterations++;
 #else
         (void)tflite_label; /* may be unused if only IVF result is used */
@@ -254,64 +570,141 @@ int main(void)
             continue;
         }
 #ifndef PROFILING
-        am_util_stdio_printf("Processed one image: IVF label=%d, distance=%.4f, TFLite label=%d\r\n",
-                             (int)label, (double)distance, tflite_label);
+        am_util_stdio_printf("Processed one image: IVF label=%d, distance=%.4f, TFLite label=%d, true label=%d\r\n",
+                             (int)label, (double)distance, tflite_label, dataset_label(&sd_images, (uint32_t)i));
 #endif
     }
 
 #ifdef PROFILING
-    /* Print average cycles and per-step breakdown */
-    if (successful_iterations > 0)
+    /* Per-zone cycles: mean, min, max, p50, p99 */
+    am_util_stdio_printf("\r\n--- Summary ---\r\n");
+    am_util_stdio_printf("Processed %d images\r\n", successful_iterations);
+    profiler_report();
+    perf_mode_report();
+    {
+        mem_arena_usage_t arenas[kMaxModels + 1];
+        mem_report(arenas, model_runtime_arena_usage(arenas, kMaxModels + 1));
+    }
+#ifdef MODEL_CASCADE
+    report_cascade();
+#endif
+#endif
+
+#if SD_BATCH_SIZE > 0
+    /* Batched TFLite classification of the same SD images */
     {
-        uint64_t n = (uint64_t)successful_iterations;
-        uint64_t avg_ivf = total_ivf_cycles / n;
-        uint64_t avg_emb = total_embedding_cyc / n, avg_cen = total_centroid_cyc / n;
-        uint64_t avg_bucket = total_bucket_load_cyc / n;
-        uint64_t avg_search = total_search_cyc / n, avg_label = total_label_read_cyc / n;
-        uint64_t avg_tflite_cycles = total_tflite_cycles / n;
-        am_util_stdio_printf("\r\n--- Summary ---\r\n");
-        am_util_stdio_printf("Processed %d images\r\n", successful_iterations);
-        am_util_stdio_printf("Average IVF total: %llu cyc (%.2f ms)\r\n",
-                             (unsigned long long)avg_ivf, (double)avg_ivf / 96000.0);
-        am_util_stdio_printf("  embedding:   %llu cyc (%.2f ms)\r\n",
-                             (unsigned long long)avg_emb, (double)avg_emb / 96000.0);
+        static uint8_t batch_images[SD_BATCH_SIZE][SD_IMAGE_BYTES] __attribute__((section(".shared_bss")));
+        const uint8_t *batch_ptrs[SD_BATCH_SIZE];
+        model_batch_output_t batch_out[SD_BATCH_SIZE];
+        model_batch_timing_t batch_timing;
+        for (int first = 0; first < sd_num_images; first += SD_BATCH_SIZE)
         {
-            uint64_t avg_pre = total_embedding_preprocess_cyc / n, avg_inv = total_embedding_invoke_cyc / n;
-            uint64_t avg_get = total_embedding_get_cyc / n;
-            am_util_stdio_printf("    preprocess: %llu cyc (%.2f ms)\r\n",
-                                 (unsigned long long)avg_pre, (double)avg_pre / 96000.0);
-            am_util_stdio_printf("    invoke:     %llu cyc (%.2f ms)\r\n",
-                                 (unsigned long long)avg_inv, (double)avg_inv / 96000.0);
-            am_util_stdio_printf("    get_emb:    %llu cyc (%.2f ms)\r\n",
-                                 (unsigned long long)avg_get, (double)avg_get / 96000.0);
+            int n = sd_num_images - first < SD_BATCH_SIZE ? sd_num_images - first : SD_BATCH_SIZE;
+            // Records are SD_IMAGE_BYTES apart on the card too: the whole batch is one read
+            if (dataset_read(&sd_images, (uint32_t)first, (uint32_t)n, batch_images[0], sizeof(batch_images)) != 0)
+                continue;
+            for (int k = 0; k < n; k++)
+            {
+                batch_ptrs[k] = batch_images[k];
+                batch_out[k].embedding = NULL;
+                batch_out[k].embedding_dim = 0;
+            }
+            perf_mode_burst_begin();
+            int done = model_run_batch(batch_ptrs, n, batch_out, &batch_timing);
+            perf_mode_burst_end();
+#ifdef PROFILING
+            uint64_t batch_cyc = batch_timing.preprocess_cyc + batch_timing.invoke_cyc + batch_timing.output_cyc;
+            am_util_stdio_printf("[batch %d] %d/%d images, %lu invokes: preprocess %llu invoke %llu output %llu cyc (%.2f ms/image)\r\n",
+                                 first / SD_BATCH_SIZE, done, n, (unsigned long)batch_timing.invokes,
+                                 (unsigned long long)batch_timing.preprocess_cyc,
+                                 (unsigned long long)batch_timing.invoke_cyc,
+                                 (unsigned long long)batch_timing.output_cyc,
+                                 query_ms(batch_cyc / n));
+            for (int k = 0; k < n; k++)
+                profiler_zone_add(profiler_zone("batch.image"), batch_cyc / n, perf_mode_burst_hz());
+#else
+            for (int k = 0; k < n; k++)
+                am_util_stdio_printf("[batch %d] TFLite label=%d\r\n", first / SD_BATCH_SIZE, batch_out[k].label);
+            (void)done;
+#endif
         }
-        am_util_stdio_printf("  centroid:    %llu cyc (%.2f ms)\r\n",
-                             (unsigned long long)avg_cen, (double)avg_cen / 96000.0);
-        am_util_stdio_printf("  bucket_load: %llu cyc (%.2f ms)\r\n",
-                             (unsigned long long)avg_bucket, (double)avg_bucket / 96000.0);
-        am_util_stdio_printf("  search:      %llu cyc (%.2f ms)\r\n",
-                             (unsigned long long)avg_search, (double)avg_search / 96000.0);
-        am_util_stdio_printf("  label_read:  %llu cyc (%.2f ms)\r\n",
-                             (unsigned long long)avg_label, (double)avg_label / 96000.0);
-        am_util_stdio_printf("Average TFLite: %llu cyc (%.2f ms)\r\n",
-                             (unsigned long long)avg_tflite_cycles, (double)avg_tflite_cycles / 96000.0);
-        am_util_stdio_printf("--- End Summary ---\r\n\r\n");
+#ifdef PROFILING
+        profiler_stats_t batch_stats;
+        if (profiler_zone_stats(profiler_zone("batch.image"), &batch_stats) == 0 && batch_stats.count > 0)
+            am_util_stdio_printf("Average TFLite (batch %d): %llu cyc (%.2f ms)\r\n\r\n", SD_BATCH_SIZE,
+                                 (unsigned long long)batch_stats.mean, query_ms(batch_stats.mean));
+#endif
     }
 #endif
+    if (sd_num_images > 0)
+        dataset_close(&sd_images);
 
     // Main loop for UART testing
     while (1)
     {
         // Populate input image either from UART (live) or from a built-in test image.
 #ifdef UART_TEST
+        int cmd = uart_getchar();
+        if (cmd == UART_CMD_MODEL_UPDATE)
+        {
+            handle_model_update();
+            continue;
+        }
+        if (cmd == UART_CMD_TRACE_DUMP)
+        {
+            handle_trace_dump();
+            continue;
+        }
+        if (cmd == UART_CMD_INPUT_INFO)
+        {
+            send_input_info();
+            continue;
+        }
+        if (cmd == UART_CMD_IMAGE_INT8)
+        {
+            handle_int8_query();
+            continue;
+        }
+        int topk = 0;
+        if (cmd == UART_CMD_IMAGE_TOPK)
+            topk = uart_getchar() & 0xFF;
+        else if (cmd != UART_CMD_IMAGE)
+        {
+            /* Unknown command (e.g. a legacy request without one): tell the host to resync */
+            uint8_t reply = UART_NAK;
+            uart_write_bytes(&reply, 1);
+            continue;
+        }
+
         // Read one image (3072 bytes) from UART
-        for (int i = 0; i < INPUT_HEIGHT * INPUT_WIDTH * INPUT_CHANNELS; i++)
+        PROFILE_BEGIN("uart.image");
+        uart_read_bytes(image, INPUT_HEIGHT * INPUT_WIDTH * INPUT_CHANNELS);
+        PROFILE_END("uart.image");
+
+#ifdef MODEL_CASCADE
+        // Stage 0: gate answer is returned as both labels; distance -1 marks skipped IVF
+        int gate_label;
+        perf_mode_burst_begin();
+        int gate_hit = model_cascade_gate(image, &gate_label, NULL);
+        perf_mode_burst_end();
+        if (gate_hit == 1)
         {
-            int c = uart_getchar();
-            image[i] = (uint8_t)c;
+            struct __attribute__((packed))
+            {
+                int32_t label;
+                float distance;
+                int tflite_label;
+            } gate_resp = {gate_label, -1.0f, gate_label};
+            uart_write_bytes((const uint8_t *)&gate_resp, sizeof(gate_resp));
+            if (cmd == UART_CMD_IMAGE_TOPK)
+                send_topk(0); // full model did not run
+            continue;
         }
+#endif
 
-        // Run IVF retrieval
+        // Run IVF retrieval and classification at 192 MHz (UART waits stay at 96 MHz)
+        perf_mode_burst_begin();
+        PROFILE_BEGIN("query.ivf");
         int ret = ivf_retrieve_closest(
             image,
             bucket_buf,
@@ -319,6 +712,13 @@ int main(void)
             &distance,
             NULL,
             NULL);
+        PROFILE_END("query.ivf");
+
+        // Run TFLite model classification
+        PROFILE_BEGIN("query.tflite");
+        int tflite_label = model_predict_class(image);
+        PROFILE_END("query.tflite");
+        perf_mode_burst_end();
 
         if (ret != 0)
         {
@@ -331,9 +731,6 @@ int main(void)
             f_mount(&FatFs, "", 1);
         }
 
-        // Run TFLite model classification
-        int tflite_label = model_predict_class(image);
-
         // Pack response as: int32 label, float32 distance (little-endian)
         struct __attribute__((packed))
         {
@@ -347,6 +744,8 @@ int main(void)
         resp.tflite_label = tflite_label;
 
         uart_write_bytes((const uint8_t *)&resp, sizeof(resp));
+        if (cmd == UART_CMD_IMAGE_TOPK)
+            send_topk(topk);
 #else
         am_hal_delay_us(1000000);
 #endif
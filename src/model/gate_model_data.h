@@ -0,0 +1,9 @@
+#ifndef GATE_MODEL_DATA_H_
+#define GATE_MODEL_DATA_H_
+
+// Cascade gate classifier (small int8 CIFAR-10 model). gate_model_data.cc is generated by
+// python_scripts/make_gate_model.py; make CASCADE=1 builds and links it.
+extern const unsigned char g_gate_model_data[];
+extern const unsigned int g_gate_model_data_len;
+
+#endif  // GATE_MODEL_DATA_H_
@@ -0,0 +1,317 @@
+#include "depthwise_3x3.h"
+#include "kernel_util.h"
+#include "shared_scratch.h"
+
+#include "tensorflow/lite/micro/micro_context.h"
+#include "profiler.h"
+#include "tcm.h"
+#include "am_util.h"
+
+// Depthwise layers tracked for the PROFILING report
+static constexpr int kMaxDepthwiseLayers = 32;
+
+struct Depthwise3x3Data
+{
+    void *generic_data; // user_data of the generic kernel
+    bool fast;          // this node runs the 3x3 kernel
+
+    int32_t *multiplier; // per channel
+    int *shift;
+    int32_t input_offset;
+    int32_t output_offset;
+    int32_t act_min;
+    int32_t act_max;
+    int stride;
+    int pad_h;
+    int pad_w;
+
+#ifdef PROFILING
+    int in_h;
+    int in_w;
+    int channels;
+    uint32_t cycles;
+    uint32_t invokes;
+#endif
+};
+
+#ifdef PROFILING
+static bool fast_enabled = true;
+static Depthwise3x3Data *layers[kMaxDepthwiseLayers];
+static int layer_count = 0;
+static uint32_t baseline[kMaxDepthwiseLayers]; // cycles per invoke, 0 = none
+static int baseline_count = 0;
+#else
+static constexpr bool fast_enabled = true;
+#endif
+
+static const TfLiteRegistration &generic_registration(void)
+{
+    static const TfLiteRegistration r = Register_DEPTHWISE_CONV_2D_SHARED_SCRATCH();
+    return r;
+}
+
+// Call a generic kernel function with the generic kernel's user_data in place
+static TfLiteStatus run_generic(TfLiteStatus (*fn)(TfLiteContext *, TfLiteNode *), TfLiteContext *context,
+                                TfLiteNode *node, Depthwise3x3Data *data)
+{
+    node->user_data = data->generic_data;
+    TfLiteStatus status = fn(context, node);
+    node->user_data = data;
+    return status;
+}
+
+static void *dw3x3_init(TfLiteContext *context, const char *buffer, size_t length)
+{
+    Depthwise3x3Data *data =
+        static_cast<Depthwise3x3Data *>(context->AllocatePersistentBuffer(context, sizeof(Depthwise3x3Data)));
+    if (data == nullptr)
+        return nullptr;
+    memset(data, 0, sizeof(*data));
+    const TfLiteRegistration &generic = generic_registration();
+    data->generic_data = (generic.init != nullptr) ? generic.init(context, buffer, length) : nullptr;
+    return data;
+}
+
+// Set up the 3x3 kernel for this node; false if its parameters do not match
+static bool prepare_3x3(TfLiteContext *context, TfLiteNode *node, const TfLiteDepthwiseConvParams *params,
+                        Depthwise3x3Data *data)
+{
+    const int stride = params->stride_width;
+    if (params->stride_height != stride || (stride != 1 && stride != 2) || params->dilation_width_factor != 1 ||
+        params->dilation_height_factor != 1)
+        return false;
+
+    tflite::MicroContext *micro_context = tflite::GetMicroContext(context);
+    TfLiteTensor *input = micro_context->AllocateTempInputTensor(node, 0);
+    TfLiteTensor *filter = micro_context->AllocateTempInputTensor(node, 1);
+    TfLiteTensor *output = micro_context->AllocateTempOutputTensor(node, 0);
+
+    bool match = input != nullptr && filter != nullptr && output != nullptr && input->type == kTfLiteInt8 &&
+                 filter->type == kTfLiteInt8 && output->type == kTfLiteInt8 && filter->dims->size == 4 &&
+                 filter->dims->data[0] == 1 && filter->dims->data[1] == 3 && filter->dims->data[2] == 3 &&
+                 filter->dims->data[3] == input->dims->data[3] && output->dims->data[3] == input->dims->data[3] &&
+                 filter->quantization.type == kTfLiteAffineQuantization;
+    const TfLiteAffineQuantization *quant =
+        match ? static_cast<const TfLiteAffineQuantization *>(filter->quantization.params) : nullptr;
+    const int channels = match ? input->dims->data[3] : 0;
+    match = match && quant != nullptr && quant->scale->size == channels;
+
+    if (match)
+    {
+        data->stride = stride;
+        data->input_offset = -input->params.zero_point;
+        data->output_offset = output->params.zero_point;
+        kernel_activation_range(params->activation, output->params.scale, output->params.zero_point,
+                                &data->act_min, &data->act_max);
+        data->pad_h = kernel_padding(params->padding, input->dims->data[1], 3, stride, 1, output->dims->data[1]);
+        data->pad_w = kernel_padding(params->padding, input->dims->data[2], 3, stride, 1, output->dims->data[2]);
+        match = kernel_channel_multipliers(context, input->params.scale, quant->scale->data, output->params.scale,
+                                           channels, &data->multiplier, &data->shift) == kTfLiteOk;
+    }
+
+    if (input != nullptr)
+        micro_context->DeallocateTempTfLiteTensor(input);
+    if (filter != nullptr)
+        micro_context->DeallocateTempTfLiteTensor(filter);
+    if (output != nullptr)
+        micro_context->DeallocateTempTfLiteTensor(output);
+    return match;
+}
+
+static TfLiteStatus dw3x3_prepare(TfLiteContext *context, TfLiteNode *node)
+{
+    Depthwise3x3Data *data = static_cast<Depthwise3x3Data *>(node->user_data);
+    if (data == nullptr)
+        return kTfLiteError;
+    const TfLiteDepthwiseConvParams *params = static_cast<const TfLiteDepthwiseConvParams *>(node->builtin_data);
+    data->stride = (params != nullptr) ? params->stride_width : 0;
+    data->fast = fast_enabled && params != nullptr && prepare_3x3(context, node, params, data);
+
+#ifdef PROFILING
+    tflite::MicroContext *micro_context = tflite::GetMicroContext(context);
+    TfLiteTensor *input = micro_context->AllocateTempInputTensor(node, 0);
+    if (input != nullptr)
+    {
+        data->in_h = input->dims->data[1];
+        data->in_w = input->dims->data[2];
+        data->channels = input->dims->data[3];
+        micro_context->DeallocateTempTfLiteTensor(input);
+    }
+    bool tracked = false;
+    for (int i = 0; i < layer_count; i++)
+        tracked = tracked || layers[i] == data;
+    if (!tracked && layer_count < kMaxDepthwiseLayers)
+        layers[layer_count++] = data;
+#endif
+
+    if (data->fast)
+        return kTfLiteOk;
+    return run_generic(generic_registration().prepare, context, node, data);
+}
+
+// Input value + offset, 0 in the padding
+static inline int32_t pixel(const int8_t *row, int ix, int in_w, int channels, int32_t offset)
+{
+    return (row != nullptr && ix >= 0 && ix < in_w) ? row[ix * channels] + offset : 0;
+}
+
+// Two int16 lanes: lo in bits 0-15, hi in bits 16-31
+static inline uint32_t pack16(int32_t lo, int32_t hi)
+{
+    return static_cast<uint32_t>(static_cast<uint16_t>(lo)) | (static_cast<uint32_t>(hi) << 16);
+}
+
+TCM_TEXT static TfLiteStatus dw3x3_eval_fast(TfLiteContext *context, TfLiteNode *node,
+                                              const Depthwise3x3Data *data)
+{
+    const TfLiteEvalTensor *input = kernel_eval_input(context, node, 0);
+    const TfLiteEvalTensor *filter = kernel_eval_input(context, node, 1);
+    const TfLiteEvalTensor *bias = kernel_eval_input(context, node, 2);
+    TfLiteEvalTensor *output = kernel_eval_output(context, node, 0);
+
+    const int batches = input->dims->data[0];
+    const int in_h = input->dims->data[1], in_w = input->dims->data[2], channels = input->dims->data[3];
+    const int out_h = output->dims->data[1], out_w = output->dims->data[2];
+    const int stride = data->stride;
+    const int8_t *weights = filter->data.int8; // [1, 3, 3, C]
+    const int32_t *bias_data = (bias != nullptr) ? bias->data.i32 : nullptr;
+    const int32_t offset = data->input_offset;
+
+    for (int batch = 0; batch < batches; batch++)
+    {
+        const int8_t *in = input->data.int8 + batch * in_h * in_w * channels;
+        int8_t *out = output->data.int8 + batch * out_h * out_w * channels;
+        for (int c = 0; c < channels; c++)
+        {
+            // Filter row r: (w[r][0], w[r][1]) as one SMLAD operand, w[r][2] on its own
+            uint32_t w01[3];
+            int32_t w2[3];
+            for (int r = 0; r < 3; r++)
+            {
+                w01[r] = pack16(weights[(r * 3) * channels + c], weights[(r * 3 + 1) * channels + c]);
+                w2[r] = weights[(r * 3 + 2) * channels + c];
+            }
+            const int32_t bias_c = (bias_data != nullptr) ? bias_data[c] : 0;
+
+            for (int oy = 0; oy < out_h; oy++)
+            {
+                const int8_t *rows[3];
+                for (int r = 0; r < 3; r++)
+                {
+                    int iy = oy * stride - data->pad_h + r;
+                    rows[r] = (iy >= 0 && iy < in_h) ? in + iy * in_w * channels + c : nullptr;
+                }
+
+                // Window: columns (ix, ix + 1) packed in x01, column ix + 2 in x2
+                int ix = -data->pad_w;
+                uint32_t x01[3];
+                int32_t x2[3];
+                for (int r = 0; r < 3; r++)
+                {
+                    x01[r] = pack16(pixel(rows[r], ix, in_w, channels, offset),
+                                    pixel(rows[r], ix + 1, in_w, channels, offset));
+                    x2[r] = pixel(rows[r], ix + 2, in_w, channels, offset);
+                }
+
+                int8_t *o = out + oy * out_w * channels + c;
+                for (int ox = 0; ox < out_w; ox++)
+                {
+                    int32_t acc = bias_c;
+                    for (int r = 0; r < 3; r++)
+                        acc = kernel_smlad(x01[r], w01[r], acc) + x2[r] * w2[r];
+                    acc = kernel_requantize(acc, data->multiplier[c], data->shift[c]) + data->output_offset;
+                    o[ox * channels] = kernel_clamp_int8(acc, data->act_min, data->act_max);
+
+                    // Slide the window by one or two columns
+                    for (int r = 0; r < 3; r++)
+                    {
+                        if (stride == 1)
+                        {
+                            x01[r] = (x01[r] >> 16) | (static_cast<uint32_t>(x2[r]) << 16);
+                            x2[r] = pixel(rows[r], ix + 3, in_w, channels, offset);
+                        }
+                        else
+                        {
+                            x01[r] = pack16(x2[r], pixel(rows[r], ix + 3, in_w, channels, offset));
+                            x2[r] = pixel(rows[r], ix + 4, in_w, channels, offset);
+                        }
+                    }
+                    ix += stride;
+                }
+            }
+        }
+    }
+    return kTfLiteOk;
+}
+
+static TfLiteStatus dw3x3_eval(TfLiteContext *context, TfLiteNode *node)
+{
+#ifdef PROFILING
+    uint32_t t0 = profiler_get_cycles();
+#endif
+    Depthwise3x3Data *data = static_cast<Depthwise3x3Data *>(node->user_data);
+    TfLiteStatus status = data->fast ? dw3x3_eval_fast(context, node, data)
+                                     : run_generic(generic_registration().invoke, context, node, data);
+#ifdef PROFILING
+    data->cycles += profiler_get_cycles() - t0;
+    data->invokes++;
+#endif
+    return status;
+}
+
+TfLiteRegistration Register_DEPTHWISE_CONV_2D_3X3(void)
+{
+    TfLiteRegistration r = generic_registration();
+    r.init = dw3x3_init;
+    r.free = nullptr;
+    r.prepare = dw3x3_prepare;
+    r.invoke = dw3x3_eval;
+    return r;
+}
+
+#ifdef PROFILING
+void depthwise_3x3_set_enabled(bool enabled)
+{
+    fast_enabled = enabled;
+}
+
+void depthwise_3x3_reset_stats(void)
+{
+    layer_count = 0;
+}
+
+int depthwise_3x3_stats_mark(void)
+{
+    return layer_count;
+}
+
+void depthwise_3x3_stats_rewind(int mark)
+{
+    if (mark < layer_count)
+        layer_count = mark;
+}
+
+void depthwise_3x3_save_baseline(void)
+{
+    for (int i = 0; i < layer_count; i++)
+        baseline[i] = layers[i]->invokes ? layers[i]->cycles / layers[i]->invokes : 0;
+    baseline_count = layer_count;
+}
+
+void depthwise_3x3_report(void)
+{
+    if (layer_count == 0)
+        return;
+    am_util_stdio_printf("\r\n--- Depthwise layers ---\r\n");
+    for (int i = 0; i < layer_count; i++)
+    {
+        const Depthwise3x3Data *data = layers[i];
+        uint32_t avg = data->invokes ? data->cycles / data->invokes : 0;
+        am_util_stdio_printf("dw %dx%dx%d s%d %s: %lu cyc/invoke", data->in_h, data->in_w, data->channels,
+                             data->stride, data->fast ? "3x3" : "generic", (unsigned long)avg);
+        if (i < baseline_count && baseline[i] > 0)
+            am_util_stdio_printf(" (baseline %lu, %.1f%%)", (unsigned long)baseline[i], 100.0 * avg / baseline[i]);
+        am_util_stdio_printf("\r\n");
+    }
+}
+#endif
@@ -0,0 +1,37 @@
+#ifndef DEPTHWISE_3X3_H_
+#define DEPTHWISE_3X3_H_
+
+#include <stdint.h>
+
+#include "tensorflow/lite/c/common.h"
+
+// DEPTHWISE_CONV_2D registration with a specialized int8 3x3 path.
+//
+// Prepare checks each node: int8 input/output, per-channel int8 3x3 filter, depth
+// multiplier 1, stride 1 or 2 (same in both directions) and no dilation take the
+// specialized kernel; every other node runs the CMSIS-NN kernel (with shared scratch) unchanged.
+// Per channel and output row, the 3x3 input window stays in registers as int16 pairs and
+// slides by one or two columns (one or two loads per row per output), with one SMLAD and
+// one MLA per filter row.
+TfLiteRegistration Register_DEPTHWISE_CONV_2D_3X3(void);
+
+#ifdef PROFILING
+// Route new nodes to the generic kernel (takes effect when the model is next loaded)
+void depthwise_3x3_set_enabled(bool enabled);
+
+// Remember the current per-layer cycles as the baseline for the next report
+void depthwise_3x3_save_baseline(void);
+
+// Per-layer cycles of the depthwise ops run so far (vs the saved baseline, if any)
+void depthwise_3x3_report(void);
+
+// Forget tracked layers (call when the models are rebuilt).
+void depthwise_3x3_reset_stats(void);
+
+// Layers tracked so far / forget the layers tracked after that mark (op data of a dry-run
+// build, already torn down).
+int depthwise_3x3_stats_mark(void);
+void depthwise_3x3_stats_rewind(int mark);
+#endif
+
+#endif // DEPTHWISE_3X3_H_
@@ -0,0 +1,374 @@
+#include "int4_kernels.h"
+#include "kernel_util.h"
+#include "shared_scratch.h"
+
+#include "tensorflow/lite/micro/micro_context.h"
+#include "profiler.h"
+#include "tcm.h"
+#include "am_util.h"
+
+// Int4 layers tracked for the PROFILING report
+static constexpr int kMaxInt4Layers = 32;
+
+struct Int4OpData
+{
+    const int4_weights_header_t *header;
+    const float *filter_scale;
+    const uint8_t *weights;
+    int k;         // weights per output channel (conv / FC)
+    int row_bytes; // packed bytes per output channel (conv / FC) or per tap (depthwise)
+
+    int32_t *multiplier; // per output channel
+    int *shift;
+    int32_t input_offset;
+    int32_t output_offset;
+    int32_t act_min;
+    int32_t act_max;
+    int pad_h;
+    int pad_w;
+    int scratch; // conv / FC: interleaved int16 input patch; depthwise: int32 accumulators
+
+#ifdef PROFILING
+    uint32_t cycles;
+    uint32_t invokes;
+#endif
+};
+
+#ifdef PROFILING
+static Int4OpData *layers[kMaxInt4Layers];
+static int layer_count = 0;
+#endif
+
+static size_t weight_bytes(const Int4OpData *data)
+{
+    const int4_weights_header_t *h = data->header;
+    if (h->op == INT4_OP_DEPTHWISE_CONV_2D)
+        return static_cast<size_t>(h->kernel_h * h->kernel_w) * data->row_bytes;
+    return static_cast<size_t>(h->out_channels) * data->row_bytes;
+}
+
+static void *int4_init(TfLiteContext *context, const char *buffer, size_t length)
+{
+    const int4_weights_header_t *header = reinterpret_cast<const int4_weights_header_t *>(buffer);
+    if (buffer == nullptr || length < sizeof(*header) || header->magic != INT4_WEIGHTS_MAGIC)
+        return nullptr;
+
+    Int4OpData *data = static_cast<Int4OpData *>(context->AllocatePersistentBuffer(context, sizeof(Int4OpData)));
+    if (data == nullptr)
+        return nullptr;
+    memset(data, 0, sizeof(*data));
+    data->header = header;
+    data->k = header->kernel_h * header->kernel_w * header->in_channels;
+    if (header->op == INT4_OP_DEPTHWISE_CONV_2D)
+        data->row_bytes = (header->out_channels + 1) / 2;
+    else
+        data->row_bytes = (data->k + 7) / 8 * 4;
+
+    const int out_channels = header->out_channels;
+    if (length < sizeof(*header) + out_channels * sizeof(float) + weight_bytes(data))
+        return nullptr;
+    data->filter_scale = reinterpret_cast<const float *>(header + 1);
+    data->weights = reinterpret_cast<const uint8_t *>(data->filter_scale + out_channels);
+    return data;
+}
+
+static TfLiteStatus int4_prepare(TfLiteContext *context, TfLiteNode *node)
+{
+    Int4OpData *data = static_cast<Int4OpData *>(node->user_data);
+    if (data == nullptr)
+    {
+        am_util_stdio_printf("Int4 op: missing or invalid custom options.\r\n");
+        return kTfLiteError;
+    }
+    const int4_weights_header_t *header = data->header;
+    if (header->op == INT4_OP_DEPTHWISE_CONV_2D && header->in_channels != header->out_channels)
+    {
+        am_util_stdio_printf("Int4 op: depthwise needs depth multiplier 1.\r\n");
+        return kTfLiteError;
+    }
+    tflite::MicroContext *micro_context = tflite::GetMicroContext(context);
+    TfLiteTensor *input = micro_context->AllocateTempInputTensor(node, 0);
+    TfLiteTensor *output = micro_context->AllocateTempOutputTensor(node, 0);
+    if (input == nullptr || output == nullptr || input->type != kTfLiteInt8 || output->type != kTfLiteInt8)
+    {
+        am_util_stdio_printf("Int4 op: int8 input/output required.\r\n");
+        return kTfLiteError;
+    }
+
+    data->input_offset = -input->params.zero_point;
+    data->output_offset = output->params.zero_point;
+    kernel_activation_range(static_cast<TfLiteFusedActivation>(header->activation), output->params.scale,
+                            output->params.zero_point, &data->act_min, &data->act_max);
+    if (kernel_channel_multipliers(context, input->params.scale, data->filter_scale, output->params.scale,
+                                   header->out_channels, &data->multiplier, &data->shift) != kTfLiteOk)
+        return kTfLiteError;
+
+    if (header->op != INT4_OP_FULLY_CONNECTED)
+    {
+        // NHWC input [1, H, W, C], output [1, OH, OW, OC]
+        data->pad_h = kernel_padding(static_cast<TfLitePadding>(header->padding), input->dims->data[1],
+                                     header->kernel_h, header->stride_h, header->dilation_h, output->dims->data[1]);
+        data->pad_w = kernel_padding(static_cast<TfLitePadding>(header->padding), input->dims->data[2],
+                                     header->kernel_w, header->stride_w, header->dilation_w, output->dims->data[2]);
+    }
+
+    micro_context->DeallocateTempTfLiteTensor(input);
+    micro_context->DeallocateTempTfLiteTensor(output);
+
+    size_t scratch_bytes = (header->op == INT4_OP_DEPTHWISE_CONV_2D)
+                               ? header->out_channels * sizeof(int32_t)
+                               : data->row_bytes * 2 * sizeof(int16_t);
+    TfLiteStatus status = shared_scratch_request(context, "int4", scratch_bytes, &data->scratch);
+#ifdef PROFILING
+    bool tracked = false;
+    for (int i = 0; i < layer_count; i++)
+        tracked = tracked || layers[i] == data;
+    if (!tracked && layer_count < kMaxInt4Layers)
+        layers[layer_count++] = data;
+#endif
+    return status;
+}
+
+// Position of flattened weight index k in the interleaved patch. A weight word holds
+// nibbles n0..n7 (bytes {n0,n1}, {n2,n3}, ...); SXTB16 of (w << 4) and w, each masked
+// with 0xF0F0F0F0, and the same on w ror 8 yields the lane pairs (n0,n4), (n1,n5), (n2,n6), (n3,n7), each
+// scaled by 16, so inputs are stored as [x0, x4, x1, x5, x2, x6, x3, x7].
+static inline int patch_slot(int k)
+{
+    static const uint8_t interleave[8] = {0, 2, 4, 6, 1, 3, 5, 7};
+    return (k & ~7) + interleave[k & 7];
+}
+
+// Dot products of one input patch with every output channel's packed weights (hot loop: TCM)
+TCM_TEXT static void int4_channels(const Int4OpData *data, const int16_t *patch, const int32_t *bias,
+                                   int8_t *out)
+{
+    const int out_channels = data->header->out_channels;
+    const int words = data->row_bytes / 4;
+    const uint8_t *weights = data->weights;
+    for (int c = 0; c < out_channels; c++)
+    {
+        int32_t acc16 = 0;
+        const int16_t *x = patch;
+        for (int i = 0; i < words; i++)
+        {
+            uint32_t w = kernel_read_u32(weights);
+            uint32_t r = (w >> 8) | (w << 24);
+            weights += 4;
+            acc16 = kernel_smlad(kernel_sxtb16((w << 4) & 0xF0F0F0F0u), kernel_read_u32(x), acc16);
+            acc16 = kernel_smlad(kernel_sxtb16(w & 0xF0F0F0F0u), kernel_read_u32(x + 2), acc16);
+            acc16 = kernel_smlad(kernel_sxtb16((r << 4) & 0xF0F0F0F0u), kernel_read_u32(x + 4), acc16);
+            acc16 = kernel_smlad(kernel_sxtb16(r & 0xF0F0F0F0u), kernel_read_u32(x + 6), acc16);
+            x += 8;
+        }
+        // Weights were unpacked as w * 16: exact shift back
+        int32_t acc = (acc16 >> 4) + ((bias != nullptr) ? bias[c] : 0);
+        acc = kernel_requantize(acc, data->multiplier[c], data->shift[c]) + data->output_offset;
+        out[c] = kernel_clamp_int8(acc, data->act_min, data->act_max);
+    }
+}
+
+static TfLiteStatus int4_conv_eval(TfLiteContext *context, TfLiteNode *node)
+{
+    const Int4OpData *data = static_cast<const Int4OpData *>(node->user_data);
+    const int4_weights_header_t *h = data->header;
+    const TfLiteEvalTensor *input = kernel_eval_input(context, node, 0);
+    const TfLiteEvalTensor *bias = kernel_eval_input(context, node, 1);
+    TfLiteEvalTensor *output = kernel_eval_output(context, node, 0);
+    int16_t *patch = static_cast<int16_t *>(shared_scratch_get(context, data->scratch));
+
+    const int batches = input->dims->data[0];
+    const int in_h = input->dims->data[1], in_w = input->dims->data[2], in_c = h->in_channels;
+    const int out_h = output->dims->data[1], out_w = output->dims->data[2];
+    const int8_t *in = input->data.int8;
+    int8_t *out = output->data.int8;
+    const int32_t *bias_data = (bias != nullptr) ? bias->data.i32 : nullptr;
+
+    // Padding lanes of the last word stay 0
+    memset(patch, 0, data->row_bytes * 2 * sizeof(int16_t));
+    for (int batch = 0; batch < batches; batch++)
+    {
+        for (int oy = 0; oy < out_h; oy++)
+        {
+            for (int ox = 0; ox < out_w; ox++)
+            {
+                // Gather the receptive field (+ input offset, 0 outside the image)
+                int k = 0;
+                for (int ky = 0; ky < h->kernel_h; ky++)
+                {
+                    int iy = oy * h->stride_h - data->pad_h + ky * h->dilation_h;
+                    for (int kx = 0; kx < h->kernel_w; kx++)
+                    {
+                        int ix = ox * h->stride_w - data->pad_w + kx * h->dilation_w;
+                        bool inside = iy >= 0 && iy < in_h && ix >= 0 && ix < in_w;
+                        const int8_t *px = in + (iy * in_w + ix) * in_c;
+                        for (int ic = 0; ic < in_c; ic++, k++)
+                            patch[patch_slot(k)] = inside ? static_cast<int16_t>(px[ic] + data->input_offset) : 0;
+                    }
+                }
+                int4_channels(data, patch, bias_data, out);
+                out += h->out_channels;
+            }
+        }
+        in += in_h * in_w * in_c;
+    }
+    return kTfLiteOk;
+}
+
+// Depthwise has no reduction over channels to pair up for SMLAD: unpack per nibble
+static TfLiteStatus int4_depthwise_eval(TfLiteContext *context, TfLiteNode *node)
+{
+    const Int4OpData *data = static_cast<const Int4OpData *>(node->user_data);
+    const int4_weights_header_t *h = data->header;
+    const TfLiteEvalTensor *input = kernel_eval_input(context, node, 0);
+    const TfLiteEvalTensor *bias = kernel_eval_input(context, node, 1);
+    TfLiteEvalTensor *output = kernel_eval_output(context, node, 0);
+    int32_t *acc = static_cast<int32_t *>(shared_scratch_get(context, data->scratch));
+
+    const int batches = input->dims->data[0];
+    const int in_h = input->dims->data[1], in_w = input->dims->data[2], channels = h->out_channels;
+    const int out_h = output->dims->data[1], out_w = output->dims->data[2];
+    const int8_t *in = input->data.int8;
+    int8_t *out = output->data.int8;
+    const int32_t *bias_data = (bias != nullptr) ? bias->data.i32 : nullptr;
+
+    for (int batch = 0; batch < batches; batch++)
+    {
+        for (int oy = 0; oy < out_h; oy++)
+        {
+            for (int ox = 0; ox < out_w; ox++)
+            {
+                memset(acc, 0, channels * sizeof(int32_t));
+                const uint8_t *taps = data->weights;
+                for (int ky = 0; ky < h->kernel_h; ky++)
+                {
+                    int iy = oy * h->stride_h - data->pad_h + ky * h->dilation_h;
+                    for (int kx = 0; kx < h->kernel_w; kx++, taps += data->row_bytes)
+                    {
+                        int ix = ox * h->stride_w - data->pad_w + kx * h->dilation_w;
+                        if (iy < 0 || iy >= in_h || ix < 0 || ix >= in_w)
+                            continue;
+                        const int8_t *px = in + (iy * in_w + ix) * channels;
+                        for (int c = 0; c < channels; c++)
+                        {
+                            uint8_t byte = taps[c >> 1];
+                            int32_t w = (c & 1) ? static_cast<int8_t>(byte) >> 4
+                                                : static_cast<int8_t>(byte << 4) >> 4;
+                            acc[c] += (px[c] + data->input_offset) * w;
+                        }
+                    }
+                }
+                for (int c = 0; c < channels; c++)
+                {
+                    int32_t v = acc[c] + ((bias_data != nullptr) ? bias_data[c] : 0);
+                    v = kernel_requantize(v, data->multiplier[c], data->shift[c]) + data->output_offset;
+                    out[c] = kernel_clamp_int8(v, data->act_min, data->act_max);
+                }
+                out += channels;
+            }
+        }
+        in += in_h * in_w * channels;
+    }
+    return kTfLiteOk;
+}
+
+static TfLiteStatus int4_fc_eval(TfLiteContext *context, TfLiteNode *node)
+{
+    const Int4OpData *data = static_cast<const Int4OpData *>(node->user_data);
+    const TfLiteEvalTensor *input = kernel_eval_input(context, node, 0);
+    const TfLiteEvalTensor *bias = kernel_eval_input(context, node, 1);
+    TfLiteEvalTensor *output = kernel_eval_output(context, node, 0);
+    int16_t *patch = static_cast<int16_t *>(shared_scratch_get(context, data->scratch));
+
+    int elements = 1;
+    for (int i = 0; i < input->dims->size; i++)
+        elements *= input->dims->data[i];
+    const int batches = elements / data->k;
+    const int8_t *in = input->data.int8;
+    int8_t *out = output->data.int8;
+    const int32_t *bias_data = (bias != nullptr) ? bias->data.i32 : nullptr;
+
+    memset(patch, 0, data->row_bytes * 2 * sizeof(int16_t));
+    for (int b = 0; b < batches; b++)
+    {
+        for (int k = 0; k < data->k; k++)
+            patch[patch_slot(k)] = static_cast<int16_t>(in[k] + data->input_offset);
+        int4_channels(data, patch, bias_data, out);
+        in += data->k;
+        out += data->header->out_channels;
+    }
+    return kTfLiteOk;
+}
+
+static TfLiteStatus int4_eval(TfLiteContext *context, TfLiteNode *node)
+{
+#ifdef PROFILING
+    uint32_t t0 = profiler_get_cycles();
+#endif
+    Int4OpData *data = static_cast<Int4OpData *>(node->user_data);
+    TfLiteStatus status;
+    if (data->header->op == INT4_OP_CONV_2D)
+        status = int4_conv_eval(context, node);
+    else if (data->header->op == INT4_OP_DEPTHWISE_CONV_2D)
+        status = int4_depthwise_eval(context, node);
+    else
+        status = int4_fc_eval(context, node);
+#ifdef PROFILING
+    data->cycles += profiler_get_cycles() - t0;
+    data->invokes++;
+#endif
+    return status;
+}
+
+TfLiteRegistration *Register_INT4_CONV_2D(void)
+{
+    static TfLiteRegistration r = {int4_init, nullptr, int4_prepare, int4_eval, nullptr, 0, nullptr, 0};
+    return &r;
+}
+
+TfLiteRegistration *Register_INT4_DEPTHWISE_CONV_2D(void)
+{
+    static TfLiteRegistration r = {int4_init, nullptr, int4_prepare, int4_eval, nullptr, 0, nullptr, 0};
+    return &r;
+}
+
+TfLiteRegistration *Register_INT4_FULLY_CONNECTED(void)
+{
+    static TfLiteRegistration r = {int4_init, nullptr, int4_prepare, int4_eval, nullptr, 0, nullptr, 0};
+    return &r;
+}
+
+#ifdef PROFILING
+void int4_kernels_reset_stats(void)
+{
+    layer_count = 0;
+}
+
+int int4_kernels_stats_mark(void)
+{
+    return layer_count;
+}
+
+void int4_kernels_stats_rewind(int mark)
+{
+    if (mark < layer_count)
+        layer_count = mark;
+}
+
+void int4_kernels_report(void)
+{
+    if (layer_count == 0)
+        return;
+    static const char *const kinds[] = {"conv", "dw", "fc"};
+    am_util_stdio_printf("\r\n--- Int4 layers ---\r\n");
+    for (int i = 0; i < layer_count; i++)
+    {
+        const Int4OpData *data = layers[i];
+        const int4_weights_header_t *h = data->header;
+        uint32_t avg = data->invokes ? data->cycles / data->invokes : 0;
+        am_util_stdio_printf("%s %dx%dx%d->%d: %u weight bytes, %lu cyc/invoke\r\n", kinds[h->op % 3],
+                             (int)h->kernel_h, (int)h->kernel_w, (int)h->in_channels, (int)h->out_channels,
+                             (unsigned)weight_bytes(data), (unsigned long)avg);
+    }
+}
+#endif
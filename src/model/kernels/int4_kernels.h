@@ -0,0 +1,62 @@
+#ifndef INT4_KERNELS_H_
+#define INT4_KERNELS_H_
+
+#include <stdint.h>
+
+#include "tensorflow/lite/c/common.h"
+
+// Conv2D / DepthwiseConv2D / FullyConnected with 4-bit weights, two per byte.
+//
+// python_scripts/quantize_int4.py re-quantizes the int8 weights of those ops to per-channel
+// symmetric int4 ([-7, 7]) and replaces the ops by custom ops "INT4_CONV_2D",
+// "INT4_DEPTHWISE_CONV_2D" / "INT4_FULLY_CONNECTED" (bias rescaled to the new filter scales).
+// Inputs: [input, bias (optional)], output as the original op. The weights move into the
+// op's custom options:
+//   int4_weights_header_t
+//   float   filter_scale[out_channels]          (per channel, zero point 0)
+//   uint8_t weights[]                           (two's complement nibbles, low nibble first)
+// Conv / FC: per output channel, K = kh * kw * in_channels weights in OHWI order, zero-padded
+//            to a multiple of 8 (one 32-bit word = 8 weights = 4 SMLADs).
+// Depthwise: per tap (ky, kx), out_channels weights zero-padded to an even count.
+
+#define INT4_WEIGHTS_MAGIC 0x31573449u // "I4W1"
+
+#define INT4_OP_CONV_2D 0
+#define INT4_OP_DEPTHWISE_CONV_2D 1
+#define INT4_OP_FULLY_CONNECTED 2
+
+typedef struct
+{
+    uint32_t magic;
+    uint8_t op;         // INT4_OP_*
+    uint8_t padding;    // TfLitePadding (conv, depthwise)
+    uint8_t activation; // TfLiteFusedActivation
+    uint8_t reserved;
+    int16_t stride_w;
+    int16_t stride_h;
+    int16_t dilation_w;
+    int16_t dilation_h;
+    int32_t out_channels;
+    int32_t kernel_h; // 1 for fully connected
+    int32_t kernel_w;
+    int32_t in_channels; // == out_channels for depthwise (depth multiplier 1 only)
+} int4_weights_header_t;
+
+TfLiteRegistration *Register_INT4_CONV_2D(void);
+TfLiteRegistration *Register_INT4_DEPTHWISE_CONV_2D(void);
+TfLiteRegistration *Register_INT4_FULLY_CONNECTED(void);
+
+#ifdef PROFILING
+// Per-layer cycles and weight bytes of the int4 ops run so far.
+void int4_kernels_report(void);
+
+// Forget tracked layers (call when the models are rebuilt).
+void int4_kernels_reset_stats(void);
+
+// Layers tracked so far / forget the layers tracked after that mark (op data of a dry-run
+// build, already torn down).
+int int4_kernels_stats_mark(void);
+void int4_kernels_stats_rewind(int mark);
+#endif
+
+#endif // INT4_KERNELS_H_
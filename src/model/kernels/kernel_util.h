@@ -0,0 +1,172 @@
+#ifndef MODEL_KERNEL_UTIL_H_
+#define MODEL_KERNEL_UTIL_H_
+
+// Helpers shared by the project-local int8 kernels (same arithmetic as the TFLM
+// reference kernels, so results match the kernels they replace).
+
+#include <stdint.h>
+#include <string.h>
+#include <cmath>
+
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/common.h"
+
+#if defined(__ARM_FEATURE_DSP)
+#include "am_mcu_apollo.h" // CMSIS intrinsics (__SXTB16, __SMLAD, ...)
+#endif
+
+// real multiplier -> Q31 multiplier + shift (TFLM QuantizeMultiplier)
+static inline void kernel_quantize_multiplier(double real_multiplier, int32_t *multiplier, int *shift)
+{
+    if (real_multiplier == 0.0)
+    {
+        *multiplier = 0;
+        *shift = 0;
+        return;
+    }
+    const double q = frexp(real_multiplier, shift);
+    int64_t q_fixed = static_cast<int64_t>(round(q * (1LL << 31)));
+    if (q_fixed == (1LL << 31))
+    {
+        q_fixed /= 2;
+        ++*shift;
+    }
+    if (*shift < -31)
+    {
+        *shift = 0;
+        q_fixed = 0;
+    }
+    *multiplier = static_cast<int32_t>(q_fixed);
+}
+
+// acc * multiplier * 2^shift with TFLM rounding (MultiplyByQuantizedMultiplier)
+static inline int32_t kernel_requantize(int32_t acc, int32_t multiplier, int shift)
+{
+    const int left_shift = shift > 0 ? shift : 0;
+    const int right_shift = shift > 0 ? 0 : -shift;
+    int64_t a = static_cast<int64_t>(acc) * (1 << left_shift);
+    if (a > INT32_MAX)
+        a = INT32_MAX;
+    if (a < INT32_MIN)
+        a = INT32_MIN;
+
+    // SaturatingRoundingDoublingHighMul
+    int32_t high;
+    if (a == INT32_MIN && multiplier == INT32_MIN)
+        high = INT32_MAX;
+    else
+    {
+        int64_t ab = a * multiplier;
+        int32_t nudge = ab >= 0 ? (1 << 30) : (1 - (1 << 30));
+        high = static_cast<int32_t>((ab + nudge) / (1LL << 31));
+    }
+
+    // RoundingDivideByPOT
+    const int32_t mask = (1 << right_shift) - 1;
+    const int32_t remainder = high & mask;
+    const int32_t threshold = (mask >> 1) + ((high < 0) ? 1 : 0);
+    return (high >> right_shift) + ((remainder > threshold) ? 1 : 0);
+}
+
+// Per-channel requantization of int32 accumulators, allocated from the persistent arena
+static inline TfLiteStatus kernel_channel_multipliers(TfLiteContext *context, float input_scale,
+                                                      const float *filter_scale, float output_scale, int channels,
+                                                      int32_t **multiplier, int **shift)
+{
+    *multiplier = static_cast<int32_t *>(context->AllocatePersistentBuffer(context, channels * sizeof(int32_t)));
+    *shift = static_cast<int *>(context->AllocatePersistentBuffer(context, channels * sizeof(int)));
+    if (*multiplier == nullptr || *shift == nullptr)
+        return kTfLiteError;
+    for (int c = 0; c < channels; c++)
+    {
+        double real = static_cast<double>(input_scale) * filter_scale[c] / output_scale;
+        kernel_quantize_multiplier(real, &(*multiplier)[c], &(*shift)[c]);
+    }
+    return kTfLiteOk;
+}
+
+// Output range of a fused activation in the quantized domain
+static inline void kernel_activation_range(TfLiteFusedActivation activation, float scale, int32_t zero_point,
+                                           int32_t *act_min, int32_t *act_max)
+{
+    int32_t lo = -128, hi = 127;
+    auto quantize = [&](float v) { return zero_point + static_cast<int32_t>(roundf(v / scale)); };
+    if (activation == kTfLiteActRelu)
+        lo = (quantize(0.0f) > lo) ? quantize(0.0f) : lo;
+    else if (activation == kTfLiteActRelu6)
+    {
+        lo = (quantize(0.0f) > lo) ? quantize(0.0f) : lo;
+        hi = (quantize(6.0f) < hi) ? quantize(6.0f) : hi;
+    }
+    else if (activation == kTfLiteActReluN1To1)
+    {
+        lo = (quantize(-1.0f) > lo) ? quantize(-1.0f) : lo;
+        hi = (quantize(1.0f) < hi) ? quantize(1.0f) : hi;
+    }
+    *act_min = lo;
+    *act_max = hi;
+}
+
+// Leading padding of one spatial dimension (TFLM ComputePaddingHeightWidth)
+static inline int kernel_padding(TfLitePadding padding, int in_size, int filter_size, int stride, int dilation,
+                                 int out_size)
+{
+    if (padding != kTfLitePaddingSame)
+        return 0;
+    int effective_filter = (filter_size - 1) * dilation + 1;
+    int total = (out_size - 1) * stride + effective_filter - in_size;
+    return (total > 0) ? total / 2 : 0;
+}
+
+static inline int8_t kernel_clamp_int8(int32_t v, int32_t act_min, int32_t act_max)
+{
+    if (v < act_min)
+        v = act_min;
+    if (v > act_max)
+        v = act_max;
+    return static_cast<int8_t>(v);
+}
+
+// Two packed 16-bit multiply-accumulates: acc + a.lo * b.lo + a.hi * b.hi
+static inline int32_t kernel_smlad(uint32_t a, uint32_t b, int32_t acc)
+{
+#if defined(__ARM_FEATURE_DSP)
+    return static_cast<int32_t>(__SMLAD(a, b, static_cast<uint32_t>(acc)));
+#else
+    return acc + static_cast<int16_t>(a & 0xFFFF) * static_cast<int16_t>(b & 0xFFFF) +
+           static_cast<int16_t>(a >> 16) * static_cast<int16_t>(b >> 16);
+#endif
+}
+
+// Sign-extend bytes 0 and 2 of w into two 16-bit lanes
+static inline uint32_t kernel_sxtb16(uint32_t w)
+{
+#if defined(__ARM_FEATURE_DSP)
+    return __SXTB16(w);
+#else
+    return (static_cast<uint32_t>(static_cast<uint16_t>(static_cast<int8_t>(w)))) |
+           (static_cast<uint32_t>(static_cast<uint16_t>(static_cast<int8_t>(w >> 16))) << 16);
+#endif
+}
+
+static inline uint32_t kernel_read_u32(const void *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// Eval tensor of node input/output i (nullptr for optional inputs that are absent)
+static inline TfLiteEvalTensor *kernel_eval_input(TfLiteContext *context, const TfLiteNode *node, int i)
+{
+    if (i >= node->inputs->size || node->inputs->data[i] < 0)
+        return nullptr;
+    return context->GetEvalTensor(context, node->inputs->data[i]);
+}
+
+static inline TfLiteEvalTensor *kernel_eval_output(TfLiteContext *context, const TfLiteNode *node, int i)
+{
+    return context->GetEvalTensor(context, node->outputs->data[i]);
+}
+
+#endif // MODEL_KERNEL_UTIL_H_
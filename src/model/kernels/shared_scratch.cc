@@ -0,0 +1,289 @@
+#include "shared_scratch.h"
+
+#include "model_settings.h"
+
+#include "tensorflow/lite/micro/kernels/conv.h"
+#include "tensorflow/lite/micro/kernels/depthwise_conv.h"
+#include "tensorflow/lite/micro/kernels/fully_connected.h"
+#include "profiler.h"
+#include "am_util.h"
+
+// Plain .bss: placed in MCU_TCM by libs/linker_script.ld
+alignas(16) static uint8_t tcm_scratch[kSharedScratchSize];
+
+// buffer_idx values with this bit set are offsets into tcm_scratch
+static constexpr int kSharedScratchTag = 0x40000000;
+
+// Layers tracked for the PROFILING report
+static constexpr int kMaxScratchLayers = 48;
+
+enum
+{
+    kWrappedConv = 0,
+    kWrappedDepthwise,
+    kWrappedFullyConnected,
+    kWrappedCount
+};
+static const char *const kWrappedNames[kWrappedCount] = {"conv", "dw", "fc"};
+
+struct ScratchLayer
+{
+    const char *kind;
+    uint32_t bytes;
+    bool in_tcm;
+    uint32_t cycles;
+    uint32_t invokes;
+};
+
+struct SharedScratchData
+{
+    void *generic_data; // user_data of the wrapped kernel
+    int kind;           // kWrapped*
+#ifdef PROFILING
+    ScratchLayer *stats;
+#endif
+};
+
+#ifdef PROFILING
+static bool shared_enabled = true;
+static ScratchLayer layers[kMaxScratchLayers];
+static int layer_count = 0;
+static uint32_t largest_layer = 0;
+static uint32_t baseline[kMaxScratchLayers]; // cycles per invoke, 0 = none
+static int baseline_count = 0;
+#else
+static constexpr bool shared_enabled = true;
+#endif
+
+// Context functions replaced while a wrapped kernel runs
+static TfLiteStatus (*arena_request)(TfLiteContext *, size_t, int *) = nullptr;
+static void *(*arena_get)(TfLiteContext *, int) = nullptr;
+
+// Buffers requested by the node being prepared (all layers start at offset 0)
+static size_t next_offset = 0;
+static size_t node_bytes = 0;
+static bool node_in_tcm = true;
+
+static const TfLiteRegistration &generic_registration(int kind)
+{
+    static const TfLiteRegistration registrations[kWrappedCount] = {
+        tflite::Register_CONV_2D_INT8(),
+        tflite::Register_DEPTHWISE_CONV_2D_INT8(),
+        tflite::Register_FULLY_CONNECTED_INT8(),
+    };
+    return registrations[kind];
+}
+
+// Place one buffer of the current node in the region, or in the arena if it does not fit
+static TfLiteStatus place(TfLiteContext *context, size_t bytes, int *buffer_idx)
+{
+    size_t offset = (next_offset + 15u) & ~static_cast<size_t>(15u);
+    node_bytes += bytes;
+    if (shared_enabled && offset + bytes <= sizeof(tcm_scratch))
+    {
+        *buffer_idx = kSharedScratchTag | static_cast<int>(offset);
+        next_offset = offset + bytes;
+        return kTfLiteOk;
+    }
+    node_in_tcm = false;
+    return arena_request(context, bytes, buffer_idx);
+}
+
+static void begin_node(void)
+{
+    next_offset = 0;
+    node_bytes = 0;
+    node_in_tcm = true;
+}
+
+#ifdef PROFILING
+static ScratchLayer *track(const char *kind)
+{
+    if (node_bytes > largest_layer)
+        largest_layer = static_cast<uint32_t>(node_bytes);
+    if (node_bytes == 0 || layer_count >= kMaxScratchLayers)
+        return nullptr;
+    ScratchLayer *layer = &layers[layer_count++];
+    layer->kind = kind;
+    layer->bytes = static_cast<uint32_t>(node_bytes);
+    layer->in_tcm = node_in_tcm;
+    layer->cycles = 0;
+    layer->invokes = 0;
+    return layer;
+}
+#endif
+
+static TfLiteStatus hooked_request(TfLiteContext *context, size_t bytes, int *buffer_idx)
+{
+    return place(context, bytes, buffer_idx);
+}
+
+static void *hooked_get(TfLiteContext *context, int buffer_idx)
+{
+    if (buffer_idx >= 0 && (buffer_idx & kSharedScratchTag))
+        return tcm_scratch + (buffer_idx & ~kSharedScratchTag);
+    return arena_get(context, buffer_idx);
+}
+
+template <int Kind>
+static void *wrapped_init(TfLiteContext *context, const char *buffer, size_t length)
+{
+    SharedScratchData *data =
+        static_cast<SharedScratchData *>(context->AllocatePersistentBuffer(context, sizeof(SharedScratchData)));
+    if (data == nullptr)
+        return nullptr;
+    memset(data, 0, sizeof(*data));
+    data->kind = Kind;
+    const TfLiteRegistration &generic = generic_registration(Kind);
+    data->generic_data = (generic.init != nullptr) ? generic.init(context, buffer, length) : nullptr;
+    return data;
+}
+
+static TfLiteStatus wrapped_prepare(TfLiteContext *context, TfLiteNode *node)
+{
+    SharedScratchData *data = static_cast<SharedScratchData *>(node->user_data);
+    if (data == nullptr)
+        return kTfLiteError;
+
+    begin_node();
+    arena_request = context->RequestScratchBufferInArena;
+    context->RequestScratchBufferInArena = hooked_request;
+    node->user_data = data->generic_data;
+    TfLiteStatus status = generic_registration(data->kind).prepare(context, node);
+    node->user_data = data;
+    context->RequestScratchBufferInArena = arena_request;
+#ifdef PROFILING
+    data->stats = track(kWrappedNames[data->kind]);
+#endif
+    return status;
+}
+
+static TfLiteStatus wrapped_eval(TfLiteContext *context, TfLiteNode *node)
+{
+#ifdef PROFILING
+    uint32_t t0 = profiler_get_cycles();
+#endif
+    SharedScratchData *data = static_cast<SharedScratchData *>(node->user_data);
+    arena_get = context->GetScratchBuffer;
+    context->GetScratchBuffer = hooked_get;
+    node->user_data = data->generic_data;
+    TfLiteStatus status = generic_registration(data->kind).invoke(context, node);
+    node->user_data = data;
+    context->GetScratchBuffer = arena_get;
+#ifdef PROFILING
+    if (data->stats != nullptr)
+    {
+        data->stats->cycles += profiler_get_cycles() - t0;
+        data->stats->invokes++;
+    }
+#endif
+    return status;
+}
+
+template <int Kind>
+static TfLiteRegistration wrap(void)
+{
+    TfLiteRegistration r = generic_registration(Kind);
+    r.init = wrapped_init<Kind>;
+    r.free = nullptr;
+    r.prepare = wrapped_prepare;
+    r.invoke = wrapped_eval;
+    return r;
+}
+
+TfLiteRegistration Register_CONV_2D_SHARED_SCRATCH(void)
+{
+    return wrap<kWrappedConv>();
+}
+
+TfLiteRegistration Register_DEPTHWISE_CONV_2D_SHARED_SCRATCH(void)
+{
+    return wrap<kWrappedDepthwise>();
+}
+
+TfLiteRegistration Register_FULLY_CONNECTED_SHARED_SCRATCH(void)
+{
+    return wrap<kWrappedFullyConnected>();
+}
+
+TfLiteStatus shared_scratch_request(TfLiteContext *context, const char *layer, size_t bytes, int *buffer_idx)
+{
+    begin_node();
+    arena_request = context->RequestScratchBufferInArena;
+    TfLiteStatus status = place(context, bytes, buffer_idx);
+#ifdef PROFILING
+    track(layer);
+#else
+    (void)layer;
+#endif
+    return status;
+}
+
+void *shared_scratch_get(TfLiteContext *context, int buffer_idx)
+{
+    if (buffer_idx >= 0 && (buffer_idx & kSharedScratchTag))
+        return tcm_scratch + (buffer_idx & ~kSharedScratchTag);
+    return context->GetScratchBuffer(context, buffer_idx);
+}
+
+#ifdef PROFILING
+void shared_scratch_set_enabled(bool enabled)
+{
+    shared_enabled = enabled;
+}
+
+void shared_scratch_reset_stats(void)
+{
+    layer_count = 0;
+    largest_layer = 0;
+}
+
+int shared_scratch_stats_mark(void)
+{
+    return layer_count;
+}
+
+void shared_scratch_stats_rewind(int mark)
+{
+    if (mark < layer_count)
+        layer_count = mark;
+    largest_layer = 0;
+    for (int i = 0; i < layer_count; i++)
+    {
+        if (layers[i].bytes > largest_layer)
+            largest_layer = layers[i].bytes;
+    }
+}
+
+void shared_scratch_save_baseline(void)
+{
+    for (int i = 0; i < layer_count; i++)
+        baseline[i] = layers[i].invokes ? layers[i].cycles / layers[i].invokes : 0;
+    baseline_count = layer_count;
+}
+
+void shared_scratch_report(void)
+{
+    if (layer_count == 0)
+        return;
+    am_util_stdio_printf("\r\n--- Scratch per layer (TCM region %u bytes, largest layer %lu) ---\r\n",
+                         (unsigned)sizeof(tcm_scratch), (unsigned long)largest_layer);
+    for (int i = 0; i < layer_count; i++)
+    {
+        const ScratchLayer *layer = &layers[i];
+        am_util_stdio_printf("%-6s %6lu B %s", layer->kind, (unsigned long)layer->bytes,
+                             layer->in_tcm ? "TCM  " : "arena");
+        if (layer->invokes > 0)
+        {
+            uint32_t avg = layer->cycles / layer->invokes;
+            am_util_stdio_printf(", %lu cyc/invoke", (unsigned long)avg);
+            if (i < baseline_count && baseline[i] > 0)
+                am_util_stdio_printf(" (arena %lu, %.1f%%)", (unsigned long)baseline[i], 100.0 * avg / baseline[i]);
+        }
+        am_util_stdio_printf("\r\n");
+    }
+    if (largest_layer > sizeof(tcm_scratch))
+        am_util_stdio_printf("Raise kSharedScratchSize to %lu to keep every layer in TCM.\r\n",
+                             (unsigned long)largest_layer);
+}
+#endif
@@ -0,0 +1,47 @@
+#ifndef SHARED_SCRATCH_H_
+#define SHARED_SCRATCH_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "tensorflow/lite/c/common.h"
+
+// Scratch buffers (im2col, input patches) of the conv-type kernels in one TCM region.
+//
+// Scratch buffers only live during their op's Eval, so every layer can use the same
+// kSharedScratchSize bytes (sized for the largest layer) instead of each request taking
+// part in the arena planning, and the region sits in TCM (.bss) instead of SHARED_SRAM.
+// A layer that needs more than the region falls back to the arena.
+//
+// The CMSIS-NN Conv2D / DepthwiseConv2D / FullyConnected registrations are wrapped: during
+// their Prepare / Eval the context's RequestScratchBufferInArena / GetScratchBuffer are
+// redirected to the region. Project-local kernels call shared_scratch_request/_get directly.
+TfLiteRegistration Register_CONV_2D_SHARED_SCRATCH(void);
+TfLiteRegistration Register_DEPTHWISE_CONV_2D_SHARED_SCRATCH(void);
+TfLiteRegistration Register_FULLY_CONNECTED_SHARED_SCRATCH(void);
+
+// RequestScratchBufferInArena / GetScratchBuffer for project-local kernels (one buffer per
+// node). 'layer' names the kernel in the report.
+TfLiteStatus shared_scratch_request(TfLiteContext *context, const char *layer, size_t bytes, int *buffer_idx);
+void *shared_scratch_get(TfLiteContext *context, int buffer_idx);
+
+#ifdef PROFILING
+// Place scratch buffers in the arena as TFLM does (takes effect when the model is next loaded)
+void shared_scratch_set_enabled(bool enabled);
+
+// Remember the current per-layer cycles as the baseline for the next report
+void shared_scratch_save_baseline(void);
+
+// Per-layer scratch bytes, placement and cycles (vs the saved baseline, if any)
+void shared_scratch_report(void);
+
+// Forget tracked layers (call when the models are rebuilt).
+void shared_scratch_reset_stats(void);
+
+// Layers tracked so far / forget the layers tracked after that mark (op data of a dry-run
+// build, already torn down).
+int shared_scratch_stats_mark(void);
+void shared_scratch_stats_rewind(int mark);
+#endif
+
+#endif // SHARED_SCRATCH_H_
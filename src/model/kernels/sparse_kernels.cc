@@ -0,0 +1,295 @@
+#include "sparse_kernels.h"
+#include "kernel_util.h"
+#include "shared_scratch.h"
+
+#include "tensorflow/lite/micro/micro_context.h"
+#include "profiler.h"
+#include "tcm.h"
+#include "am_util.h"
+
+// Sparse layers tracked for the PROFILING report
+static constexpr int kMaxSparseLayers = 16;
+
+struct SparseOpData
+{
+    const sparse_weights_header_t *header;
+    const float *filter_scale;
+    const uint32_t *bitmap;
+    const int8_t *values;
+    int k;             // weights per output channel
+    int blocks;        // 1x4 blocks per output channel
+    int bitmap_words;  // per output channel
+
+    int32_t *multiplier; // per output channel
+    int *shift;
+    int32_t input_offset;
+    int32_t output_offset;
+    int32_t act_min;
+    int32_t act_max;
+    int pad_h;
+    int pad_w;
+    int patch_buffer; // scratch: one interleaved int16 input patch
+
+#ifdef PROFILING
+    uint32_t cycles;
+    uint32_t invokes;
+#endif
+};
+
+#ifdef PROFILING
+static SparseOpData *layers[kMaxSparseLayers];
+static int layer_count = 0;
+#endif
+
+static void *sparse_init(TfLiteContext *context, const char *buffer, size_t length)
+{
+    const sparse_weights_header_t *header = reinterpret_cast<const sparse_weights_header_t *>(buffer);
+    if (buffer == nullptr || length < sizeof(*header) || header->magic != SPARSE_WEIGHTS_MAGIC)
+        return nullptr;
+
+    SparseOpData *data = static_cast<SparseOpData *>(context->AllocatePersistentBuffer(context, sizeof(SparseOpData)));
+    if (data == nullptr)
+        return nullptr;
+    memset(data, 0, sizeof(*data));
+    data->header = header;
+    data->k = header->kernel_h * header->kernel_w * header->in_channels;
+    data->blocks = (data->k + 3) / 4;
+    data->bitmap_words = (data->blocks + 31) / 32;
+
+    const int out_channels = header->out_channels;
+    size_t needed = sizeof(*header) + out_channels * sizeof(float) +
+                    out_channels * data->bitmap_words * sizeof(uint32_t) + header->nnz_blocks * 4;
+    if (length < needed)
+        return nullptr;
+    data->filter_scale = reinterpret_cast<const float *>(header + 1);
+    data->bitmap = reinterpret_cast<const uint32_t *>(data->filter_scale + out_channels);
+    data->values = reinterpret_cast<const int8_t *>(data->bitmap + out_channels * data->bitmap_words);
+    return data;
+}
+
+static TfLiteStatus sparse_prepare(TfLiteContext *context, TfLiteNode *node)
+{
+    SparseOpData *data = static_cast<SparseOpData *>(node->user_data);
+    if (data == nullptr)
+    {
+        am_util_stdio_printf("Sparse op: missing or invalid custom options.\r\n");
+        return kTfLiteError;
+    }
+    const sparse_weights_header_t *header = data->header;
+    tflite::MicroContext *micro_context = tflite::GetMicroContext(context);
+    TfLiteTensor *input = micro_context->AllocateTempInputTensor(node, 0);
+    TfLiteTensor *output = micro_context->AllocateTempOutputTensor(node, 0);
+    if (input == nullptr || output == nullptr || input->type != kTfLiteInt8 || output->type != kTfLiteInt8)
+    {
+        am_util_stdio_printf("Sparse op: int8 input/output required.\r\n");
+        return kTfLiteError;
+    }
+
+    data->input_offset = -input->params.zero_point;
+    data->output_offset = output->params.zero_point;
+    kernel_activation_range(static_cast<TfLiteFusedActivation>(header->activation), output->params.scale,
+                            output->params.zero_point, &data->act_min, &data->act_max);
+
+    if (kernel_channel_multipliers(context, input->params.scale, data->filter_scale, output->params.scale,
+                                   header->out_channels, &data->multiplier, &data->shift) != kTfLiteOk)
+        return kTfLiteError;
+
+    if (header->op == SPARSE_OP_CONV_2D)
+    {
+        // NHWC input [1, H, W, C], output [1, OH, OW, OC]
+        data->pad_h = kernel_padding(static_cast<TfLitePadding>(header->padding), input->dims->data[1],
+                                     header->kernel_h, header->stride_h, header->dilation_h, output->dims->data[1]);
+        data->pad_w = kernel_padding(static_cast<TfLitePadding>(header->padding), input->dims->data[2],
+                                     header->kernel_w, header->stride_w, header->dilation_w, output->dims->data[2]);
+    }
+
+    micro_context->DeallocateTempTfLiteTensor(input);
+    micro_context->DeallocateTempTfLiteTensor(output);
+
+    TfLiteStatus status =
+        shared_scratch_request(context, "sparse", data->blocks * 4 * sizeof(int16_t), &data->patch_buffer);
+#ifdef PROFILING
+    bool tracked = false;
+    for (int i = 0; i < layer_count; i++)
+        tracked = tracked || layers[i] == data;
+    if (!tracked && layer_count < kMaxSparseLayers)
+        layers[layer_count++] = data;
+#endif
+    return status;
+}
+
+// Position of flattened weight index k in the interleaved patch: each 1x4 block is
+// stored as [x0, x2, x1, x3] to match SXTB16(w) / SXTB16(w ror 8) lanes.
+static inline int patch_slot(int k)
+{
+    static const uint8_t interleave[4] = {0, 2, 1, 3};
+    return (k & ~3) + interleave[k & 3];
+}
+
+// Dot products of one input patch with every output channel's non-zero blocks (hot loop: TCM)
+TCM_TEXT static void sparse_channels(const SparseOpData *data, const int16_t *patch, const int32_t *bias,
+                                     int8_t *out)
+{
+    const int out_channels = data->header->out_channels;
+    const uint32_t *bitmap = data->bitmap;
+    const int8_t *values = data->values;
+    for (int c = 0; c < out_channels; c++)
+    {
+        int32_t acc = (bias != nullptr) ? bias[c] : 0;
+        for (int word = 0; word < data->bitmap_words; word++)
+        {
+            uint32_t bits = bitmap[word];
+            while (bits != 0)
+            {
+                int b = word * 32 + __builtin_ctz(bits);
+                bits &= bits - 1;
+                uint32_t w = kernel_read_u32(values);
+                values += 4;
+                const int16_t *x = patch + b * 4;
+                acc = kernel_smlad(kernel_sxtb16(w), kernel_read_u32(x), acc);
+                acc = kernel_smlad(kernel_sxtb16((w >> 8) | (w << 24)), kernel_read_u32(x + 2), acc);
+            }
+        }
+        bitmap += data->bitmap_words;
+        acc = kernel_requantize(acc, data->multiplier[c], data->shift[c]) + data->output_offset;
+        out[c] = kernel_clamp_int8(acc, data->act_min, data->act_max);
+    }
+}
+
+static TfLiteStatus sparse_conv_eval(TfLiteContext *context, TfLiteNode *node)
+{
+    const SparseOpData *data = static_cast<const SparseOpData *>(node->user_data);
+    const sparse_weights_header_t *h = data->header;
+    const TfLiteEvalTensor *input = kernel_eval_input(context, node, 0);
+    const TfLiteEvalTensor *bias = kernel_eval_input(context, node, 1);
+    TfLiteEvalTensor *output = kernel_eval_output(context, node, 0);
+    int16_t *patch = static_cast<int16_t *>(shared_scratch_get(context, data->patch_buffer));
+
+    const int batches = input->dims->data[0];
+    const int in_h = input->dims->data[1], in_w = input->dims->data[2], in_c = h->in_channels;
+    const int out_h = output->dims->data[1], out_w = output->dims->data[2];
+    const int8_t *in = input->data.int8;
+    int8_t *out = output->data.int8;
+    const int32_t *bias_data = (bias != nullptr) ? bias->data.i32 : nullptr;
+
+    // Padding lanes of the last block stay 0
+    memset(patch, 0, data->blocks * 4 * sizeof(int16_t));
+    for (int batch = 0; batch < batches; batch++)
+    {
+        for (int oy = 0; oy < out_h; oy++)
+        {
+            for (int ox = 0; ox < out_w; ox++)
+            {
+                // Gather the receptive field (+ input offset, 0 outside the image)
+                int k = 0;
+                for (int ky = 0; ky < h->kernel_h; ky++)
+                {
+                    int iy = oy * h->stride_h - data->pad_h + ky * h->dilation_h;
+                    for (int kx = 0; kx < h->kernel_w; kx++)
+                    {
+                        int ix = ox * h->stride_w - data->pad_w + kx * h->dilation_w;
+                        bool inside = iy >= 0 && iy < in_h && ix >= 0 && ix < in_w;
+                        const int8_t *px = in + (iy * in_w + ix) * in_c;
+                        for (int ic = 0; ic < in_c; ic++, k++)
+                            patch[patch_slot(k)] = inside ? static_cast<int16_t>(px[ic] + data->input_offset) : 0;
+                    }
+                }
+                sparse_channels(data, patch, bias_data, out);
+                out += h->out_channels;
+            }
+        }
+        in += in_h * in_w * in_c;
+    }
+    return kTfLiteOk;
+}
+
+static TfLiteStatus sparse_fc_eval(TfLiteContext *context, TfLiteNode *node)
+{
+    const SparseOpData *data = static_cast<const SparseOpData *>(node->user_data);
+    const TfLiteEvalTensor *input = kernel_eval_input(context, node, 0);
+    const TfLiteEvalTensor *bias = kernel_eval_input(context, node, 1);
+    TfLiteEvalTensor *output = kernel_eval_output(context, node, 0);
+    int16_t *patch = static_cast<int16_t *>(shared_scratch_get(context, data->patch_buffer));
+
+    int elements = 1;
+    for (int i = 0; i < input->dims->size; i++)
+        elements *= input->dims->data[i];
+    const int batches = elements / data->k;
+    const int8_t *in = input->data.int8;
+    int8_t *out = output->data.int8;
+    const int32_t *bias_data = (bias != nullptr) ? bias->data.i32 : nullptr;
+
+    memset(patch, 0, data->blocks * 4 * sizeof(int16_t));
+    for (int b = 0; b < batches; b++)
+    {
+        for (int k = 0; k < data->k; k++)
+            patch[patch_slot(k)] = static_cast<int16_t>(in[k] + data->input_offset);
+        sparse_channels(data, patch, bias_data, out);
+        in += data->k;
+        out += data->header->out_channels;
+    }
+    return kTfLiteOk;
+}
+
+static TfLiteStatus sparse_eval(TfLiteContext *context, TfLiteNode *node)
+{
+#ifdef PROFILING
+    uint32_t t0 = profiler_get_cycles();
+#endif
+    SparseOpData *data = static_cast<SparseOpData *>(node->user_data);
+    TfLiteStatus status = (data->header->op == SPARSE_OP_CONV_2D) ? sparse_conv_eval(context, node)
+                                                                   : sparse_fc_eval(context, node);
+#ifdef PROFILING
+    data->cycles += profiler_get_cycles() - t0;
+    data->invokes++;
+#endif
+    return status;
+}
+
+TfLiteRegistration *Register_SPARSE_CONV_2D(void)
+{
+    static TfLiteRegistration r = {sparse_init, nullptr, sparse_prepare, sparse_eval, nullptr, 0, nullptr, 0};
+    return &r;
+}
+
+TfLiteRegistration *Register_SPARSE_FULLY_CONNECTED(void)
+{
+    static TfLiteRegistration r = {sparse_init, nullptr, sparse_prepare, sparse_eval, nullptr, 0, nullptr, 0};
+    return &r;
+}
+
+#ifdef PROFILING
+void sparse_kernels_reset_stats(void)
+{
+    layer_count = 0;
+}
+
+int sparse_kernels_stats_mark(void)
+{
+    return layer_count;
+}
+
+void sparse_kernels_stats_rewind(int mark)
+{
+    if (mark < layer_count)
+        layer_count = mark;
+}
+
+void sparse_kernels_report(void)
+{
+    if (layer_count == 0)
+        return;
+    am_util_stdio_printf("\r\n--- Sparse layers ---\r\n");
+    for (int i = 0; i < layer_count; i++)
+    {
+        const SparseOpData *data = layers[i];
+        const sparse_weights_header_t *h = data->header;
+        int dense_blocks = h->out_channels * data->blocks;
+        uint32_t avg = data->invokes ? data->cycles / data->invokes : 0;
+        am_util_stdio_printf("%s %dx%dx%d->%d: %d/%d blocks (%.1f%% dense), %lu cyc/invoke\r\n",
+                             h->op == SPARSE_OP_CONV_2D ? "conv" : "fc", (int)h->kernel_h, (int)h->kernel_w,
+                             (int)h->in_channels, (int)h->out_channels, (int)h->nnz_blocks, dense_blocks,
+                             100.0 * h->nnz_blocks / dense_blocks, (unsigned long)avg);
+    }
+}
+#endif
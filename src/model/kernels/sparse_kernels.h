@@ -0,0 +1,60 @@
+#ifndef SPARSE_KERNELS_H_
+#define SPARSE_KERNELS_H_
+
+#include <stdint.h>
+
+#include "tensorflow/lite/c/common.h"
+
+// Block-sparse int8 Conv2D / FullyConnected for pruned models.
+//
+// python_scripts/sparsify_model.py replaces CONV_2D / FULLY_CONNECTED ops whose int8
+// weights are sparse enough by custom ops "SPARSE_CONV_2D" / "SPARSE_FULLY_CONNECTED".
+// Inputs: [input, bias (optional)], output as the original op. The weights move into the
+// op's custom options:
+//   sparse_weights_header_t
+//   float    filter_scale[out_channels]                 (per channel, zero point 0)
+//   uint32_t bitmap[out_channels][ceil(blocks / 32)]    (bit b: block b is non-zero)
+//   int8_t   values[nnz_blocks][4]                      (non-zero blocks, row order)
+// Each output channel's weights (OHWI order, flattened to K = kh * kw * in_channels and
+// zero-padded to a multiple of 4) are split into 1x4 blocks: one block is one SMLAD pair.
+
+#define SPARSE_WEIGHTS_MAGIC 0x31575053u // "SPW1"
+
+#define SPARSE_OP_CONV_2D 0
+#define SPARSE_OP_FULLY_CONNECTED 1
+
+typedef struct
+{
+    uint32_t magic;
+    uint8_t op;         // SPARSE_OP_*
+    uint8_t padding;    // TfLitePadding (conv)
+    uint8_t activation; // TfLiteFusedActivation
+    uint8_t reserved;
+    int16_t stride_w;
+    int16_t stride_h;
+    int16_t dilation_w;
+    int16_t dilation_h;
+    int32_t out_channels;
+    int32_t kernel_h; // 1 for fully connected
+    int32_t kernel_w;
+    int32_t in_channels;
+    int32_t nnz_blocks;
+} sparse_weights_header_t;
+
+TfLiteRegistration *Register_SPARSE_CONV_2D(void);
+TfLiteRegistration *Register_SPARSE_FULLY_CONNECTED(void);
+
+#ifdef PROFILING
+// Per-layer cycles and density of the sparse ops run so far.
+void sparse_kernels_report(void);
+
+// Forget tracked layers (call when the models are rebuilt).
+void sparse_kernels_reset_stats(void);
+
+// Layers tracked so far / forget the layers tracked after that mark (op data of a dry-run
+// build, already torn down).
+int sparse_kernels_stats_mark(void);
+void sparse_kernels_stats_rewind(int mark);
+#endif
+
+#endif // SPARSE_KERNELS_H_
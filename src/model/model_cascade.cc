@@ -0,0 +1,143 @@
+/**
+ * Confidence-gated cascade. Only built with MODEL_CASCADE (make CASCADE=1).
+ */
+#include "model_cascade.h"
+
+#ifdef MODEL_CASCADE
+
+#include "gate_model_data.h"
+#include "model_runtime.h"
+#include "model_settings.h"
+#include "depthwise_3x3.h"
+#include "shared_scratch.h"
+
+#include "profiler.h"
+#include "am_util.h"
+#include <cmath>
+
+static ModelHandle *gate_handle = nullptr;
+static float margin_threshold = kCascadeMarginThreshold;
+static bool gate_outputs_probabilities = false;
+static cascade_stats_t stats;
+
+// Ops of the small int8 gate classifier
+static void register_gate_model_ops(ModelOpResolver &resolver)
+{
+    resolver.AddConv2D(Register_CONV_2D_SHARED_SCRATCH());
+    resolver.AddDepthwiseConv2D(Register_DEPTHWISE_CONV_2D_3X3());
+    resolver.AddFullyConnected(Register_FULLY_CONNECTED_SHARED_SCRATCH());
+    resolver.AddAveragePool2D();
+    resolver.AddMaxPool2D();
+    resolver.AddAdd();
+    resolver.AddReshape();
+    resolver.AddSoftmax();
+    resolver.AddQuantize();
+    resolver.AddDequantize();
+}
+
+int model_cascade_init(void)
+{
+    static const ModelConfig gate_config = {
+        "gate",
+        g_gate_model_data,
+        kGateModelPersistentSize,
+        register_gate_model_ops,
+    };
+    am_util_stdio_printf("Loading cascade gate model (size: %d bytes)...\r\n", g_gate_model_data_len);
+    gate_handle = model_runtime_load(&gate_config);
+    if (gate_handle == nullptr)
+        return -1;
+
+    // TFLite int8 softmax outputs use scale 1/256, zero point -128. In that case the
+    // gate already emits probabilities and we must not apply softmax again.
+    const TfLiteTensor *out = gate_handle->output_tensor;
+    gate_outputs_probabilities = (out->type == kTfLiteInt8 &&
+                                  out->params.zero_point == -128 &&
+                                  fabsf(out->params.scale - 1.0f / 256.0f) < 1e-6f);
+
+    stats.queries = 0;
+    stats.gate_hits = 0;
+    stats.gate_cycles = 0;
+    am_util_stdio_printf("Cascade enabled (margin threshold %.2f, gate output: %s)\r\n",
+                         (double)margin_threshold, gate_outputs_probabilities ? "softmax" : "logits");
+    return 0;
+}
+
+void model_cascade_set_threshold(float margin)
+{
+    margin_threshold = margin;
+}
+
+// Top-1 class and top-1 minus top-2 softmax probability of the gate's output.
+static int top1_margin(float *margin)
+{
+    float p[kOutputSize];
+    model_handle_get_logits(gate_handle, p);
+
+    int best = 0;
+    for (int i = 1; i < kOutputSize; i++)
+    {
+        if (p[i] > p[best])
+            best = i;
+    }
+
+    if (!gate_outputs_probabilities)
+    {
+        // Numerically stable softmax: exp(x - max) / sum
+        float max_logit = p[best];
+        float sum = 0.0f;
+        for (int i = 0; i < kOutputSize; i++)
+        {
+            p[i] = expf(p[i] - max_logit);
+            sum += p[i];
+        }
+        for (int i = 0; i < kOutputSize; i++)
+            p[i] /= sum;
+    }
+
+    float second = 0.0f;
+    for (int i = 0; i < kOutputSize; i++)
+    {
+        if (i != best && p[i] > second)
+            second = p[i];
+    }
+    *margin = p[best] - second;
+    return best;
+}
+
+int model_cascade_gate(const uint8_t *image_data, int *label, float *margin)
+{
+    if (gate_handle == nullptr || label == nullptr)
+        return -1;
+#ifdef PROFILING
+    uint32_t t0 = profiler_get_cycles();
+#endif
+    stats.queries++;
+    model_handle_preprocess(gate_handle, image_data);
+    int ret = -1;
+    if (model_handle_invoke(gate_handle) == 0)
+    {
+        float m;
+        int cls = top1_margin(&m);
+        if (margin != nullptr)
+            *margin = m;
+        ret = 0;
+        if (m >= margin_threshold)
+        {
+            *label = cls;
+            stats.gate_hits++;
+            ret = 1;
+        }
+    }
+#ifdef PROFILING
+    stats.gate_cycles += profiler_get_cycles() - t0;
+#endif
+    return ret;
+}
+
+const cascade_stats_t *model_cascade_stats(void)
+{
+    return &stats;
+}
+
+#endif /* MODEL_CASCADE */
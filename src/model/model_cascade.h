@@ -0,0 +1,32 @@
+#ifndef MODEL_CASCADE_H_
+#define MODEL_CASCADE_H_
+
+#include <stdint.h>
+
+// Confidence-gated model cascade.
+// Stage 0: a small int8 classifier (gate). If its top-1 softmax probability beats the
+// runner-up by at least the margin threshold, its label is the answer.
+// Stage 1: everything else goes to the full embedding model + IVF (run by the caller).
+
+typedef struct
+{
+    uint32_t queries;     // images passed to model_cascade_gate()
+    uint32_t gate_hits;   // answered by the gate (stage 0)
+    uint64_t gate_cycles; // cycles spent in the gate (all queries, PROFILING only)
+} cascade_stats_t;
+
+// Load the gate model into its own handle. Call after model_init(). Returns 0 on success.
+int model_cascade_init(void);
+
+// Set the top-1 softmax margin (0..1) needed to accept the gate's answer.
+void model_cascade_set_threshold(float margin);
+
+// Run the gate on image. Returns 1 and sets *label if the gate is confident,
+// 0 if the query must go to the full model, -1 on error (treat as 0).
+// *margin (optional) receives the top-1 minus top-2 softmax probability.
+int model_cascade_gate(const uint8_t *image_data, int *label, float *margin);
+
+// Per-stage counters since init.
+const cascade_stats_t *model_cascade_stats(void);
+
+#endif // MODEL_CASCADE_H_
@@ -1,278 +1,340 @@
 #include "model_inference.h"
 #include "model_data.h"
+#include "model_loader.h"
+#include "model_runtime.h"
 #include "model_settings.h"
+#include "depthwise_3x3.h"
+#include "shared_scratch.h"
+#include "sparse_kernels.h"
+#include "int4_kernels.h"
 
-#include "tensorflow/lite/micro/system_setup.h"
-#include "tensorflow/lite/micro/micro_error_reporter.h"
-#include "tensorflow/lite/micro/micro_interpreter.h"
-#include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
-#include "tensorflow/lite/schema/schema_generated.h"
-#include "tensorflow/lite/c/common.h"
+#include "perf_mode.h"
+#include "profiler.h"
 #include "am_util.h"
-#include <cmath>
-
-// Tensor arena for model execution - placed in SHARED_SRAM (uninitialized)
-alignas(16) static uint8_t tensor_arena[kTensorArenaSize] __attribute__((section(".shared_bss")));
-
-// Model and interpreter state
-static tflite::ErrorReporter *error_reporter = nullptr;
-static const tflite::Model *model = nullptr;
-static tflite::MicroInterpreter *interpreter = nullptr;
-static TfLiteTensor *input_tensor = nullptr;
-static TfLiteTensor *output_tensor = nullptr;
-
-// Data types detected at init (for int8 vs fp32 preprocess / output handling)
-static TfLiteType input_type = kTfLiteNoType;
-static TfLiteType output_type = kTfLiteNoType;
-
-// ImageNet normalization constants (used for CIFAR-10 with pretrained models)
-static const float IMAGENET_MEAN[3] = {0.485f, 0.456f, 0.406f};
-static const float IMAGENET_STD[3] = {0.229f, 0.224f, 0.225f};
-
-// Helper function to apply ImageNet normalization to image data (FP32 input tensor)
-// image_data: HWC format (height, width, channels) - RGB uint8 [0-255]
-// input_data: Output tensor data (format depends on tensor shape)
-// height, width: Image dimensions (32x32 for CIFAR-10)
-static void apply_imagenet_normalization(
-    const uint8_t *image_data,
-    float *input_data,
-    int height,
-    int width)
+
+// Default model (embedding + classifier head). Existing API calls go through this handle.
+static ModelHandle *default_handle = nullptr;
+
+// Flatbuffer the default handle runs from (built-in MRAM array or the SRAM buffer)
+static const unsigned char *active_model_data = nullptr;
+
+// Run python_scripts/tflite_operators.py to get the operators in the model
+// If operators are missing, interpreter will fail to initialize.
+// Only Conv2D, DepthwiseConv2D, FullyConnected use CMSIS-NN int8 kernels
+// (3x3 depthwise layers with stride 1/2 use the specialized kernel in kernels/; all of them
+// take their scratch buffers from the shared TCM region, see kernels/shared_scratch.h).
+// Other ops (Mul, Add, Reshape, Concatenation, Transpose, etc.) use reference
+// kernels, so total inference speedup depends on how much time the model spends
+// in conv/depthwise/FC vs the rest. Run: python tflite_operators.py <model.tflite>
+static void register_default_model_ops(ModelOpResolver &resolver)
 {
-    // NCHW format: [C, H, W]
-    for (int c = 0; c < 3; c++)
-    {
-        for (int h = 0; h < height; h++)
-        {
-            for (int w = 0; w < width; w++)
-            {
-                float pixel = static_cast<float>(image_data[h * width * 3 + w * 3 + c]);
-                float normalized = (pixel / 255.0f - IMAGENET_MEAN[c]) / IMAGENET_STD[c];
-                input_data[c * height * width + h * width + w] = normalized;
-            }
-        }
-    }
+    resolver.AddTranspose();
+    resolver.AddConv2D(Register_CONV_2D_SHARED_SCRATCH());
+    resolver.AddPad();
+    resolver.AddDepthwiseConv2D(Register_DEPTHWISE_CONV_2D_3X3());
+    resolver.AddAveragePool2D();
+    resolver.AddFullyConnected(Register_FULLY_CONNECTED_SHARED_SCRATCH());
+    resolver.AddAbs();
+    resolver.AddMul();
+    resolver.AddSum();
+    resolver.AddSqrt();
+    resolver.AddReshape();
+    resolver.AddMaximum();
+    resolver.AddDiv();
+    resolver.AddConcatenation();
+    resolver.AddQuantize();
+    resolver.AddDequantize();
+    // Pruned models converted with python_scripts/sparsify_model.py
+    resolver.AddCustom("SPARSE_CONV_2D", Register_SPARSE_CONV_2D());
+    resolver.AddCustom("SPARSE_FULLY_CONNECTED", Register_SPARSE_FULLY_CONNECTED());
+    // 4-bit weight models converted with python_scripts/quantize_int4.py
+    resolver.AddCustom("INT4_CONV_2D", Register_INT4_CONV_2D());
+    resolver.AddCustom("INT4_DEPTHWISE_CONV_2D", Register_INT4_DEPTHWISE_CONV_2D());
+    resolver.AddCustom("INT4_FULLY_CONNECTED", Register_INT4_FULLY_CONNECTED());
 }
 
-// Apply ImageNet normalization and quantize to int8 for quantized input tensor.
-// real_value = scale * (quantized - zero_point)  =>  quantized = round(real_value/scale) + zero_point
-static void apply_imagenet_normalization_quantized(
-    const uint8_t *image_data,
-    int8_t *input_data,
-    int height,
-    int width,
-    float scale,
-    int32_t zero_point)
+// (Re)initialize the runtime with model_data as the default model
+static int load_default_model(const unsigned char *model_data, unsigned int model_len)
 {
-    for (int c = 0; c < 3; c++)
+    model_runtime_init();
+
+    am_util_stdio_printf("Loading model (size: %d bytes)...\r\n", model_len);
+    const ModelConfig default_config = {
+        "default",
+        model_data,
+        kDefaultModelPersistentSize,
+        register_default_model_ops,
+    };
+    default_handle = model_runtime_load(&default_config);
+    if (default_handle == nullptr)
+        return -1;
+
+    active_model_data = model_data;
+    return 0;
+}
+
+int model_init(void)
+{
+    return load_default_model(g_model_data, g_model_data_len);
+}
+
+int model_init_from_sd(const char *path)
+{
+    unsigned int len = 0;
+    const unsigned char *data = model_loader_load_sd(path, &len);
+    if (data != nullptr && load_default_model(data, len) == 0)
     {
-        for (int h = 0; h < height; h++)
-        {
-            for (int w = 0; w < width; w++)
-            {
-                float pixel = static_cast<float>(image_data[h * width * 3 + w * 3 + c]);
-                float normalized = (pixel / 255.0f - IMAGENET_MEAN[c]) / IMAGENET_STD[c];
-                int32_t q = static_cast<int32_t>(roundf(normalized / scale)) + zero_point;
-                if (q < -128)
-                    q = -128;
-                if (q > 127)
-                    q = 127;
-                input_data[c * height * width + h * width + w] = static_cast<int8_t>(q);
-            }
-        }
+        am_util_stdio_printf("Using model from SD card (weights in SRAM).\r\n");
+        return 0;
     }
+    am_util_stdio_printf("Using built-in model (weights in MRAM).\r\n");
+    return model_init();
 }
 
-// Get one output value.
-static float get_output_value(int index)
+#ifdef PROFILING
+// Average Invoke() cycles of the default model over 'runs' runs
+static uint32_t time_invoke(const uint8_t *image_data, int runs)
 {
-    if (output_type == kTfLiteFloat32)
-        return output_tensor->data.f[index];
-    if (output_type == kTfLiteInt8)
-        return (output_tensor->data.int8[index] - output_tensor->params.zero_point) * output_tensor->params.scale;
-    return 0.0f;
+    model_handle_preprocess(default_handle, image_data);
+    model_handle_invoke(default_handle); // warm-up
+    uint32_t t0 = profiler_get_cycles();
+    for (int i = 0; i < runs; i++)
+        model_handle_invoke(default_handle);
+    return (profiler_get_cycles() - t0) / (uint32_t)runs;
 }
 
-// Index of first logit in output (output is [1, emb_dim + kOutputSize])
-static int get_logits_start_index(void)
+// Invoke() runs in a burst (perf_mode.h): cycles are counted at the burst clock
+static double invoke_ms(uint32_t cycles)
 {
-    if (output_tensor == nullptr || output_tensor->dims->size < 2)
-        return 0;
-    return output_tensor->dims->data[1] - kOutputSize;
+    return profiler_cycles_to_ms(cycles, perf_mode_burst_hz());
 }
 
-// Find predicted class from logits.
-// Logits start index = output dim - kOutputSize.
-static int find_predicted_class(void)
+void model_benchmark_weight_placement(const uint8_t *image_data, int runs, const char *sd_path)
 {
-    int logits_start = get_logits_start_index();
-    int predicted_class = 0;
-    float max_prob = -1e6f;
-    for (int i = 0; i < kOutputSize; i++)
+    if (image_data == nullptr || runs <= 0)
+        return;
+    am_util_stdio_printf("\r\n--- Weight placement benchmark (%d invokes) ---\r\n", runs);
+
+    uint32_t mram_cyc = 0, sram_cyc = 0;
+    if (load_default_model(g_model_data, g_model_data_len) == 0)
+        mram_cyc = time_invoke(image_data, runs);
+
+    unsigned int len = 0;
+    const unsigned char *sram_model = model_loader_copy_builtin(&len);
+    if (sram_model != nullptr && load_default_model(sram_model, len) == 0)
+        sram_cyc = time_invoke(image_data, runs);
+
+    am_util_stdio_printf("Invoke, weights in MRAM: %lu cyc (%.2f ms)\r\n",
+                         (unsigned long)mram_cyc, invoke_ms(mram_cyc));
+    am_util_stdio_printf("Invoke, weights in SRAM: %lu cyc (%.2f ms)\r\n",
+                         (unsigned long)sram_cyc, invoke_ms(sram_cyc));
+    if (mram_cyc > 0 && sram_cyc > 0)
+        am_util_stdio_printf("SRAM vs MRAM: %.1f%% of MRAM cycles\r\n", 100.0 * sram_cyc / mram_cyc);
+
+    // SD model (e.g. a sparse or int4 conversion of the built-in one), also from SRAM
+    const unsigned char *sd_model = (sd_path != nullptr) ? model_loader_load_sd(sd_path, &len) : nullptr;
+    if (sd_model != nullptr && load_default_model(sd_model, len) == 0)
     {
-        float prob = get_output_value(logits_start + i);
-        if (prob > max_prob)
-        {
-            max_prob = prob;
-            predicted_class = i;
-        }
+        uint32_t sd_cyc = time_invoke(image_data, runs);
+        am_util_stdio_printf("Invoke, SD model (%u bytes vs %u built-in): %lu cyc (%.2f ms)\r\n", len,
+                             g_model_data_len, (unsigned long)sd_cyc, invoke_ms(sd_cyc));
+        if (sram_cyc > 0)
+            am_util_stdio_printf("SD model vs built-in (both SRAM): %.1f%% of cycles\r\n", 100.0 * sd_cyc / sram_cyc);
+        sparse_kernels_report();
+        int4_kernels_report();
     }
-    return predicted_class;
+    am_util_stdio_printf("--- End Weight placement benchmark ---\r\n\r\n");
 }
 
-int model_init(void)
+void model_benchmark_depthwise(const uint8_t *image_data, int runs)
 {
-    // Set up error reporting
-    static tflite::MicroErrorReporter micro_error_reporter;
-    error_reporter = &micro_error_reporter;
+    if (image_data == nullptr || runs <= 0)
+        return;
+    am_util_stdio_printf("\r\n--- Depthwise 3x3 benchmark (%d invokes) ---\r\n", runs);
 
-    // Initialize TensorFlow Lite Micro target
-    tflite::InitializeTarget();
+    uint32_t generic_cyc = 0, fast_cyc = 0;
+    depthwise_3x3_set_enabled(false);
+    if (load_default_model(g_model_data, g_model_data_len) == 0)
+        generic_cyc = time_invoke(image_data, runs);
+    depthwise_3x3_save_baseline();
 
-    // Load model from flatbuffer
-    am_util_stdio_printf("Loading model (size: %d bytes)...\r\n", g_model_data_len);
-    model = tflite::GetModel(g_model_data);
-    if (model->version() != TFLITE_SCHEMA_VERSION)
-    {
-        am_util_stdio_printf("Model schema version %d not supported. Expected %d.\r\n",
-                             model->version(), TFLITE_SCHEMA_VERSION);
-        return -1;
-    }
-    am_util_stdio_printf("Model loaded successfully (schema version %d)\r\n", model->version());
-
-    // Run python_scripts/tflite_operators.py to get the operators in the model
-    // If operators are missing, interpreter will fail to initialize.
-    // Only Conv2D, DepthwiseConv2D, FullyConnected use CMSIS-NN int8 kernels.
-    // Other ops (Mul, Add, Reshape, Concatenation, Transpose, etc.) use reference
-    // kernels, so total inference speedup depends on how much time the model spends
-    // in conv/depthwise/FC vs the rest. Run: python tflite_operators.py <model.tflite>
-    static tflite::MicroMutableOpResolver<16> resolver(error_reporter);
-    resolver.AddTranspose();
-    resolver.AddConv2D(tflite::Register_CONV_2D_INT8());
-    resolver.AddPad();
-    resolver.AddDepthwiseConv2D(tflite::Register_DEPTHWISE_CONV_2D_INT8());
-    resolver.AddAveragePool2D();
-    resolver.AddFullyConnected(tflite::Register_FULLY_CONNECTED_INT8());
-    resolver.AddAbs();
-    resolver.AddMul();
-    resolver.AddSum();
-    resolver.AddSqrt();
-    resolver.AddReshape();
-    resolver.AddMaximum();
-    resolver.AddDiv();
-    resolver.AddConcatenation();
-    resolver.AddQuantize();
-    resolver.AddDequantize();
+    depthwise_3x3_set_enabled(true);
+    if (load_default_model(g_model_data, g_model_data_len) == 0)
+        fast_cyc = time_invoke(image_data, runs);
 
-    // Build interpreter
-    static tflite::MicroInterpreter static_interpreter(
-        model, resolver, tensor_arena, kTensorArenaSize, error_reporter);
-    interpreter = &static_interpreter;
+    am_util_stdio_printf("Invoke, generic depthwise: %lu cyc (%.2f ms)\r\n", (unsigned long)generic_cyc,
+                         invoke_ms(generic_cyc));
+    am_util_stdio_printf("Invoke, 3x3 depthwise:     %lu cyc (%.2f ms)\r\n", (unsigned long)fast_cyc,
+                         invoke_ms(fast_cyc));
+    depthwise_3x3_report(); // per layer, baseline = generic kernel
+    am_util_stdio_printf("--- End Depthwise 3x3 benchmark ---\r\n\r\n");
+}
 
-    // Check interpreter initialization status
-    TfLiteStatus init_status = interpreter->initialization_status();
-    if (init_status != kTfLiteOk)
+void model_benchmark_scratch(const uint8_t *image_data, int runs)
+{
+    if (image_data == nullptr || runs <= 0)
+        return;
+    am_util_stdio_printf("\r\n--- Kernel scratch placement benchmark (%d invokes) ---\r\n", runs);
+
+    uint32_t arena_cyc = 0, tcm_cyc = 0;
+    size_t arena_used = 0, tcm_arena_used = 0;
+    shared_scratch_set_enabled(false);
+    if (load_default_model(g_model_data, g_model_data_len) == 0)
     {
-        am_util_stdio_printf("Interpreter initialization failed with status: %d\r\n", init_status);
-        return -1;
+        arena_cyc = time_invoke(image_data, runs);
+        arena_used = default_handle->interpreter->arena_used_bytes();
     }
+    shared_scratch_save_baseline();
 
-    // Allocate memory for all model tensors
-    TfLiteStatus allocate_status = interpreter->AllocateTensors();
-    if (allocate_status != kTfLiteOk)
+    shared_scratch_set_enabled(true);
+    if (load_default_model(g_model_data, g_model_data_len) == 0)
     {
-        am_util_stdio_printf("AllocateTensors() failed with status: %d\r\n", allocate_status);
-        return -1;
+        tcm_cyc = time_invoke(image_data, runs);
+        tcm_arena_used = default_handle->interpreter->arena_used_bytes();
     }
 
-    input_tensor = interpreter->input(0);
-    output_tensor = interpreter->output(0);
+    am_util_stdio_printf("Scratch in arena:      %lu cyc (%.2f ms), arena used %u bytes\r\n",
+                         (unsigned long)arena_cyc, invoke_ms(arena_cyc), (unsigned)arena_used);
+    am_util_stdio_printf("Scratch shared in TCM: %lu cyc (%.2f ms), arena used %u bytes\r\n",
+                         (unsigned long)tcm_cyc, invoke_ms(tcm_cyc), (unsigned)tcm_arena_used);
+    shared_scratch_report(); // per layer, baseline = scratch in arena
+    am_util_stdio_printf("--- End Kernel scratch placement benchmark ---\r\n\r\n");
+}
+
+void model_benchmark_perf_mode(const uint8_t *image_data, int runs)
+{
+    if (image_data == nullptr || runs <= 0)
+        return;
+    am_util_stdio_printf("\r\n--- Perf mode benchmark (%d invokes) ---\r\n", runs);
+    if (load_default_model(g_model_data, g_model_data_len) != 0)
+        return;
 
-    input_type = input_tensor->type;
-    output_type = output_tensor->type;
+    int enabled = perf_mode_burst_enable(0);
+    uint32_t lp_hz = perf_mode_burst_hz();
+    uint32_t lp_cyc = time_invoke(image_data, runs);
+    perf_mode_burst_enable(1);
+    uint32_t hp_hz = perf_mode_burst_hz();
+    uint32_t hp_cyc = time_invoke(image_data, runs);
 
-    if (input_type != kTfLiteFloat32 && input_type != kTfLiteInt8)
-    {
-        am_util_stdio_printf("Unsupported input type: %d (only kTfLiteFloat32 or kTfLiteInt8)\r\n", static_cast<int>(input_type));
+    double lp_ms = profiler_cycles_to_ms(lp_cyc, lp_hz), hp_ms = profiler_cycles_to_ms(hp_cyc, hp_hz);
+    am_util_stdio_printf("Invoke at %3lu MHz: %lu cyc (%.2f ms)\r\n", (unsigned long)(lp_hz / 1000000u),
+                         (unsigned long)lp_cyc, lp_ms);
+    am_util_stdio_printf("Invoke at %3lu MHz: %lu cyc (%.2f ms)\r\n", (unsigned long)(hp_hz / 1000000u),
+                         (unsigned long)hp_cyc, hp_ms);
+    if (hp_ms > 0.0)
+        am_util_stdio_printf("Burst speedup: %.2fx (cycles %.1f%% of 96 MHz)\r\n", lp_ms / hp_ms,
+                             lp_cyc ? 100.0 * hp_cyc / lp_cyc : 0.0);
+    perf_mode_burst_enable(enabled);
+    am_util_stdio_printf("--- End Perf mode benchmark ---\r\n\r\n");
+}
+#endif
+
+int model_swap(const unsigned char *model_data, unsigned int model_len, uint32_t *downtime_us)
+{
+    if (downtime_us != nullptr)
+        *downtime_us = 0;
+    if (default_handle == nullptr || model_loader_verify(model_data, model_len) != 0)
         return -1;
-    }
-    if (output_type != kTfLiteFloat32 && output_type != kTfLiteInt8)
-    {
-        am_util_stdio_printf("Unsupported output type: %d (only kTfLiteFloat32 or kTfLiteInt8)\r\n", static_cast<int>(output_type));
+
+    // Validate the exact rebuild while the current model keeps serving
+    if (model_runtime_dry_run(default_handle, model_data) != 0)
         return -1;
+
+    // Downtime: old interpreter torn down until the new one is ready
+    uint32_t t0 = perf_mode_timer();
+    int ret = model_runtime_reload(default_handle, model_data);
+    if (ret == 0)
+        active_model_data = model_data;
+    else
+    {
+        am_util_stdio_printf("Model switch failed, restoring previous model.\r\n");
+        model_runtime_reload(default_handle, active_model_data);
     }
-    am_util_stdio_printf("Model I/O types: input=%d (1=float32, 9=int8), output=%d\r\n",
-                         static_cast<int>(input_type), static_cast<int>(output_type));
+    if (downtime_us != nullptr)
+        *downtime_us = perf_mode_timer_us(perf_mode_timer() - t0);
+    return ret;
+}
 
-    size_t arena_used = interpreter->arena_used_bytes();
-    am_util_stdio_printf("Model initialized. Arena used: %d / %d bytes\r\n",
-                         (int)arena_used, kTensorArenaSize);
+const unsigned char *model_active_data(void)
+{
+    return active_model_data;
+}
 
-    return 0;
+ModelHandle *model_default_handle(void)
+{
+    return default_handle;
+}
+
+/* --- Batch inference --- */
+
+int model_run_batch(const uint8_t *const *images, int n, model_batch_output_t *outputs,
+                    model_batch_timing_t *timing)
+{
+    if (outputs == nullptr)
+        return 0;
+    model_output_mode_t mode = MODEL_OUTPUT_LOGITS_ONLY;
+    for (int i = 0; i < n; i++)
+    {
+        if (outputs[i].embedding != nullptr)
+            mode = MODEL_OUTPUT_BOTH;
+    }
+    return model_handle_run_batch(default_handle, images, n, mode, outputs, timing);
 }
 
 /* --- Class prediction (for testing) --- */
 
 int model_predict_class(const uint8_t *image_data)
 {
-    if (interpreter == nullptr || input_tensor == nullptr || output_tensor == nullptr)
-        return -1;
-    model_preprocess_for_embedding(image_data);
-    if (model_invoke_for_embedding() != 0)
-        return -1;
-    return find_predicted_class();
+    return model_handle_predict_class(default_handle, image_data);
+}
+
+int model_get_topk(int k, int idx[], uint16_t score[])
+{
+    return model_handle_get_topk(default_handle, k, idx, score);
 }
 
 /* --- IVF embedding API --- */
 
 void model_preprocess_for_embedding(const uint8_t *image_data)
 {
-    if (interpreter == nullptr || input_tensor == nullptr)
-        return;
-    int height = input_tensor->dims->data[2];
-    int width = input_tensor->dims->data[3];
-    if (input_type == kTfLiteFloat32)
-    {
-        float *input_data = input_tensor->data.f;
-        apply_imagenet_normalization(image_data, input_data, height, width);
-    }
-    else if (input_type == kTfLiteInt8)
-    {
-        int8_t *input_data = input_tensor->data.int8;
-        float scale = input_tensor->params.scale;
-        int32_t zero_point = input_tensor->params.zero_point;
-        apply_imagenet_normalization_quantized(image_data, input_data, height, width, scale, zero_point);
-    }
+    model_handle_preprocess(default_handle, image_data);
 }
 
 int model_invoke_for_embedding(void)
 {
-    if (interpreter == nullptr)
-        return -1;
-    return (interpreter->Invoke() == kTfLiteOk) ? 0 : -1;
+    return model_handle_invoke_mode(default_handle, MODEL_OUTPUT_EMBEDDING_ONLY);
+}
+
+int model_invoke(model_output_mode_t mode)
+{
+    return model_handle_invoke_mode(default_handle, mode);
 }
 
 void model_get_embedding(float *out, int dim)
 {
-    if (output_tensor == nullptr || out == nullptr || dim <= 0)
-        return;
-    int total = 1;
-    for (int i = 0; i < output_tensor->dims->size; i++)
-        total *= output_tensor->dims->data[i];
-    if (dim > total)
-        dim = total;
-    if (output_type == kTfLiteFloat32)
-    {
-        const float *src = output_tensor->data.f;
-        for (int i = 0; i < dim; i++)
-            out[i] = src[i];
-    }
-    else if (output_type == kTfLiteInt8)
-    {
-        float scale = output_tensor->params.scale;
-        int32_t zero_point = output_tensor->params.zero_point;
-        const int8_t *src = output_tensor->data.int8;
-        for (int i = 0; i < dim; i++)
-            out[i] = (src[i] - zero_point) * scale;
-    }
+    model_handle_get_embedding(default_handle, out, dim);
+}
+
+int model_get_embedding_int8(const int8_t **data, float *scale, int32_t *zero_point)
+{
+    return model_handle_get_embedding_int8(default_handle, data, scale, zero_point);
+}
+
+/* --- Pre-quantized input --- */
+
+int model_get_input_info(model_input_info_t *info)
+{
+    return model_handle_input_info(default_handle, info);
+}
+
+int8_t *model_get_input_int8(size_t *len)
+{
+    return model_handle_input_int8(default_handle, len);
+}
+
+int model_predict_class_int8(void)
+{
+    if (model_handle_invoke_mode(default_handle, MODEL_OUTPUT_LOGITS_ONLY) != 0)
+        return -1;
+    return model_handle_find_predicted_class(default_handle);
 }
@@ -3,23 +3,92 @@
 
 #include <stdint.h>
 
+#include "model_runtime.h"
+
 // Initialize the model and allocate resources. Returns 0 on success, non-zero on failure.
 int model_init(void);
 
+// Like model_init(), but first tries a packaged model file on the mounted SD card
+// (see model_loader.h), loaded into SRAM. Falls back to the built-in MRAM model.
+int model_init_from_sd(const char *path);
+
+// Switch the default model to another flatbuffer without touching other handles.
+// The new model is dry-run first; the old one is only torn down once that passes and is
+// restored if the rebuild still fails. model_data must stay valid while in use.
+// downtime_us receives the rebuild time (wall time, any build). Returns 0 on success.
+int model_swap(const unsigned char *model_data, unsigned int model_len, uint32_t *downtime_us);
+
+// Flatbuffer the default model currently runs from.
+const unsigned char *model_active_data(void);
+
+#ifdef PROFILING
+// Compare Invoke() cycles with the built-in weights read from MRAM vs copied to SRAM,
+// and (if sd_path names a valid model file) of that model, e.g. a sparse or int4 conversion.
+// Reinitializes the model runtime: call before model_init*().
+void model_benchmark_weight_placement(const uint8_t *image_data, int runs, const char *sd_path);
+
+// Compare Invoke() cycles and per-layer depthwise cycles of the built-in model with the
+// generic vs the specialized 3x3 depthwise kernel. Reinitializes the model runtime.
+void model_benchmark_depthwise(const uint8_t *image_data, int runs);
+
+// Compare Invoke() cycles, arena usage and per-layer kernel scratch with scratch buffers
+// planned in the arena vs shared in TCM. Reinitializes the model runtime.
+void model_benchmark_scratch(const uint8_t *image_data, int runs);
+
+// Compare Invoke() cycles and time at 96 MHz vs in 192 MHz bursts. Reinitializes the
+// model runtime.
+void model_benchmark_perf_mode(const uint8_t *image_data, int runs);
+#endif
+
+// Handle of the default model loaded by model_init() (see model_runtime.h). nullptr before init.
+ModelHandle *model_default_handle(void);
+
 // --- Embedding API (for IVF) ---
 
 // Copy image into model input buffer. Call before model_invoke_for_embedding().
 void model_preprocess_for_embedding(const uint8_t *image_data);
 
-// Run TFLite forward pass. Call after model_preprocess_for_embedding(). Returns 0 on success.
+// Run the TFLite ops the embedding needs (classifier head is skipped).
+// Call after model_preprocess_for_embedding(). Returns 0 on success.
 int model_invoke_for_embedding(void);
 
-// Copy first 'dim' floats from model output (embedding) into out. Call after model_invoke_for_embedding().
+// Run the TFLite ops needed for mode (MODEL_OUTPUT_BOTH runs the whole graph). Returns 0 on success.
+int model_invoke(model_output_mode_t mode);
+
+// Copy first 'dim' floats of the embedding into out. Call after model_invoke_for_embedding().
 void model_get_embedding(float *out, int dim);
 
+// Zero-copy view of the int8 embedding (no dequantize): real = scale * (data[i] - zero_point).
+// Returns the embedding dimension, or -1 if the model's embedding is not int8.
+int model_get_embedding_int8(const int8_t **data, float *scale, int32_t *zero_point);
+
+// --- Batch inference ---
+
+// Run n images through the default model. Only logits are computed unless some output
+// asks for an embedding. timing (optional) receives per-batch cycle totals.
+// Returns the number of images processed.
+int model_run_batch(const uint8_t *const *images, int n, model_batch_output_t *outputs,
+                    model_batch_timing_t *timing);
+
 // --- Class prediction (for testing) ---
 
 // Run preprocess + invoke and return predicted class index (0..kCategoryCount-1), or -1 on failure.
 int model_predict_class(const uint8_t *image_data);
 
+// Top-k classes of the last invoke with Q15 softmax probabilities (kModelScoreOne = 1.0).
+// Returns the number of entries written, or -1 on failure.
+int model_get_topk(int k, int idx[], uint16_t score[]);
+
+// --- Pre-quantized input (host does normalization + quantization) ---
+
+// Input tensor type, quantization, shape and the normalization the host must apply.
+int model_get_input_info(model_input_info_t *info);
+
+// Input tensor to fill with an int8 input in the model's layout, scale and zero point
+// (see model_get_input_info()), e.g. straight from UART. nullptr if the input is not int8.
+int8_t *model_get_input_int8(size_t *len);
+
+// Like model_predict_class(), on the input already written to model_get_input_int8().
+int model_predict_class_int8(void);
+
 #endif // MODEL_INFERENCE_H_
@@ -0,0 +1,235 @@
+#ifndef MODEL_IO_H_
+#define MODEL_IO_H_
+
+#include <stdint.h>
+#include <cmath>
+
+#include "model_settings.h"
+
+#include "tensorflow/lite/c/common.h"
+
+// Preprocessing and output reading specialized on tensor type (and input layout).
+// model_runtime.cc picks one instantiation per handle at load through a function-pointer
+// table, so the per-element loops carry no type branches.
+
+// Build-time I/O type (make MODEL_IO=int8 / MODEL_IO=float32): only that variant is
+// compiled and models with other input/output types are rejected at load.
+// Default: every variant is compiled and chosen per model.
+#if defined(MODEL_IO_INT8)
+constexpr TfLiteType kModelIoType = kTfLiteInt8;
+#elif defined(MODEL_IO_FLOAT32)
+constexpr TfLiteType kModelIoType = kTfLiteFloat32;
+#else
+constexpr TfLiteType kModelIoType = kTfLiteNoType;
+#endif
+
+// ImageNet normalization constants (used for CIFAR-10 with pretrained models)
+static constexpr float IMAGENET_MEAN[3] = {0.485f, 0.456f, 0.406f};
+static constexpr float IMAGENET_STD[3] = {0.229f, 0.224f, 0.225f};
+
+typedef enum
+{
+    MODEL_LAYOUT_NCHW = 0,
+    MODEL_LAYOUT_NHWC
+} model_input_layout_t;
+
+// Input tensor parameters, read once per call instead of per image
+struct InputParams
+{
+    int height;
+    int width;
+    float scale;
+    int32_t zero_point;
+};
+
+// Normalize one RGB uint8 HWC image into 'input' (one batch slot of the input tensor).
+typedef void (*ModelPreprocessFn)(const uint8_t *image_data, void *input, const InputParams &p);
+
+struct OutputReaderOps;
+
+// Where one half of the output lives after the last invoke
+struct OutputView
+{
+    const void *data;
+    TfLiteType type;
+    float scale;
+    int32_t zero_point;
+    int length;
+    const OutputReaderOps *reader; // matches type
+};
+
+// Output reading for one tensor type
+struct OutputReaderOps
+{
+    void (*dequantize)(const OutputView &view, float *out, int n); // first n values
+    int (*argmax)(const OutputView &view);                        // over kOutputSize values
+};
+
+// --- Preprocessor ---
+
+template <TfLiteType In>
+struct InputElement;
+
+template <>
+struct InputElement<kTfLiteFloat32>
+{
+    typedef float T;
+    static inline float convert(float normalized, const InputParams &)
+    {
+        return normalized;
+    }
+};
+
+// real_value = scale * (quantized - zero_point)  =>  quantized = round(real_value/scale) + zero_point
+template <>
+struct InputElement<kTfLiteInt8>
+{
+    typedef int8_t T;
+    static inline int8_t convert(float normalized, const InputParams &p)
+    {
+        int32_t q = static_cast<int32_t>(roundf(normalized / p.scale)) + p.zero_point;
+        if (q < -128)
+            q = -128;
+        if (q > 127)
+            q = 127;
+        return static_cast<int8_t>(q);
+    }
+};
+
+template <TfLiteType In, model_input_layout_t L>
+struct Preprocessor
+{
+    // image_data: HWC format (height, width, channels) - RGB uint8 [0-255]
+    static void run(const uint8_t *image_data, void *input, const InputParams &p)
+    {
+        typedef InputElement<In> Element;
+        typename Element::T *input_data = static_cast<typename Element::T *>(input);
+        const int pixels = p.height * p.width;
+        for (int c = 0; c < kImageChannels; c++)
+        {
+            for (int i = 0; i < pixels; i++)
+            {
+                float pixel = static_cast<float>(image_data[i * kImageChannels + c]);
+                float normalized = (pixel / 255.0f - IMAGENET_MEAN[c]) / IMAGENET_STD[c];
+                int o = (L == MODEL_LAYOUT_NCHW) ? c * pixels + i : i * kImageChannels + c;
+                input_data[o] = Element::convert(normalized, p);
+            }
+        }
+    }
+};
+
+// --- OutputReader ---
+
+template <TfLiteType Out>
+struct OutputReader;
+
+template <>
+struct OutputReader<kTfLiteFloat32>
+{
+    typedef float T;
+    static inline float value(float v, const OutputView &)
+    {
+        return v;
+    }
+};
+
+template <>
+struct OutputReader<kTfLiteInt8>
+{
+    typedef int8_t T;
+    static inline float value(int8_t v, const OutputView &view)
+    {
+        return (v - view.zero_point) * view.scale;
+    }
+};
+
+template <TfLiteType Out>
+struct OutputReaderImpl
+{
+    typedef OutputReader<Out> Reader;
+    typedef typename Reader::T T;
+
+    static void dequantize(const OutputView &view, float *out, int n)
+    {
+        const T *src = static_cast<const T *>(view.data);
+        for (int i = 0; i < n; i++)
+            out[i] = Reader::value(src[i], view);
+    }
+
+    // Quantized values order like their real values (scale > 0): compare raw
+    static int argmax(const OutputView &view)
+    {
+        const T *src = static_cast<const T *>(view.data);
+        int best = 0;
+        for (int i = 1; i < kOutputSize; i++)
+        {
+            if (src[i] > src[best])
+                best = i;
+        }
+        return best;
+    }
+
+    static const OutputReaderOps *ops()
+    {
+        static const OutputReaderOps reader_ops = {dequantize, argmax};
+        return &reader_ops;
+    }
+};
+
+// --- Selection (only enabled variants are instantiated) ---
+
+template <TfLiteType T>
+constexpr bool model_io_enabled()
+{
+    return kModelIoType == kTfLiteNoType || kModelIoType == T;
+}
+
+template <TfLiteType In, model_input_layout_t L, bool kEnabled = model_io_enabled<In>()>
+struct PreprocessorEntry
+{
+    static ModelPreprocessFn get() { return Preprocessor<In, L>::run; }
+};
+
+template <TfLiteType In, model_input_layout_t L>
+struct PreprocessorEntry<In, L, false>
+{
+    static ModelPreprocessFn get() { return nullptr; }
+};
+
+template <TfLiteType Out, bool kEnabled = model_io_enabled<Out>()>
+struct OutputReaderEntry
+{
+    static const OutputReaderOps *get() { return OutputReaderImpl<Out>::ops(); }
+};
+
+template <TfLiteType Out>
+struct OutputReaderEntry<Out, false>
+{
+    static const OutputReaderOps *get() { return nullptr; }
+};
+
+// Preprocessor for an input type and layout, or nullptr if not supported / compiled.
+inline ModelPreprocessFn model_io_preprocessor(TfLiteType type, model_input_layout_t layout)
+{
+    static const ModelPreprocessFn table[2][2] = {
+        {PreprocessorEntry<kTfLiteFloat32, MODEL_LAYOUT_NCHW>::get(), PreprocessorEntry<kTfLiteFloat32, MODEL_LAYOUT_NHWC>::get()},
+        {PreprocessorEntry<kTfLiteInt8, MODEL_LAYOUT_NCHW>::get(), PreprocessorEntry<kTfLiteInt8, MODEL_LAYOUT_NHWC>::get()},
+    };
+    if (type == kTfLiteFloat32)
+        return table[0][layout];
+    if (type == kTfLiteInt8)
+        return table[1][layout];
+    return nullptr;
+}
+
+// Output reader for a tensor type, or nullptr if not supported / compiled.
+inline const OutputReaderOps *model_io_reader(TfLiteType type)
+{
+    if (type == kTfLiteFloat32)
+        return OutputReaderEntry<kTfLiteFloat32>::get();
+    if (type == kTfLiteInt8)
+        return OutputReaderEntry<kTfLiteInt8>::get();
+    return nullptr;
+}
+
+#endif // MODEL_IO_H_
@@ -0,0 +1,230 @@
+#include "model_loader.h"
+#include "model_data.h"
+#include "model_settings.h"
+
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+#include "crc32.h"
+#include "ff.h"
+#include "am_util.h"
+#include <string.h>
+
+#if defined(__arm__)
+#include "am_mcu_apollo.h"
+#define MODEL_MRAM_SECTION __attribute__((section(".model_mram")))
+#else
+#define MODEL_MRAM_SECTION
+#endif
+
+// Model weights loaded at runtime - placed in SHARED_SRAM (uninitialized).
+// The interpreter reads weights in place, so this must stay valid while the model is loaded.
+alignas(16) static uint8_t model_sram[kModelSramSize] __attribute__((section(".shared_bss")));
+
+// Second staging slot, reserved in MRAM (.model_mram in libs/linker_script.ld, not part of
+// the load image). Two model-sized buffers do not fit in SHARED_SRAM next to the model
+// region, so an update is staged into whichever slot the running model is not in and the
+// two alternate from one update to the next.
+alignas(16) static uint8_t model_mram[kModelSramSize] MODEL_MRAM_SECTION;
+
+// Staged update progress
+static uint8_t *stage_slot = model_sram;
+static uint32_t stage_size = 0;
+static uint32_t stage_crc = 0;
+static uint32_t stage_received = 0;
+
+#if defined(__arm__)
+// MRAM is programmed in 16-byte blocks from word-aligned data: chunks are gathered here and
+// programmed a buffer at a time, the tail (padded) by stage_finish. Only whole buffers
+// are programmed before the tail, so every program call starts block-aligned.
+alignas(16) static uint32_t mram_buffer[256];
+static uint32_t mram_pending = 0; // bytes in mram_buffer
+static uint32_t mram_written = 0; // bytes of the slot programmed so far
+
+static int mram_flush(void)
+{
+    if (mram_pending == 0)
+        return 0;
+    uint32_t bytes = (mram_pending + 15u) & ~15u;
+    memset(reinterpret_cast<uint8_t *>(mram_buffer) + mram_pending, 0xFF, bytes - mram_pending);
+    int status = am_hal_mram_main_program(AM_HAL_MRAM_PROGRAM_KEY, mram_buffer,
+                                          reinterpret_cast<uint32_t *>(model_mram + mram_written), bytes / 4);
+    if (status != 0)
+    {
+        am_util_stdio_printf("MRAM program failed at offset %lu (%d).\r\n", (unsigned long)mram_written, status);
+        return -1;
+    }
+    mram_written += mram_pending;
+    mram_pending = 0;
+    return 0;
+}
+#endif
+
+// Append len bytes to the staging slot
+static int stage_copy(const uint8_t *data, uint32_t len)
+{
+#if defined(__arm__)
+    if (stage_slot == model_mram)
+    {
+        while (len > 0)
+        {
+            uint32_t n = sizeof(mram_buffer) - mram_pending;
+            if (n > len)
+                n = len;
+            memcpy(reinterpret_cast<uint8_t *>(mram_buffer) + mram_pending, data, n);
+            mram_pending += n;
+            data += n;
+            len -= n;
+            if (mram_pending == sizeof(mram_buffer) && mram_flush() != 0)
+                return -1;
+        }
+        return 0;
+    }
+#endif
+    memcpy(stage_slot + stage_received, data, len);
+    return 0;
+}
+
+int model_loader_verify(const unsigned char *data, unsigned int len)
+{
+    // .tflite files carry the "TFL3" identifier at offset 4
+    if (data == nullptr || len < 8 || !tflite::ModelBufferHasIdentifier(data))
+    {
+        am_util_stdio_printf("Model data is not a TFLite flatbuffer.\r\n");
+        return -1;
+    }
+    const tflite::Model *model = tflite::GetModel(data);
+    if (model->version() != TFLITE_SCHEMA_VERSION)
+    {
+        am_util_stdio_printf("Model schema version %d not supported. Expected %d.\r\n",
+                             (int)model->version(), TFLITE_SCHEMA_VERSION);
+        return -1;
+    }
+    return 0;
+}
+
+const unsigned char *model_loader_load_sd(const char *path, unsigned int *len)
+{
+    FIL file;
+    UINT n;
+    model_file_header_t header;
+
+    if (f_open(&file, path, FA_READ) != FR_OK)
+    {
+        am_util_stdio_printf("No model file %s on SD card.\r\n", path);
+        return nullptr;
+    }
+    if (f_read(&file, &header, sizeof(header), &n) != FR_OK || n != sizeof(header) ||
+        header.magic != MODEL_FILE_MAGIC)
+    {
+        am_util_stdio_printf("%s: bad model file header.\r\n", path);
+        f_close(&file);
+        return nullptr;
+    }
+    if (header.size == 0 || header.size > (uint32_t)kModelSramSize ||
+        f_size(&file) != sizeof(header) + (FSIZE_t)header.size)
+    {
+        am_util_stdio_printf("%s: model size %lu does not fit (buffer %d, file %lu bytes).\r\n",
+                             path, (unsigned long)header.size, kModelSramSize, (unsigned long)f_size(&file));
+        f_close(&file);
+        return nullptr;
+    }
+    // Whole sectors are read straight into the buffer (multi-block reads)
+    if (f_read(&file, model_sram, header.size, &n) != FR_OK || n != header.size)
+    {
+        am_util_stdio_printf("%s: read failed.\r\n", path);
+        f_close(&file);
+        return nullptr;
+    }
+    f_close(&file);
+
+    uint32_t crc = crc32_update(0, model_sram, header.size);
+    if (crc != header.crc32)
+    {
+        am_util_stdio_printf("%s: CRC mismatch (file %08lx, data %08lx).\r\n",
+                             path, (unsigned long)header.crc32, (unsigned long)crc);
+        return nullptr;
+    }
+    if (model_loader_verify(model_sram, header.size) != 0)
+        return nullptr;
+
+    am_util_stdio_printf("Loaded %s into SRAM (%lu bytes, crc %08lx)\r\n",
+                         path, (unsigned long)header.size, (unsigned long)crc);
+    if (len != nullptr)
+        *len = header.size;
+    return model_sram;
+}
+
+const unsigned char *model_loader_copy_builtin(unsigned int *len)
+{
+    if (g_model_data_len > (unsigned int)kModelSramSize)
+        return nullptr;
+    memcpy(model_sram, g_model_data, g_model_data_len);
+    if (len != nullptr)
+        *len = g_model_data_len;
+    return model_sram;
+}
+
+int model_loader_stage_begin(uint32_t size, uint32_t crc, const unsigned char *active)
+{
+    stage_size = 0;
+    stage_received = 0;
+#if defined(__arm__)
+    mram_pending = 0;
+    mram_written = 0;
+#endif
+    if (size == 0 || size > (uint32_t)kModelSramSize)
+    {
+        am_util_stdio_printf("Staged model size %lu does not fit (buffer %d).\r\n",
+                             (unsigned long)size, kModelSramSize);
+        return -1;
+    }
+    bool active_in_sram = active >= model_sram && active < model_sram + kModelSramSize;
+    stage_slot = active_in_sram ? model_mram : model_sram;
+    stage_size = size;
+    stage_crc = crc;
+    return 0;
+}
+
+int model_loader_stage_write(const uint8_t *data, uint32_t len, uint32_t chunk_crc)
+{
+    if (data == nullptr || len > stage_size - stage_received)
+        return -1;
+    // Check before copying so a corrupted chunk can simply be sent again
+    if (crc32_update(0, data, len) != chunk_crc)
+        return -1;
+    if (stage_copy(data, len) != 0)
+    {
+        // The slot no longer holds what was received: refuse the rest of this update
+        stage_size = 0;
+        stage_received = 0;
+        return -1;
+    }
+    stage_received += len;
+    return 0;
+}
+
+const unsigned char *model_loader_stage_finish(unsigned int *len)
+{
+    if (stage_size == 0 || stage_received != stage_size)
+    {
+        am_util_stdio_printf("Staged model incomplete (%lu of %lu bytes).\r\n",
+                             (unsigned long)stage_received, (unsigned long)stage_size);
+        return nullptr;
+    }
+#if defined(__arm__)
+    if (stage_slot == model_mram && mram_flush() != 0)
+        return nullptr;
+#endif
+    uint32_t crc = crc32_update(0, stage_slot, stage_size);
+    if (crc != stage_crc)
+    {
+        am_util_stdio_printf("Staged model CRC mismatch (expected %08lx, data %08lx).\r\n",
+                             (unsigned long)stage_crc, (unsigned long)crc);
+        return nullptr;
+    }
+    if (model_loader_verify(stage_slot, stage_size) != 0)
+        return nullptr;
+    if (len != nullptr)
+        *len = stage_size;
+    return stage_slot;
+}
@@ -0,0 +1,49 @@
+#ifndef MODEL_LOADER_H_
+#define MODEL_LOADER_H_
+
+#include <stdint.h>
+
+// Runtime model loading into a SHARED_SRAM buffer.
+//
+// Staged updates alternate between that buffer and a second slot in MRAM: each update goes
+// to the slot the running model is not in, so the running model stays intact until the
+// switch.
+//
+// Model file on the SD card (written by python_scripts/pack_model.py):
+//   model_file_header_t (16 bytes) followed by the .tflite flatbuffer.
+
+#define MODEL_FILE_MAGIC 0x314C444Du // "MDL1"
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t size;  // flatbuffer bytes following the header
+    uint32_t crc32; // CRC-32 of the flatbuffer
+    uint32_t reserved;
+} model_file_header_t;
+
+// Read and verify (magic, size, CRC, flatbuffer identifier, schema version) a model
+// file into the SRAM model buffer. Returns the flatbuffer or nullptr (reason printed).
+const unsigned char *model_loader_load_sd(const char *path, unsigned int *len);
+
+// Copy the built-in (MRAM) model into the SRAM model buffer.
+const unsigned char *model_loader_copy_builtin(unsigned int *len);
+
+// Check a flatbuffer already in memory (identifier + schema version). Returns 0 if usable.
+int model_loader_verify(const unsigned char *data, unsigned int len);
+
+// --- Staged update (model streamed in chunks, e.g. over UART) ---
+
+// Start staging a model of 'size' bytes whose CRC-32 is 'crc' into the slot that 'active'
+// (the running model's data) is not in. Returns 0 if it fits.
+int model_loader_stage_begin(uint32_t size, uint32_t crc, const unsigned char *active);
+
+// Append one chunk. chunk_crc is the CRC-32 of the chunk alone. Returns 0 if accepted,
+// -1 if rejected (bad CRC: resend the same chunk; too long or write failed: abort).
+int model_loader_stage_write(const uint8_t *data, uint32_t len, uint32_t chunk_crc);
+
+// After the last chunk: check the whole-model CRC and the flatbuffer.
+// Returns the staged model or nullptr (reason printed).
+const unsigned char *model_loader_stage_finish(unsigned int *len);
+
+#endif // MODEL_LOADER_H_
@@ -0,0 +1,316 @@
+#include "model_partial.h"
+
+#include "tensorflow/lite/schema/schema_generated.h"
+#include "trace.h"
+#include "am_util.h"
+#include <string.h>
+#include <utility>
+
+// TFLM has no API to run part of a graph, so every kernel of a splittable model is
+// reached through a trampoline. For a partial call the trampoline returns without
+// running ops whose output is not needed; otherwise it calls the original kernel.
+// The resolver is owned by the handle, so patching its registrations only affects
+// that model. With zero-copy aliasing the Concatenation is skipped as well.
+// With TRACE every model is routed through the trampolines, which record a begin/end
+// event around each op that runs (one trace zone per op type).
+
+// Handle whose interpreter is currently inside AllocateTensors() or Invoke()
+static ModelHandle *running_handle = nullptr;
+
+static inline bool tensor_needed(const uint32_t *bits, int index)
+{
+    return (bits[index >> 5] >> (index & 31)) & 1u;
+}
+
+static inline void mark_tensor(uint32_t *bits, int index)
+{
+    bits[index >> 5] |= 1u << (index & 31);
+}
+
+static TfLiteStatus gated_invoke(int slot, TfLiteContext *context, TfLiteNode *node)
+{
+    ModelOutputSplit *split = &running_handle->split;
+    int output = node->outputs->data[0];
+    if (split->needed != nullptr && !tensor_needed(split->needed, output))
+        return kTfLiteOk;
+    if (split->aliased && output == split->output_index)
+        return kTfLiteOk; // inputs were written in place
+#ifdef TRACE
+    profiler_zone_t zone = split->op_zones[slot];
+    trace_record(TRACE_EVENT_BEGIN, zone, 0);
+    TfLiteStatus status = split->original_invoke[slot](context, node);
+    trace_record(TRACE_EVENT_END, zone, 0);
+    return status;
+#else
+    return split->original_invoke[slot](context, node);
+#endif
+}
+
+static size_t element_size(TfLiteType type)
+{
+    return (type == kTfLiteFloat32) ? sizeof(float) : sizeof(int8_t);
+}
+
+// Concatenation Prepare of an aliasable model. Prepare runs after the eval tensors exist
+// and before the memory plan is committed; the planner skips tensors that already have
+// data, so embedding, logits and output 0 get no slot of their own.
+static TfLiteStatus aliasing_prepare(TfLiteContext *context, TfLiteNode *node)
+{
+    ModelOutputSplit *split = &running_handle->split;
+    TfLiteStatus status = (split->original_prepare != nullptr) ? split->original_prepare(context, node) : kTfLiteOk;
+    if (status != kTfLiteOk || split->output_buffer == nullptr || node->outputs->data[0] != split->output_index)
+        return status;
+    uint8_t *logits = split->output_buffer + split->embedding_dim * element_size(split->embedding_type);
+    context->GetEvalTensor(context, split->embedding_index)->data.data = split->output_buffer;
+    context->GetEvalTensor(context, split->logits_index)->data.data = logits;
+    context->GetEvalTensor(context, split->output_index)->data.data = split->output_buffer;
+    split->aliased = true;
+    return kTfLiteOk;
+}
+
+// One trampoline per resolver slot so each can find its original kernel
+template <int kSlot>
+static TfLiteStatus gated_invoke_slot(TfLiteContext *context, TfLiteNode *node)
+{
+    return gated_invoke(kSlot, context, node);
+}
+
+template <int... kSlots>
+static const ModelInvokeFn *make_gated_invoke_table(std::integer_sequence<int, kSlots...>)
+{
+    static const ModelInvokeFn table[] = {gated_invoke_slot<kSlots>...};
+    return table;
+}
+
+static tflite::BuiltinOperator builtin_code(const tflite::OperatorCode *opcode)
+{
+    // Newer schemas keep small codes in deprecated_builtin_code
+    tflite::BuiltinOperator code = opcode->builtin_code();
+    tflite::BuiltinOperator deprecated = static_cast<tflite::BuiltinOperator>(opcode->deprecated_builtin_code());
+    return code > deprecated ? code : deprecated;
+}
+
+// Mark every tensor 'target' depends on. Operators are stored in execution order,
+// so one backwards pass is enough.
+static void mark_ancestors(const tflite::SubGraph *subgraph, int target, uint32_t *bits)
+{
+    mark_tensor(bits, target);
+    const auto *operators = subgraph->operators();
+    for (int i = static_cast<int>(operators->size()) - 1; i >= 0; i--)
+    {
+        const tflite::Operator *op = operators->Get(i);
+        bool produces_needed = false;
+        for (int32_t out : *op->outputs())
+        {
+            if (out >= 0 && tensor_needed(bits, out))
+                produces_needed = true;
+        }
+        if (!produces_needed)
+            continue;
+        for (int32_t in : *op->inputs())
+        {
+            if (in >= 0)
+                mark_tensor(bits, in);
+        }
+    }
+}
+
+// True if 'tensor' is an input of any operator other than 'except'.
+static bool read_by_other_op(const tflite::SubGraph *subgraph, int tensor, const tflite::Operator *except)
+{
+    for (const tflite::Operator *op : *subgraph->operators())
+    {
+        if (op == except)
+            continue;
+        for (int32_t in : *op->inputs())
+        {
+            if (in == tensor)
+                return true;
+        }
+    }
+    return false;
+}
+
+static int element_count(const tflite::Tensor *tensor)
+{
+    int count = 1;
+    for (int32_t d : *tensor->shape())
+        count *= d;
+    return count;
+}
+
+static void read_tensor_params(const tflite::Tensor *tensor, TfLiteType *type, float *scale, int32_t *zero_point)
+{
+    *type = (tensor->type() == tflite::TensorType_INT8) ? kTfLiteInt8
+            : (tensor->type() == tflite::TensorType_FLOAT32) ? kTfLiteFloat32
+                                                            : kTfLiteNoType;
+    *scale = 0.0f;
+    *zero_point = 0;
+    const tflite::QuantizationParameters *q = tensor->quantization();
+    if (q != nullptr && q->scale() != nullptr && q->scale()->size() > 0)
+    {
+        *scale = q->scale()->Get(0);
+        *zero_point = static_cast<int32_t>(q->zero_point()->Get(0));
+    }
+}
+
+// Find the Concatenation(embedding, logits) producing output 0 and mark what each half
+// needs. Returns false if the model does not have that shape.
+static bool find_split(ModelHandle *handle)
+{
+    ModelOutputSplit *split = &handle->split;
+    const tflite::SubGraph *subgraph = handle->model->subgraphs()->Get(0);
+    const auto *tensors = subgraph->tensors();
+    const auto *operators = subgraph->operators();
+    const auto *opcodes = handle->model->operator_codes();
+    if (tensors->size() > static_cast<uint32_t>(kMaxModelTensors) || subgraph->outputs()->size() != 1)
+        return false;
+
+    // Output 0 must come from Concatenation(embedding, logits)
+    int output = subgraph->outputs()->Get(0);
+    const tflite::Operator *concat = nullptr;
+    for (const tflite::Operator *op : *operators)
+    {
+        if (op->outputs()->size() == 1 && op->outputs()->Get(0) == output &&
+            builtin_code(opcodes->Get(op->opcode_index())) == tflite::BuiltinOperator_CONCATENATION)
+            concat = op;
+    }
+    if (concat == nullptr || concat->inputs()->size() != 2)
+        return false;
+    split->embedding_index = concat->inputs()->Get(0);
+    split->logits_index = concat->inputs()->Get(1);
+    split->output_index = output;
+
+    const tflite::Tensor *embedding = tensors->Get(split->embedding_index);
+    const tflite::Tensor *logits = tensors->Get(split->logits_index);
+    read_tensor_params(embedding, &split->embedding_type, &split->embedding_scale, &split->embedding_zero_point);
+    read_tensor_params(logits, &split->logits_type, &split->logits_scale, &split->logits_zero_point);
+    split->embedding_dim = embedding->shape()->Get(embedding->shape()->size() - 1);
+    if (split->embedding_type == kTfLiteNoType || split->logits_type == kTfLiteNoType)
+        return false;
+
+    // Aliasing needs: inputs read only by the Concatenation, output read by nobody,
+    // batch 1 along the last axis (contiguous slices) and no requantization.
+    const tflite::Tensor *out = tensors->Get(output);
+    TfLiteType out_type;
+    float out_scale;
+    int32_t out_zero_point;
+    read_tensor_params(out, &out_type, &out_scale, &out_zero_point);
+    const tflite::ConcatenationOptions *options = concat->builtin_options_as_ConcatenationOptions();
+    int rank = static_cast<int>(out->shape()->size());
+    int axis = (options != nullptr) ? options->axis() : 0;
+    split->aliasable = options != nullptr && (axis == -1 || axis == rank - 1) &&
+                       element_count(embedding) == split->embedding_dim &&
+                       element_count(out) == split->embedding_dim + element_count(logits) &&
+                       !read_by_other_op(subgraph, split->embedding_index, concat) &&
+                       !read_by_other_op(subgraph, split->logits_index, concat) &&
+                       !read_by_other_op(subgraph, output, nullptr) &&
+                       split->embedding_type == out_type && split->logits_type == out_type &&
+                       split->embedding_scale == out_scale && split->logits_scale == out_scale &&
+                       split->embedding_zero_point == out_zero_point && split->logits_zero_point == out_zero_point;
+    split->output_bytes = element_count(out) * element_size(out_type);
+
+    mark_ancestors(subgraph, split->embedding_index, split->embedding_tensors);
+    mark_ancestors(subgraph, split->logits_index, split->logits_tensors);
+    return true;
+}
+
+// Route every registration this model uses through a trampoline
+static void install_trampolines(ModelHandle *handle)
+{
+    ModelOutputSplit *split = &handle->split;
+    static const ModelInvokeFn *gated_invokes =
+        make_gated_invoke_table(std::make_integer_sequence<int, kMaxModelOps>());
+    int slots = 0;
+    for (const tflite::OperatorCode *opcode : *handle->model->operator_codes())
+    {
+        tflite::BuiltinOperator code = builtin_code(opcode);
+        const TfLiteRegistration *found = (code == tflite::BuiltinOperator_CUSTOM)
+                                              ? handle->resolver.FindOp(opcode->custom_code()->c_str())
+                                              : handle->resolver.FindOp(code);
+        if (found == nullptr)
+            continue; // reported by the interpreter
+        TfLiteRegistration *registration = const_cast<TfLiteRegistration *>(found);
+        bool patched = false;
+        for (int i = 0; i < slots; i++)
+        {
+            if (registration->invoke == gated_invokes[i])
+                patched = true;
+        }
+        if (patched)
+            continue;
+        split->original_invoke[slots] = registration->invoke;
+        registration->invoke = gated_invokes[slots];
+#ifdef TRACE
+        // Zone names must outlive the model data: the registration's or the schema's strings
+        split->op_zones[slots] = profiler_zone(registration->custom_name != nullptr
+                                                   ? registration->custom_name
+                                                   : tflite::EnumNameBuiltinOperator(code));
+#endif
+        slots++;
+        if (split->aliasable && code == tflite::BuiltinOperator_CONCATENATION)
+        {
+            split->original_prepare = registration->prepare;
+            registration->prepare = aliasing_prepare;
+        }
+    }
+}
+
+void model_partial_setup(ModelHandle *handle)
+{
+    ModelOutputSplit *split = &handle->split;
+    memset(split, 0, sizeof(*split));
+    split->embedding_index = -1;
+    split->logits_index = -1;
+    split->output_index = -1;
+
+    bool splittable = find_split(handle);
+#ifndef TRACE
+    if (!splittable)
+        return;
+#endif
+    install_trampolines(handle);
+    split->supported = splittable;
+    if (!splittable)
+        return;
+
+    am_util_stdio_printf("[%s] Partial execution: embedding tensor %d (dim %d), logits tensor %d\r\n",
+                         handle->name, split->embedding_index, split->embedding_dim, split->logits_index);
+}
+
+TfLiteStatus model_partial_allocate(ModelHandle *handle)
+{
+    running_handle = handle;
+    TfLiteStatus status = handle->interpreter->AllocateTensors();
+    running_handle = nullptr;
+    return status;
+}
+
+void model_partial_bind(ModelHandle *handle)
+{
+    ModelOutputSplit *split = &handle->split;
+    if (!split->supported)
+        return;
+    split->embedding_data = handle->interpreter->eval_tensor(split->embedding_index)->data.data;
+    split->logits_data = handle->interpreter->eval_tensor(split->logits_index)->data.data;
+    if (split->aliased)
+        handle->output_tensor->data.data = split->output_buffer;
+
+    am_util_stdio_printf("[%s] Concatenation: %s\r\n", handle->name,
+                         split->aliased ? "zero-copy (inputs written in place, not planned)" : "copying");
+}
+
+TfLiteStatus model_partial_invoke(ModelHandle *handle, model_output_mode_t mode)
+{
+    ModelOutputSplit *split = &handle->split;
+    if (!split->supported)
+        mode = MODEL_OUTPUT_BOTH;
+    split->needed = (mode == MODEL_OUTPUT_EMBEDDING_ONLY) ? split->embedding_tensors
+                    : (mode == MODEL_OUTPUT_LOGITS_ONLY)  ? split->logits_tensors
+                                                          : nullptr;
+    handle->mode = mode;
+    running_handle = handle;
+    TfLiteStatus status = handle->interpreter->Invoke();
+    running_handle = nullptr;
+    return status;
+}
@@ -0,0 +1,26 @@
+#ifndef MODEL_PARTIAL_H_
+#define MODEL_PARTIAL_H_
+
+#include "model_runtime.h"
+
+// Partial graph execution (used by model_runtime.cc).
+
+// Find the Concatenation(embedding, logits) producing output 0, compute which tensors
+// each half needs and install gating trampolines into the handle's resolver.
+// Call after register_ops and before the interpreter is built. Leaves
+// handle->split.supported false if the model does not have that shape. With TRACE the
+// trampolines are installed for every model, to record per-op trace events.
+void model_partial_setup(ModelHandle *handle);
+
+// AllocateTensors() for the handle's interpreter. If split.output_buffer is set, the
+// Concatenation's Prepare points its inputs and output into it, so the planner does not
+// allocate them.
+TfLiteStatus model_partial_allocate(ModelHandle *handle);
+
+// Bind the intermediate embedding/logits buffers. Call after model_partial_allocate().
+void model_partial_bind(ModelHandle *handle);
+
+// Invoke the handle's interpreter, running only the ops 'mode' needs.
+TfLiteStatus model_partial_invoke(ModelHandle *handle, model_output_mode_t mode);
+
+#endif // MODEL_PARTIAL_H_
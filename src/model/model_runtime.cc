@@ -0,0 +1,648 @@
+#include "model_runtime.h"
+#include "model_partial.h"
+#include "depthwise_3x3.h"
+#include "int4_kernels.h"
+#include "shared_scratch.h"
+#include "sparse_kernels.h"
+
+#include "tensorflow/lite/micro/system_setup.h"
+#include "tensorflow/lite/micro/micro_error_reporter.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+#include "perf_mode.h"
+#include "profiler.h"
+#include "am_util.h"
+#include <cmath>
+#include <new>
+
+// Shared model region - placed in SHARED_SRAM (uninitialized).
+// Layout: [ scratch (kModelScratchArenaSize) | persistent arenas carved per model ... ]
+alignas(16) static uint8_t model_region[kModelRegionSize] __attribute__((section(".shared_bss")));
+
+static uint8_t *const scratch_arena = model_region;
+static size_t persistent_used = 0;
+
+// Dry runs build into the shared scratch (no handle keeps data there across invokes) and a
+// persistent arena of their own, as the slice of the handle being replaced is in use.
+// Plain .bss (MCU_TCM).
+alignas(16) static uint8_t dry_run_persistent[kDefaultModelPersistentSize];
+static ModelHandle dry_run_handle;
+
+// Loaded models
+static ModelHandle handles[kMaxModels];
+static int handle_count = 0;
+
+static tflite::ErrorReporter *error_reporter = nullptr;
+
+static size_t element_size(TfLiteType type)
+{
+    return (type == kTfLiteFloat32) ? sizeof(float) : sizeof(int8_t);
+}
+
+// Move a view to batch row 'row' of a tensor whose rows are row_length elements long
+static OutputView row_view(OutputView view, int row, int row_length)
+{
+    view.data = static_cast<const uint8_t *>(view.data) + row * row_length * element_size(view.type);
+    view.length = row_length;
+    return view;
+}
+
+static OutputView output_tensor_view(const ModelHandle *handle, int row)
+{
+    const TfLiteTensor *output_tensor = handle->output_tensor;
+    int total = 1;
+    for (int i = 0; i < output_tensor->dims->size; i++)
+        total *= output_tensor->dims->data[i];
+    int batch = (output_tensor->dims->size < 2) ? 1 : output_tensor->dims->data[0];
+    OutputView view = {output_tensor->data.data, handle->output_type, output_tensor->params.scale,
+                       output_tensor->params.zero_point, total, handle->output_reader};
+    return row_view(view, row, total / batch);
+}
+
+// Embedding: start of output 0, or the intermediate tensor after an EMBEDDING_ONLY run
+static OutputView embedding_view(const ModelHandle *handle, int row)
+{
+    const ModelOutputSplit &split = handle->split;
+    if (handle->mode == MODEL_OUTPUT_EMBEDDING_ONLY)
+    {
+        OutputView view = {split.embedding_data, split.embedding_type, split.embedding_scale,
+                           split.embedding_zero_point, split.embedding_dim, handle->embedding_reader};
+        return row_view(view, row, split.embedding_dim);
+    }
+    return output_tensor_view(handle, row);
+}
+
+// Logits: last kOutputSize values of an output 0 row (output is [batch, emb_dim + kOutputSize]),
+// or the intermediate tensor after a LOGITS_ONLY run
+static OutputView logits_view(const ModelHandle *handle, int row)
+{
+    const ModelOutputSplit &split = handle->split;
+    if (handle->mode == MODEL_OUTPUT_LOGITS_ONLY)
+    {
+        OutputView view = {split.logits_data, split.logits_type, split.logits_scale,
+                           split.logits_zero_point, kOutputSize, handle->logits_reader};
+        return row_view(view, row, kOutputSize);
+    }
+    OutputView view = output_tensor_view(handle, row);
+    view.data = static_cast<const uint8_t *>(view.data) + (view.length - kOutputSize) * element_size(view.type);
+    view.length = kOutputSize;
+    return view;
+}
+
+static int argmax_logits(const OutputView &view)
+{
+    return view.reader->argmax(view);
+}
+
+static void copy_embedding(const OutputView &view, float *out, int dim)
+{
+    if (dim > view.length)
+        dim = view.length;
+    view.reader->dequantize(view, out, dim);
+}
+
+static InputParams input_params(const ModelHandle *handle)
+{
+    const TfLiteTensor *input_tensor = handle->input_tensor;
+    const int *dims = input_tensor->dims->data;
+    if (handle->input_layout == MODEL_LAYOUT_NHWC)
+        return {dims[1], dims[2], input_tensor->params.scale, input_tensor->params.zero_point};
+    return {dims[2], dims[3], input_tensor->params.scale, input_tensor->params.zero_point};
+}
+
+// Normalize one image into batch slot 'slot' of the input tensor
+static void preprocess_slot(ModelHandle *handle, const InputParams &p, const uint8_t *image_data, int slot)
+{
+    size_t slot_bytes = kImageChannels * p.height * p.width * element_size(handle->input_type);
+    handle->preprocess(image_data, handle->input_tensor->data.raw + slot * slot_bytes, p);
+}
+
+// Tear down a partially built handle. The slot and its persistent arena are not
+// committed, so the next load reuses them.
+static void load_failed(ModelHandle *handle)
+{
+    if (handle->interpreter != nullptr)
+        handle->interpreter->~MicroInterpreter();
+    handle->interpreter = nullptr;
+    handle->input_tensor = nullptr;
+    handle->output_tensor = nullptr;
+}
+
+void model_runtime_init(void)
+{
+    // Set up error reporting
+    static tflite::MicroErrorReporter micro_error_reporter;
+    error_reporter = &micro_error_reporter;
+
+    // Initialize TensorFlow Lite Micro target
+    tflite::InitializeTarget();
+
+    for (int i = 0; i < handle_count; i++)
+    {
+        if (handles[i].interpreter != nullptr)
+            handles[i].interpreter->~MicroInterpreter();
+        handles[i].interpreter = nullptr;
+    }
+    handle_count = 0;
+    persistent_used = 0;
+#ifdef PROFILING
+    sparse_kernels_reset_stats();
+    int4_kernels_reset_stats();
+    depthwise_3x3_reset_stats();
+    shared_scratch_reset_stats();
+#endif
+}
+
+size_t model_runtime_free_bytes(void)
+{
+    return kModelPersistentPoolSize - persistent_used;
+}
+
+int model_runtime_arena_usage(mem_arena_usage_t *usage, int max)
+{
+    int count = 0;
+    if (count < max)
+        usage[count++] = {"model region", kModelScratchArenaSize + persistent_used, kModelRegionSize};
+    for (int i = 0; i < handle_count && count < max; i++)
+    {
+        const ModelHandle *handle = &handles[i];
+        if (handle->interpreter == nullptr)
+            continue;
+        usage[count++] = {handle->name, handle->interpreter->arena_used_bytes(),
+                          handle->persistent_arena_size + kModelScratchArenaSize};
+    }
+    return count;
+}
+
+// Build the interpreter for model_data in handle's persistent slice.
+// Returns the bytes used, or 0 on failure (reason printed, handle left unloaded).
+static size_t build_handle(ModelHandle *handle, const unsigned char *model_data)
+{
+    const char *name = handle->name;
+    size_t persistent_size = handle->persistent_arena_size;
+    handle->interpreter = nullptr;
+    handle->input_tensor = nullptr;
+    handle->output_tensor = nullptr;
+    handle->input_type = kTfLiteNoType;
+    handle->output_type = kTfLiteNoType;
+    handle->mode = MODEL_OUTPUT_BOTH;
+    handle->softmax_lut_scale = 0.0f;
+
+    // Load model from flatbuffer
+    handle->model = tflite::GetModel(model_data);
+    if (handle->model->version() != TFLITE_SCHEMA_VERSION)
+    {
+        am_util_stdio_printf("[%s] Model schema version %d not supported. Expected %d.\r\n",
+                             name, handle->model->version(), TFLITE_SCHEMA_VERSION);
+        return 0;
+    }
+
+    // Each model registers only the ops it uses into its own resolver
+    new (&handle->resolver) ModelOpResolver(error_reporter);
+    handle->register_ops(handle->resolver);
+    model_partial_setup(handle);
+
+    // Zero-copy Concatenation: output 0 takes the end of the shared scratch, which this
+    // model's plan then stops short of. Like any planned tensor it is valid until the
+    // next invoke.
+    size_t scratch_size = kModelScratchArenaSize;
+    if (handle->split.aliasable)
+    {
+        scratch_size -= (handle->split.output_bytes + 15u) & ~static_cast<size_t>(15u);
+        handle->split.output_buffer = scratch_arena + scratch_size;
+    }
+
+    // Persistent data goes to this model's slice; non-persistent tensors are planned
+    // into the shared scratch arena.
+    tflite::MicroAllocator *allocator = tflite::MicroAllocator::Create(
+        handle->persistent_arena, persistent_size,
+        scratch_arena, scratch_size, error_reporter);
+    if (allocator == nullptr)
+    {
+        am_util_stdio_printf("[%s] MicroAllocator creation failed.\r\n", name);
+        return 0;
+    }
+
+    // Build interpreter
+    handle->interpreter = new (handle->interpreter_storage) ModelInterpreter(
+        handle->model, handle->resolver, allocator, error_reporter);
+
+    // Check interpreter initialization status
+    TfLiteStatus init_status = handle->interpreter->initialization_status();
+    if (init_status != kTfLiteOk)
+    {
+        am_util_stdio_printf("[%s] Interpreter initialization failed with status: %d\r\n", name, init_status);
+        load_failed(handle);
+        return 0;
+    }
+
+    // Allocate memory for all model tensors
+    TfLiteStatus allocate_status = model_partial_allocate(handle);
+    if (allocate_status != kTfLiteOk)
+    {
+        am_util_stdio_printf("[%s] AllocateTensors() failed with status: %d\r\n", name, allocate_status);
+        load_failed(handle);
+        return 0;
+    }
+
+    handle->input_tensor = handle->interpreter->input(0);
+    handle->output_tensor = handle->interpreter->output(0);
+    handle->input_type = handle->input_tensor->type;
+    handle->output_type = handle->output_tensor->type;
+
+    // Pick the type-specialized preprocessor and output reader once
+    const TfLiteIntArray *input_dims = handle->input_tensor->dims;
+    handle->input_layout = (input_dims->size == 4 && input_dims->data[3] == kImageChannels &&
+                            input_dims->data[1] != kImageChannels)
+                               ? MODEL_LAYOUT_NHWC
+                               : MODEL_LAYOUT_NCHW;
+    handle->preprocess = model_io_preprocessor(handle->input_type, handle->input_layout);
+    handle->output_reader = model_io_reader(handle->output_type);
+    if (handle->preprocess == nullptr)
+    {
+        am_util_stdio_printf("[%s] Unsupported input type: %d (kTfLiteFloat32 or kTfLiteInt8, see MODEL_IO)\r\n",
+                             name, static_cast<int>(handle->input_type));
+        load_failed(handle);
+        return 0;
+    }
+    if (handle->output_reader == nullptr)
+    {
+        am_util_stdio_printf("[%s] Unsupported output type: %d (kTfLiteFloat32 or kTfLiteInt8, see MODEL_IO)\r\n",
+                             name, static_cast<int>(handle->output_type));
+        load_failed(handle);
+        return 0;
+    }
+    am_util_stdio_printf("[%s] Model I/O types: input=%d (1=float32, 9=int8), output=%d\r\n",
+                         name, static_cast<int>(handle->input_type), static_cast<int>(handle->output_type));
+
+    model_partial_bind(handle);
+    handle->embedding_reader = model_io_reader(handle->split.embedding_type);
+    handle->logits_reader = model_io_reader(handle->split.logits_type);
+    if (handle->embedding_reader == nullptr || handle->logits_reader == nullptr)
+        handle->split.supported = false; // intermediate type not compiled: always run in full
+
+    size_t arena_used = handle->interpreter->arena_used_bytes();
+    am_util_stdio_printf("[%s] Model loaded. Arena used: %d bytes (persistent %d + shared scratch %d)\r\n",
+                         name, (int)arena_used, (int)persistent_size, (int)scratch_size);
+    return persistent_size;
+}
+
+ModelHandle *model_runtime_load(const ModelConfig *config)
+{
+    if (config == nullptr || config->model_data == nullptr || config->register_ops == nullptr)
+        return nullptr;
+    if (error_reporter == nullptr)
+        model_runtime_init();
+    if (handle_count >= kMaxModels)
+    {
+        am_util_stdio_printf("[%s] No free model handle (max %d).\r\n", config->name, kMaxModels);
+        return nullptr;
+    }
+
+    // Carve this model's persistent arena (keep 16-byte alignment for the next one)
+    size_t persistent_size = (config->persistent_arena_size + 15u) & ~static_cast<size_t>(15u);
+    if (persistent_size > model_runtime_free_bytes())
+    {
+        am_util_stdio_printf("[%s] Persistent arena %d bytes exceeds free pool %d bytes.\r\n",
+                             config->name, (int)persistent_size, (int)model_runtime_free_bytes());
+        return nullptr;
+    }
+
+    ModelHandle *handle = &handles[handle_count];
+    handle->name = config->name;
+    handle->register_ops = config->register_ops;
+    handle->persistent_arena = model_region + kModelScratchArenaSize + persistent_used;
+    handle->persistent_arena_size = persistent_size;
+
+    size_t used = build_handle(handle, config->model_data);
+    if (used == 0)
+        return nullptr;
+    persistent_used += used;
+    handle_count++;
+    return handle;
+}
+
+int model_runtime_dry_run(const ModelHandle *handle, const unsigned char *model_data)
+{
+    if (handle == nullptr || model_data == nullptr)
+        return -1;
+    if (handle->persistent_arena_size > sizeof(dry_run_persistent))
+    {
+        am_util_stdio_printf("[%s] Dry run: persistent arena %d bytes exceeds the dry-run buffer %d bytes.\r\n",
+                             handle->name, (int)handle->persistent_arena_size, (int)sizeof(dry_run_persistent));
+        return -1;
+    }
+#ifdef PROFILING
+    // Prepare tracks the throwaway build's layers: drop them again afterwards
+    int depthwise_mark = depthwise_3x3_stats_mark();
+    int int4_mark = int4_kernels_stats_mark();
+    int sparse_mark = sparse_kernels_stats_mark();
+    int scratch_mark = shared_scratch_stats_mark();
+#endif
+
+    // Same build as model_runtime_reload(handle, model_data): the handle's ops, slice size,
+    // partial-execution setup and aliased output at the end of the shared scratch
+    ModelHandle *dry = &dry_run_handle;
+    dry->name = "dry run";
+    dry->register_ops = handle->register_ops;
+    dry->persistent_arena = dry_run_persistent;
+    dry->persistent_arena_size = handle->persistent_arena_size;
+    int ret = (build_handle(dry, model_data) != 0) ? 0 : -1;
+    load_failed(dry); // tear down (a no-op if the build failed)
+
+#ifdef PROFILING
+    depthwise_3x3_stats_rewind(depthwise_mark);
+    int4_kernels_stats_rewind(int4_mark);
+    sparse_kernels_stats_rewind(sparse_mark);
+    shared_scratch_stats_rewind(scratch_mark);
+#endif
+    return ret;
+}
+
+int model_runtime_reload(ModelHandle *handle, const unsigned char *model_data)
+{
+    if (handle == nullptr || model_data == nullptr)
+        return -1;
+    if (handle->interpreter != nullptr)
+        handle->interpreter->~MicroInterpreter();
+#ifdef PROFILING
+    sparse_kernels_reset_stats();
+    int4_kernels_reset_stats();
+    depthwise_3x3_reset_stats();
+    shared_scratch_reset_stats();
+#endif
+    return (build_handle(handle, model_data) != 0) ? 0 : -1;
+}
+
+/* --- Per-handle inference --- */
+
+void model_handle_preprocess(ModelHandle *handle, const uint8_t *image_data)
+{
+    if (handle == nullptr || handle->interpreter == nullptr || handle->input_tensor == nullptr)
+        return;
+    PROFILE_SCOPE("preprocess");
+    preprocess_slot(handle, input_params(handle), image_data, 0);
+}
+
+int model_handle_input_info(ModelHandle *handle, model_input_info_t *info)
+{
+    if (handle == nullptr || handle->input_tensor == nullptr || info == nullptr)
+        return -1;
+    const TfLiteTensor *input_tensor = handle->input_tensor;
+    info->type = handle->input_type;
+    info->scale = input_tensor->params.scale;
+    info->zero_point = input_tensor->params.zero_point;
+    for (int i = 0; i < 4; i++)
+        info->dims[i] = (i < input_tensor->dims->size) ? input_tensor->dims->data[i] : 1;
+    info->layout = handle->input_layout;
+    info->bytes = input_tensor->bytes;
+    for (int c = 0; c < 3; c++)
+    {
+        info->mean[c] = IMAGENET_MEAN[c];
+        info->std[c] = IMAGENET_STD[c];
+    }
+    return 0;
+}
+
+int8_t *model_handle_input_int8(ModelHandle *handle, size_t *len)
+{
+    if (handle == nullptr || handle->input_tensor == nullptr || handle->input_type != kTfLiteInt8)
+        return nullptr;
+    *len = handle->input_tensor->bytes;
+    return handle->input_tensor->data.int8;
+}
+
+int model_handle_invoke(ModelHandle *handle)
+{
+    return model_handle_invoke_mode(handle, MODEL_OUTPUT_BOTH);
+}
+
+int model_handle_invoke_mode(ModelHandle *handle, model_output_mode_t mode)
+{
+    if (handle == nullptr || handle->interpreter == nullptr)
+        return -1;
+    perf_mode_burst_begin(); // compute-bound: 192 MHz
+    TfLiteStatus status;
+    {
+        PROFILE_SCOPE("invoke");
+        status = model_partial_invoke(handle, mode);
+    }
+    perf_mode_burst_end();
+    return (status == kTfLiteOk) ? 0 : -1;
+}
+
+void model_handle_get_embedding(ModelHandle *handle, float *out, int dim)
+{
+    if (handle == nullptr || handle->output_tensor == nullptr || out == nullptr || dim <= 0)
+        return;
+    OutputView view = embedding_view(handle, 0);
+    if (view.data == nullptr)
+        return;
+    copy_embedding(view, out, dim);
+}
+
+int model_handle_get_embedding_int8(ModelHandle *handle, const int8_t **data, float *scale, int32_t *zero_point)
+{
+    if (handle == nullptr || handle->output_tensor == nullptr || data == nullptr)
+        return -1;
+    OutputView view = embedding_view(handle, 0);
+    if (view.data == nullptr || view.type != kTfLiteInt8)
+        return -1;
+    *data = static_cast<const int8_t *>(view.data);
+    if (scale != nullptr)
+        *scale = view.scale;
+    if (zero_point != nullptr)
+        *zero_point = view.zero_point;
+    return (handle->split.supported) ? handle->split.embedding_dim : view.length;
+}
+
+// Find predicted class from logits.
+int model_handle_find_predicted_class(ModelHandle *handle)
+{
+    if (handle == nullptr || handle->output_tensor == nullptr)
+        return -1;
+    OutputView view = logits_view(handle, 0);
+    if (view.data == nullptr)
+        return -1;
+    return argmax_logits(view);
+}
+
+void model_handle_get_logits(ModelHandle *handle, float *logits)
+{
+    if (handle == nullptr || handle->output_tensor == nullptr || logits == nullptr)
+        return;
+    OutputView view = logits_view(handle, 0);
+    if (view.data == nullptr)
+        return;
+    view.reader->dequantize(view, logits, kOutputSize);
+}
+
+// Insert class c with sort key v into the descending top-k lists (n entries so far)
+template <typename T>
+static int topk_insert(T *keys, int *idx, int n, int k, T v, int c)
+{
+    if (n == k && v <= keys[k - 1])
+        return n;
+    int pos = (n < k) ? n++ : k - 1;
+    while (pos > 0 && keys[pos - 1] < v)
+    {
+        keys[pos] = keys[pos - 1];
+        idx[pos] = idx[pos - 1];
+        pos--;
+    }
+    keys[pos] = v;
+    idx[pos] = c;
+    return n;
+}
+
+static void build_softmax_lut(ModelHandle *handle, float scale)
+{
+    for (int d = 0; d < 256; d++)
+        handle->softmax_lut[d] = static_cast<uint16_t>(lroundf(expf(-scale * d) * kModelScoreOne));
+    handle->softmax_lut_scale = scale;
+}
+
+static int topk_int8(ModelHandle *handle, const OutputView &view, int k, int *idx, uint16_t *score)
+{
+    if (handle->softmax_lut_scale != view.scale)
+        build_softmax_lut(handle, view.scale);
+    const int8_t *q = static_cast<const int8_t *>(view.data);
+    int8_t max_q = q[0];
+    for (int i = 1; i < kOutputSize; i++)
+    {
+        if (q[i] > max_q)
+            max_q = q[i];
+    }
+
+    // One pass: softmax denominator and top-k by raw value
+    int8_t keys[kOutputSize];
+    uint32_t sum = 0;
+    int n = 0;
+    for (int i = 0; i < kOutputSize; i++)
+    {
+        sum += handle->softmax_lut[max_q - q[i]];
+        n = topk_insert(keys, idx, n, k, q[i], i);
+    }
+    for (int j = 0; j < n; j++)
+    {
+        uint32_t e = handle->softmax_lut[max_q - keys[j]];
+        score[j] = static_cast<uint16_t>(((e << 15) + sum / 2) / sum);
+    }
+    return n;
+}
+
+static int topk_float(const OutputView &view, int k, int *idx, uint16_t *score)
+{
+    float logits[kOutputSize];
+    float keys[kOutputSize];
+    view.reader->dequantize(view, logits, kOutputSize);
+    float max_logit = logits[0];
+    for (int i = 1; i < kOutputSize; i++)
+    {
+        if (logits[i] > max_logit)
+            max_logit = logits[i];
+    }
+    float sum = 0.0f;
+    int n = 0;
+    for (int i = 0; i < kOutputSize; i++)
+    {
+        sum += expf(logits[i] - max_logit);
+        n = topk_insert(keys, idx, n, k, logits[i], i);
+    }
+    for (int j = 0; j < n; j++)
+        score[j] = static_cast<uint16_t>(lroundf(expf(keys[j] - max_logit) / sum * kModelScoreOne));
+    return n;
+}
+
+int model_handle_get_topk(ModelHandle *handle, int k, int *idx, uint16_t *score)
+{
+    if (handle == nullptr || handle->output_tensor == nullptr || idx == nullptr || score == nullptr || k <= 0)
+        return -1;
+    OutputView view = logits_view(handle, 0);
+    if (view.data == nullptr)
+        return -1;
+    if (k > kOutputSize)
+        k = kOutputSize;
+    if (view.type == kTfLiteInt8)
+        return topk_int8(handle, view, k, idx, score);
+    return topk_float(view, k, idx, score);
+}
+
+int model_handle_predict_class(ModelHandle *handle, const uint8_t *image_data)
+{
+    if (handle == nullptr || handle->interpreter == nullptr || handle->input_tensor == nullptr || handle->output_tensor == nullptr)
+        return -1;
+    model_handle_preprocess(handle, image_data);
+    if (model_handle_invoke_mode(handle, MODEL_OUTPUT_LOGITS_ONLY) != 0)
+        return -1;
+    return model_handle_find_predicted_class(handle);
+}
+
+/* --- Batch inference --- */
+
+int model_handle_batch_size(ModelHandle *handle)
+{
+    if (handle == nullptr || handle->input_tensor == nullptr || handle->input_tensor->dims->size < 4)
+        return 1;
+    return handle->input_tensor->dims->data[0];
+}
+
+int model_handle_run_batch(ModelHandle *handle, const uint8_t *const *images, int n,
+                           model_output_mode_t mode, model_batch_output_t *outputs,
+                           model_batch_timing_t *timing)
+{
+    if (handle == nullptr || handle->interpreter == nullptr || handle->input_tensor == nullptr ||
+        handle->output_tensor == nullptr || images == nullptr || outputs == nullptr || n <= 0)
+        return 0;
+
+    const InputParams params = input_params(handle);
+    const int batch = model_handle_batch_size(handle);
+    model_batch_timing_t t = {};
+    int done = 0;
+#ifdef PROFILING
+    uint32_t t0, t1;
+#endif
+
+    for (int start = 0; start < n; start += batch)
+    {
+        int count = (n - start < batch) ? n - start : batch;
+#ifdef PROFILING
+        t0 = profiler_get_cycles();
+#endif
+        // Unused slots of a partial last batch keep stale data; their rows are ignored
+        for (int slot = 0; slot < count; slot++)
+            preprocess_slot(handle, params, images[start + slot], slot);
+#ifdef PROFILING
+        t1 = profiler_get_cycles();
+        t.preprocess_cyc += t1 - t0;
+        t0 = t1;
+#endif
+        TfLiteStatus status = model_partial_invoke(handle, mode);
+        t.invokes++;
+#ifdef PROFILING
+        t1 = profiler_get_cycles();
+        t.invoke_cyc += t1 - t0;
+        t0 = t1;
+#endif
+        for (int slot = 0; slot < count; slot++)
+        {
+            model_batch_output_t *out = &outputs[start + slot];
+            out->label = -1;
+            if (status != kTfLiteOk)
+                continue;
+            if (mode != MODEL_OUTPUT_EMBEDDING_ONLY)
+                out->label = argmax_logits(logits_view(handle, slot));
+            if (mode != MODEL_OUTPUT_LOGITS_ONLY && out->embedding != nullptr && out->embedding_dim > 0)
+                copy_embedding(embedding_view(handle, slot), out->embedding, out->embedding_dim);
+        }
+#ifdef PROFILING
+        t.output_cyc += profiler_get_cycles() - t0;
+#endif
+        if (status == kTfLiteOk)
+            done += count;
+        t.images += count;
+    }
+
+    if (timing != nullptr)
+        *timing = t;
+    return done;
+}
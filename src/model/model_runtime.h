@@ -0,0 +1,255 @@
+#ifndef MODEL_RUNTIME_H_
+#define MODEL_RUNTIME_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "model_io.h"
+#include "model_settings.h"
+#include "mem_report.h"
+#include "profiler.h"
+
+#include "tensorflow/lite/micro/micro_allocator.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
+#include "tensorflow/lite/c/common.h"
+
+// Multi-model runtime.
+//
+// All models share one region in SHARED_SRAM:
+//   [ shared scratch (non-persistent) | model 0 persistent | model 1 persistent | ... ]
+// Persistent arenas (tensor structs, quant params, kernel op data) are carved per model.
+// The scratch part (activations, im2col buffers) is planned separately by every model
+// but backed by the same memory, so it is only valid for the model that ran last:
+// preprocess -> invoke -> read outputs of one handle before touching another.
+
+// Op resolver type used by every handle (each handle owns its own instance)
+typedef tflite::MicroMutableOpResolver<kMaxModelOps> ModelOpResolver;
+
+// Registers the operators a model needs into its resolver.
+typedef void (*ModelRegisterOps)(ModelOpResolver &resolver);
+
+struct ModelConfig
+{
+    const char *name;                  // for logs only
+    const unsigned char *model_data;   // .tflite flatbuffer (16-byte aligned)
+    size_t persistent_arena_size;      // bytes carved from the shared region for this model
+    ModelRegisterOps register_ops;
+};
+
+// Which half of a Concatenation(embedding, logits) output a call needs.
+// EMBEDDING_ONLY / LOGITS_ONLY skip every op the other half needs (e.g. the classifier
+// head and the final Concatenation) and read the result from the intermediate tensor.
+typedef enum
+{
+    MODEL_OUTPUT_BOTH = 0,
+    MODEL_OUTPUT_EMBEDDING_ONLY,
+    MODEL_OUTPUT_LOGITS_ONLY
+} model_output_mode_t;
+
+typedef TfLiteStatus (*ModelInvokeFn)(TfLiteContext *context, TfLiteNode *node);
+
+// MicroInterpreter with access to eval tensors (to re-point intermediate tensor buffers)
+class ModelInterpreter : public tflite::MicroInterpreter
+{
+public:
+    using tflite::MicroInterpreter::MicroInterpreter;
+
+    TfLiteEvalTensor *eval_tensor(int index)
+    {
+        return context().GetEvalTensor(&context(), index);
+    }
+};
+
+// Partial graph execution state (see model_partial.cc). Only set up for models whose
+// output 0 is produced by Concatenation(embedding, logits); with TRACE every model gets
+// the trampolines (original_invoke, op_zones) for its per-op events.
+struct ModelOutputSplit
+{
+    bool supported;
+    int embedding_index; // subgraph tensor indices of the Concatenation inputs
+    int logits_index;
+    int output_index;    // and of its output (output 0)
+    int embedding_dim;
+    TfLiteType embedding_type;
+    TfLiteType logits_type;
+    float embedding_scale;
+    float logits_scale;
+    int32_t embedding_zero_point;
+    int32_t logits_zero_point;
+
+    // Zero-copy Concatenation: embedding and logits are only read by the Concatenation,
+    // so their producers write straight into slices of output_buffer and the
+    // Concatenation itself is skipped. output_buffer (output_bytes, at the end of the
+    // shared scratch) is set before AllocateTensors(); the planner then leaves out all
+    // three tensors.
+    bool aliasable;
+    bool aliased;
+    size_t output_bytes;
+    uint8_t *output_buffer;
+    ModelInvokeFn original_prepare; // of the Concatenation, replaced while aliasable
+
+    // Intermediate tensor data (bound after AllocateTensors)
+    const void *embedding_data;
+    const void *logits_data;
+
+    // Bit t set: tensor t must be produced for that half. needed points at one of them
+    // during a partial call, nullptr when every op runs.
+    uint32_t embedding_tensors[kMaxModelTensors / 32];
+    uint32_t logits_tensors[kMaxModelTensors / 32];
+    const uint32_t *needed;
+
+    // Kernel invoke functions replaced by the gating trampolines, per resolver slot
+    ModelInvokeFn original_invoke[kMaxModelOps];
+#ifdef TRACE
+    profiler_zone_t op_zones[kMaxModelOps]; // trace zone per slot, named after the op
+#endif
+};
+
+struct ModelHandle
+{
+    const char *name;
+    const tflite::Model *model;
+    ModelOpResolver resolver;
+    ModelInterpreter *interpreter;
+    TfLiteTensor *input_tensor;
+    TfLiteTensor *output_tensor;
+
+    // Data types detected at load (for int8 vs fp32 preprocess / output handling)
+    TfLiteType input_type;
+    TfLiteType output_type;
+
+    // Type-specialized variants chosen at load (see model_io.h)
+    model_input_layout_t input_layout;
+    ModelPreprocessFn preprocess;
+    const OutputReaderOps *output_reader;
+    const OutputReaderOps *embedding_reader;
+    const OutputReaderOps *logits_reader;
+
+    ModelRegisterOps register_ops;
+    uint8_t *persistent_arena;
+    size_t persistent_arena_size;
+
+    ModelOutputSplit split;
+    model_output_mode_t mode; // of the last invoke
+
+    // exp(-scale * d) in Q15 for int8 logit differences d = max - q (fixed-point softmax),
+    // built for softmax_lut_scale on first use
+    uint16_t softmax_lut[256];
+    float softmax_lut_scale;
+
+    // Backing storage for the interpreter (constructed in place at load)
+    alignas(ModelInterpreter) uint8_t interpreter_storage[sizeof(ModelInterpreter)];
+};
+
+// Reset the runtime. Unloads all handles and returns the whole region to the free pool.
+void model_runtime_init(void);
+
+// Load a model into the next free handle. Returns nullptr on failure (reason printed).
+ModelHandle *model_runtime_load(const ModelConfig *config);
+
+// Bytes of the shared region not yet carved out for persistent arenas.
+size_t model_runtime_free_bytes(void);
+
+// Arena usage for mem_report(): the shared region, then one entry per loaded model
+// (TFLM arena_used_bytes() against its persistent slice + the shared scratch).
+// Fills up to max entries and returns the count.
+int model_runtime_arena_usage(mem_arena_usage_t *usage, int max);
+
+// Check that model_runtime_reload(handle, model_data) would succeed: the same build (ops,
+// persistent slice size, partial-execution setup, aliased output) into the shared scratch
+// and a dry-run persistent arena. handle and other loaded handles stay usable.
+// Returns 0 on success.
+int model_runtime_dry_run(const ModelHandle *handle, const unsigned char *model_data);
+
+// Rebuild a loaded handle in place from new flatbuffer data, reusing its persistent
+// slice. Returns 0 on success; on failure the handle is unloaded (rebuild it again).
+int model_runtime_reload(ModelHandle *handle, const unsigned char *model_data);
+
+// --- Per-handle inference ---
+
+// Copy image (RGB uint8 HWC) into the handle's input tensor.
+void model_handle_preprocess(ModelHandle *handle, const uint8_t *image_data);
+
+// Input tensor description, so a host can prepare inputs itself.
+typedef struct
+{
+    TfLiteType type;
+    float scale;        // int8 quantization (0 / 0 for float inputs)
+    int32_t zero_point;
+    int dims[4];        // tensor shape as stored: N, C, H, W or N, H, W, C (see layout)
+    model_input_layout_t layout;
+    size_t bytes;
+    float mean[3];      // per-channel normalization applied by model_handle_preprocess():
+    float std[3];       // (pixel / 255 - mean) / std
+} model_input_info_t;
+
+// Fill info for the handle's input tensor. Returns 0 on success.
+int model_handle_input_info(ModelHandle *handle, model_input_info_t *info);
+
+// The int8 input tensor itself, for callers that write an already normalized and quantized
+// input straight into it (no preprocessing, no copy). Sets *len to its size in bytes.
+// Returns nullptr if the input is not int8. Valid until the handle is reloaded.
+int8_t *model_handle_input_int8(ModelHandle *handle, size_t *len);
+
+// Run forward pass. Returns 0 on success.
+int model_handle_invoke(ModelHandle *handle);
+
+// Run only the ops needed for 'mode' (falls back to a full run if the model's output is
+// not an embedding/logits Concatenation). Read back only what the mode produced.
+int model_handle_invoke_mode(ModelHandle *handle, model_output_mode_t mode);
+
+// Copy first 'dim' floats of the embedding into out.
+void model_handle_get_embedding(ModelHandle *handle, float *out, int dim);
+
+// Zero-copy view of an int8 embedding: sets *data, *scale, *zero_point and returns the
+// embedding dimension, or -1 if the embedding is not int8. Valid until the next invoke
+// of any handle (output 0 lives in the shared scratch).
+int model_handle_get_embedding_int8(ModelHandle *handle, const int8_t **data, float *scale, int32_t *zero_point);
+
+// Index of the largest logit (logits are the last kOutputSize values of output 0).
+int model_handle_find_predicted_class(ModelHandle *handle);
+
+// Probability 1.0 of model_handle_get_topk() scores (Q15)
+constexpr int kModelScoreOne = 1 << 15;
+
+// Top-k classes of the last invoke, best first, with softmax probabilities in Q15
+// (kModelScoreOne = 1.0). int8 logits use a fixed-point softmax (exp from a LUT, no
+// float math). Returns the number of entries written (min(k, kOutputSize)), -1 on failure.
+int model_handle_get_topk(ModelHandle *handle, int k, int *idx, uint16_t *score);
+
+// Copy the kOutputSize dequantized logits into logits.
+void model_handle_get_logits(ModelHandle *handle, float *logits);
+
+// Preprocess + invoke (logits only) + argmax. Returns -1 on failure.
+int model_handle_predict_class(ModelHandle *handle, const uint8_t *image_data);
+
+// --- Batch inference ---
+
+typedef struct
+{
+    int label;        // predicted class, -1 if not computed (EMBEDDING_ONLY) or on failure
+    float *embedding; // optional: receives embedding_dim floats (not for LOGITS_ONLY)
+    int embedding_dim;
+} model_batch_output_t;
+
+typedef struct
+{
+    uint32_t images;
+    uint32_t invokes;        // < images when the model takes several images per Invoke()
+    uint64_t preprocess_cyc; // PROFILING only
+    uint64_t invoke_cyc;
+    uint64_t output_cyc;
+} model_batch_timing_t;
+
+// Images per Invoke(): the input's batch dimension (1 unless exported with batch > 1).
+int model_handle_batch_size(ModelHandle *handle);
+
+// Run n images. State checks and tensor parameters are resolved once per call, and
+// models exported with batch > 1 take up to that many images per Invoke().
+// timing (optional) receives per-batch totals. Returns the number of images processed.
+int model_handle_run_batch(ModelHandle *handle, const uint8_t *const *images, int n,
+                           model_output_mode_t mode, model_batch_output_t *outputs,
+                           model_batch_timing_t *timing);
+
+#endif // MODEL_RUNTIME_H_
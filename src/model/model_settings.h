@@ -19,11 +19,41 @@ constexpr int kOutputSize = kCategoryCount;
 // Category labels for CIFAR-10 dataset
 extern const char *kCategoryLabels[kCategoryCount];
 
-// Tensor arena size for TensorFlow Lite Micro
-// This needs to be large enough to hold all intermediate tensors
-// Adjust based on your model's memory requirements
-// Apollo4 Plus: Allocated in SHARED_SRAM (1MB available)
-// Can use larger sizes since it's separate from TCM
-constexpr int kTensorArenaSize = 200 * 1024; // 200KB
+// Tensor arena sizes for TensorFlow Lite Micro
+// All models are carved from one region in SHARED_SRAM (1MB available):
+//   - scratch: non-persistent tensors (activations, kernel scratch). Shared by every
+//     loaded model, so it must hold the largest model's intermediate tensors.
+//   - persistent pool: per-model tensor metadata, quant params and kernel op data.
+// Adjust based on your models' memory requirements
+constexpr int kModelScratchArenaSize = 200 * 1024;   // 200KB
+constexpr int kModelPersistentPoolSize = 96 * 1024;  // 96KB, split across models
+constexpr int kModelRegionSize = kModelScratchArenaSize + kModelPersistentPoolSize;
+
+// Kernel scratch (im2col, input patches) shared by all conv-type layers, in TCM (see
+// kernels/shared_scratch.h). Size for the largest layer: the PROFILING boot log prints it.
+constexpr int kSharedScratchSize = 32 * 1024; // 32KB
+
+// SHARED_SRAM buffer for model weights loaded at runtime (SD card / UART).
+// Must hold the whole .tflite flatbuffer (the built-in model is ~531KB).
+constexpr int kModelSramSize = 576 * 1024;
+
+// Persistent arena of the default (embedding + classifier) model
+constexpr int kDefaultModelPersistentSize = 64 * 1024;
+
+// Persistent arena of the cascade gate classifier (MODEL_CASCADE builds)
+constexpr int kGateModelPersistentSize = 16 * 1024;
+
+// Cascade: return the gate classifier's answer when its top-1 softmax probability
+// exceeds the runner-up by at least this margin (0..1). Runtime-adjustable.
+constexpr float kCascadeMarginThreshold = 0.6f;
+
+// Number of models that can be loaded at the same time
+constexpr int kMaxModels = 2;
+
+// Operators per model op resolver
+constexpr int kMaxModelOps = 21;
+
+// Tensors per model tracked for partial graph execution (larger models always run in full)
+constexpr int kMaxModelTensors = 512;
 
 #endif // MODEL_SETTINGS_H_
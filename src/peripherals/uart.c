@@ -233,6 +233,61 @@ void uart_write_bytes(const uint8_t *data, uint32_t len)
     CHECK_ERRORS(am_hal_uart_transfer(phUART, &sUartWrite));
 }
 
+//*****************************************************************************
+//
+// UART read raw bytes (blocking until len bytes arrived)
+//
+//*****************************************************************************
+void uart_read_bytes(uint8_t *data, uint32_t len)
+{
+    if (data == NULL || len == 0)
+    {
+        return;
+    }
+
+    uint32_t ui32BytesRead = 0;
+
+    const am_hal_uart_transfer_t sUartRead =
+    {
+        .eType = AM_HAL_UART_BLOCKING_READ,
+        .pui8Data = data,
+        .ui32NumBytes = len,
+        .ui32TimeoutMs = AM_HAL_UART_WAIT_FOREVER,
+        .pui32BytesTransferred = &ui32BytesRead,
+    };
+
+    CHECK_ERRORS(am_hal_uart_transfer(phUART, &sUartRead));
+}
+
+//*****************************************************************************
+//
+// UART read raw bytes, giving up after timeout_ms. Returns 0 once len bytes
+// arrived, -1 on timeout (the bytes read so far are dropped).
+//
+//*****************************************************************************
+int uart_read_bytes_timeout(uint8_t *data, uint32_t len, uint32_t timeout_ms)
+{
+    if (data == NULL || len == 0)
+    {
+        return 0;
+    }
+
+    uint32_t ui32BytesRead = 0;
+
+    const am_hal_uart_transfer_t sUartRead =
+    {
+        .eType = AM_HAL_UART_BLOCKING_READ,
+        .pui8Data = data,
+        .ui32NumBytes = len,
+        .ui32TimeoutMs = timeout_ms,
+        .pui32BytesTransferred = &ui32BytesRead,
+    };
+
+    // A timeout is reported as an error status: not fatal here
+    am_hal_uart_transfer(phUART, &sUartRead);
+    return (ui32BytesRead == len) ? 0 : -1;
+}
+
 void uart_init()
 {
     //
@@ -81,6 +81,8 @@ extern void uart_print(char *pcStr);
 extern int  uart_getchar(void);
 extern void uart_init();
 extern void uart_write_bytes(const uint8_t *data, uint32_t len);
+extern void uart_read_bytes(uint8_t *data, uint32_t len);
+extern int  uart_read_bytes_timeout(uint8_t *data, uint32_t len, uint32_t timeout_ms);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,21 @@
+/**
+ * CRC-32 (IEEE 802.3, same as zlib.crc32 / binascii.crc32 on the host).
+ */
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Continue a CRC over len bytes. Start with crc = 0; feed chunks in order. */
+uint32_t crc32_update(uint32_t crc, const void *data, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CRC32_H */
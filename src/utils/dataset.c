@@ -0,0 +1,144 @@
+/**
+ * Packed image dataset reader (see dataset.h).
+ */
+#include "dataset.h"
+
+#include <string.h>
+
+#include "am_util.h"
+#include "crc32.h"
+
+static int read_at(dataset_t *ds, FSIZE_t offset, void *buf, UINT len)
+{
+    if (ds->extent != NULL)
+        return (offset <= 0xFFFFFFFFu) ? rawpart_read(ds->extent, (uint32_t)offset, buf, len) : -1;
+    UINT n;
+    if (f_lseek(&ds->file, offset) != FR_OK || f_read(&ds->file, buf, len, &n) != FR_OK || n != len)
+        return -1;
+    return 0;
+}
+
+/* Geometry the reader relies on: sector-aligned, non-overlapping records after the labels */
+static int check_header(const dataset_header_t *h, FSIZE_t file_size)
+{
+    if (h->magic != DATASET_MAGIC || h->count == 0 || h->image_bytes == 0)
+        return -1;
+    if (h->image_bytes != (uint32_t)h->width * h->height * h->channels || h->stride < h->image_bytes)
+        return -1;
+    if (h->stride % DATASET_SECTOR != 0 || h->data_offset % DATASET_SECTOR != 0)
+        return -1;
+    if (h->data_offset < sizeof(dataset_header_t) + h->count)
+        return -1;
+    if ((FSIZE_t)h->data_offset + (FSIZE_t)(h->count - 1) * h->stride + h->image_bytes > file_size)
+        return -1;
+    return 0;
+}
+
+/* CRC of the label array, read through the label cache buffer */
+static int check_labels(dataset_t *ds)
+{
+    uint32_t crc = 0;
+    for (uint32_t done = 0; done < ds->header.count;)
+    {
+        UINT n = (UINT)(ds->header.count - done);
+        if (n > sizeof(ds->labels))
+            n = sizeof(ds->labels);
+        if (read_at(ds, sizeof(dataset_header_t) + done, ds->labels, n) != 0)
+            return -1;
+        crc = crc32_update(crc, ds->labels, n);
+        done += n;
+    }
+    return crc == ds->header.labels_crc32 ? 0 : -1;
+}
+
+/* Header and labels of an opened source of size bytes */
+static int load(dataset_t *ds, const char *name, FSIZE_t size)
+{
+    if (read_at(ds, 0, &ds->header, sizeof(ds->header)) != 0 || check_header(&ds->header, size) != 0)
+    {
+        am_util_stdio_printf("[dataset] %s: bad header\r\n", name);
+        return -1;
+    }
+    if (check_labels(ds) != 0)
+    {
+        am_util_stdio_printf("[dataset] %s: label CRC mismatch\r\n", name);
+        return -1;
+    }
+    return 0; /* check_labels() left the cache empty (label_count 0) */
+}
+
+int dataset_open(dataset_t *ds, const char *path)
+{
+    memset(ds, 0, sizeof(*ds));
+    if (f_open(&ds->file, path, FA_READ) != FR_OK)
+    {
+        am_util_stdio_printf("[dataset] Cannot open %s\r\n", path);
+        return -1;
+    }
+    if (fastseek_enable(&ds->file, ds->clmt, FASTSEEK_CLMT_LEN) != 0)
+        am_util_stdio_printf("[dataset] %s: too fragmented for fast seek\r\n", path);
+    if (load(ds, path, f_size(&ds->file)) != 0)
+    {
+        f_close(&ds->file);
+        return -1;
+    }
+    return 0;
+}
+
+int dataset_open_raw(dataset_t *ds, const rawpart_extent_t *extent)
+{
+    memset(ds, 0, sizeof(*ds));
+    ds->extent = extent;
+    return load(ds, extent->name, extent->bytes);
+}
+
+void dataset_close(dataset_t *ds)
+{
+    if (ds->extent == NULL)
+        f_close(&ds->file);
+}
+
+uint32_t dataset_count(const dataset_t *ds)
+{
+    return ds->header.count;
+}
+
+uint32_t dataset_stride(const dataset_t *ds)
+{
+    return ds->header.stride;
+}
+
+int dataset_label(dataset_t *ds, uint32_t i)
+{
+    if (i >= ds->header.count)
+        return -1;
+    if (i < ds->label_base || i >= ds->label_base + ds->label_count)
+    {
+        /* Refill with the block of DATASET_SECTOR labels holding i */
+        uint32_t base = i - i % DATASET_SECTOR;
+        uint32_t n = ds->header.count - base;
+        if (n > sizeof(ds->labels))
+            n = sizeof(ds->labels);
+        if (read_at(ds, sizeof(dataset_header_t) + base, ds->labels, (UINT)n) != 0)
+        {
+            ds->label_count = 0;
+            return -1;
+        }
+        ds->label_base = base;
+        ds->label_count = n;
+    }
+    uint8_t label = ds->labels[i - ds->label_base];
+    return label == DATASET_NO_LABEL ? -1 : label;
+}
+
+int dataset_read(dataset_t *ds, uint32_t first, uint32_t count, uint8_t *buf, uint32_t buf_size)
+{
+    const dataset_header_t *h = &ds->header;
+    if (count == 0 || first >= h->count || count > h->count - first)
+        return -1;
+    uint32_t len = (count - 1) * h->stride + h->image_bytes;
+    if (len > buf_size)
+        return -1;
+    /* One f_read: whole sectors go to the card as a single multi-block transfer per cluster */
+    return read_at(ds, (FSIZE_t)h->data_offset + (FSIZE_t)first * h->stride, buf, (UINT)len);
+}
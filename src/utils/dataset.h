@@ -0,0 +1,90 @@
+/**
+ * Packed image dataset: all images of a run in one file on the SD card, read by index.
+ *
+ * File layout (written by python_scripts/pack_images.py):
+ *   dataset_header_t (32 bytes)
+ *   labels: one byte per image (DATASET_NO_LABEL if unknown)
+ *   zero padding up to data_offset (a multiple of 512)
+ *   images: count records of image_bytes, stride bytes apart (stride a multiple of 512)
+ *
+ * The file is opened once; image i is then a seek and one f_read(). Records start on a
+ * sector boundary and span whole sectors, so FatFs transfers them straight into the
+ * caller's buffer as multi-block reads (split only at cluster boundaries), with no
+ * directory lookup or FIL per image. The seek uses the file's cluster link map
+ * (fastseek.h), built at open, instead of walking the FAT chain.
+ *
+ * The same file can also be an extent of the raw data partition (rawpart.h,
+ * dataset_open_raw()): reads then go to the card by LBA and skip FatFs altogether.
+ */
+#ifndef DATASET_H
+#define DATASET_H
+
+#include <stdint.h>
+
+#include "fastseek.h"
+#include "ff.h"
+#include "rawpart.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DATASET_MAGIC 0x31534449u /* "IDS1" */
+#define DATASET_SECTOR 512u
+#define DATASET_NO_LABEL 0xFFu
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t count; /* images */
+    uint16_t width;
+    uint16_t height;
+    uint16_t channels;
+    uint16_t reserved;
+    uint32_t image_bytes;  /* width * height * channels */
+    uint32_t stride;       /* bytes from one record to the next */
+    uint32_t data_offset;  /* first record, from the start of the file */
+    uint32_t labels_crc32; /* CRC-32 of the label array */
+} dataset_header_t;
+
+typedef struct
+{
+    FIL file;
+    DWORD clmt[FASTSEEK_CLMT_LEN];  /* cluster link map of file */
+    const rawpart_extent_t *extent; /* raw partition source, or NULL for file */
+    dataset_header_t header;
+    uint32_t label_base;            /* first label held in labels[] */
+    uint32_t label_count;           /* labels held (0: none cached) */
+    uint8_t labels[DATASET_SECTOR];
+} dataset_t;
+
+/** Open and check a dataset file (magic, geometry, label CRC). Returns 0, or -1 (reason printed). */
+int dataset_open(dataset_t *ds, const char *path);
+
+/** Open and check a dataset stored as an extent of the mounted raw partition. Returns 0, or -1. */
+int dataset_open_raw(dataset_t *ds, const rawpart_extent_t *extent);
+
+/** Close the file (nothing to do for a raw extent). */
+void dataset_close(dataset_t *ds);
+
+/** Images in the dataset. */
+uint32_t dataset_count(const dataset_t *ds);
+
+/** Label of image i, or -1 if unknown / unreadable. Sequential calls read one sector per 512 images. */
+int dataset_label(dataset_t *ds, uint32_t i);
+
+/**
+ * Read images first .. first + count - 1 into buf, one record every stride bytes
+ * (dataset_stride(); equal to image_bytes when that is a multiple of 512). buf_size must
+ * hold (count - 1) * stride + image_bytes. Returns 0, or -1 on a range or read error.
+ */
+int dataset_read(dataset_t *ds, uint32_t first, uint32_t count, uint8_t *buf, uint32_t buf_size);
+
+/** Bytes between records in dataset_read() output. */
+uint32_t dataset_stride(const dataset_t *ds);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DATASET_H */
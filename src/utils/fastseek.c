@@ -0,0 +1,22 @@
+/**
+ * FatFs fast seek setup (see fastseek.h).
+ */
+#include "fastseek.h"
+
+#include <stddef.h>
+
+int fastseek_enable(FIL *fp, DWORD *clmt, UINT len)
+{
+#if FF_USE_FASTSEEK
+    clmt[0] = len;
+    fp->cltbl = clmt;
+    if (f_lseek(fp, CREATE_LINKMAP) == FR_OK)
+        return 0;
+    fp->cltbl = NULL; /* FR_NOT_ENOUGH_CORE leaves the FIL usable without the table */
+#else
+    (void)fp;
+    (void)clmt;
+    (void)len;
+#endif
+    return -1;
+}
@@ -0,0 +1,35 @@
+/**
+ * FatFs fast seek (FF_USE_FASTSEEK) for large read-only files: index buckets, datasets.
+ *
+ * Without it every f_lseek() backwards (or from a fresh FIL) follows the FAT chain from
+ * the first cluster: O(offset) get_fat() calls, each a FAT sector read on FAT32 or a
+ * fragmented exFAT file. fastseek_enable() walks the chain once and stores it as a
+ * cluster link map table (CLMT) of (length, first cluster) pairs per fragment; seeks
+ * then look the cluster up in the table. Keep the FIL open across reads so the table
+ * is built once.
+ *
+ * The table lives as long as the FIL (usually next to it in the reader's struct). A
+ * file with the table set must not grow: open it read-only.
+ */
+#ifndef FASTSEEK_H
+#define FASTSEEK_H
+
+#include "ff.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FASTSEEK_CLMT_LEN 64 /* DWORDs: a file of up to 31 fragments */
+
+/**
+ * Build the CLMT of an open file into clmt (len DWORDs) and attach it.
+ * Returns 0; -1 if the file has more fragments than fit (it then seeks the slow way).
+ */
+int fastseek_enable(FIL *fp, DWORD *clmt, UINT len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FASTSEEK_H */
@@ -0,0 +1,132 @@
+/**
+ * Memory usage report: stack painting, high-water marks and section sizes (see mem_report.h).
+ */
+#include "mem_report.h"
+
+#if defined(__arm__)
+
+#include <malloc.h>
+
+#include "am_mcu_apollo.h"
+#include "am_util.h"
+
+#define mem_log am_util_stdio_printf
+
+#define MEM_PAINT_MARGIN 64 /* bytes left unpainted below the caller's SP */
+
+/* libs/linker_script.ld */
+extern uint32_t __stack_start__[], __stack_end__[];
+extern uint8_t __heap_start__[], __heap_end__[];
+extern uint8_t _stcm[], _etcm[];
+extern uint8_t _sdata[], _edata[];
+extern uint8_t _sbss[], _ebss[];
+extern uint8_t __shared_bss_start__[], __shared_bss_end__[];
+extern uint8_t __tcm_origin__[], __tcm_length__[];
+extern uint8_t __shared_sram_origin__[], __shared_sram_length__[];
+
+__attribute__((noinline)) void mem_paint_stack(void)
+{
+    uint32_t state = am_hal_interrupt_master_disable();
+    uint32_t *sp = (uint32_t *)(uintptr_t)__get_MSP();
+    uint32_t *end = sp - MEM_PAINT_MARGIN / sizeof(uint32_t);
+    for (uint32_t *p = __stack_start__; p < end; p++)
+        *p = MEM_STACK_PAINT;
+    am_hal_interrupt_master_set(state);
+}
+
+size_t mem_stack_high_water(void)
+{
+    const uint32_t *p = __stack_start__;
+    while (p < __stack_end__ && *p == MEM_STACK_PAINT)
+        p++;
+    return (size_t)((uintptr_t)__stack_end__ - (uintptr_t)p);
+}
+
+size_t mem_stack_size(void)
+{
+    return (size_t)((uintptr_t)__stack_end__ - (uintptr_t)__stack_start__);
+}
+
+size_t mem_heap_high_water(void)
+{
+    struct mallinfo mi = mallinfo();
+    return (size_t)mi.arena;
+}
+
+static void report_section(const char *name, const void *start, const void *end)
+{
+    mem_log("  %-12s %8u bytes @ 0x%08x\r\n", name, (unsigned)((uintptr_t)end - (uintptr_t)start),
+            (unsigned)(uintptr_t)start);
+}
+
+static void report_region(const char *name, const void *origin, const void *end, uintptr_t length)
+{
+    uint32_t used = (uint32_t)((uintptr_t)end - (uintptr_t)origin);
+    mem_log("  %-12s %8u / %u bytes (%u free)\r\n", name, (unsigned)used, (unsigned)length,
+            (unsigned)(length - used));
+}
+
+static void report_sections(void)
+{
+    size_t stack_size = mem_stack_size();
+    size_t stack_hw = mem_stack_high_water();
+    size_t heap_size = (size_t)(__heap_end__ - __heap_start__);
+    size_t heap_hw = mem_heap_high_water();
+
+    mem_log("  stack        %8u / %u bytes high-water (%u spare)\r\n", (unsigned)stack_hw, (unsigned)stack_size,
+            (unsigned)(stack_size - stack_hw));
+    if (heap_hw > heap_size)
+        mem_log("  heap         %8u / %u bytes high-water (past .heap!)\r\n", (unsigned)heap_hw, (unsigned)heap_size);
+    else
+        mem_log("  heap         %8u / %u bytes high-water\r\n", (unsigned)heap_hw, (unsigned)heap_size);
+    report_section(".tcm", _stcm, _etcm);
+    report_section(".data", _sdata, _edata);
+    report_section(".bss", _sbss, _ebss);
+    report_section(".shared_bss", __shared_bss_start__, __shared_bss_end__);
+    report_region("MCU_TCM", __tcm_origin__, _ebss, (uintptr_t)__tcm_length__);
+    report_region("SHARED_SRAM", __shared_sram_origin__, __shared_bss_end__, (uintptr_t)__shared_sram_length__);
+}
+
+#else /* host: no linker symbols or stack to paint */
+
+#include <stdio.h>
+
+#define mem_log printf
+
+void mem_paint_stack(void)
+{
+}
+
+size_t mem_stack_high_water(void)
+{
+    return 0;
+}
+
+size_t mem_stack_size(void)
+{
+    return 0;
+}
+
+size_t mem_heap_high_water(void)
+{
+    return 0;
+}
+
+static void report_sections(void)
+{
+    mem_log("  (stack, heap and sections: target only)\r\n");
+}
+
+#endif
+
+void mem_report(const mem_arena_usage_t *arenas, int arena_count)
+{
+    mem_log("\r\n--- Memory ---\r\n");
+    report_sections();
+    for (int i = 0; i < arena_count; i++)
+    {
+        mem_log("  %-12s %8u / %u bytes arena\r\n", arenas[i].name, (unsigned)arenas[i].used,
+                (unsigned)arenas[i].size);
+    }
+    mem_log("--- End Memory ---\r\n\r\n");
+}
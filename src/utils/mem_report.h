@@ -0,0 +1,53 @@
+/**
+ * Memory usage report: stack and heap high-water marks, section sizes, model arenas.
+ *
+ * mem_paint_stack() fills the unused part of the stack with a known pattern at boot
+ * (first thing in main()); the stack high-water mark is then the deepest word that no
+ * longer holds the pattern. It is a lower bound: a frame that reserved space without
+ * writing it is not seen. The heap high-water mark is what malloc has taken from sbrk
+ * so far (newlib mallinfo; nothing here calls malloc unless a library does).
+ *
+ * Section sizes come from linker symbols (libs/linker_script.ld). mem_report() prints
+ * them against the MCU_TCM and SHARED_SRAM budgets, followed by the arenas the caller
+ * passes in (model_runtime_arena_usage()). Off target (no __arm__) only the arenas are
+ * reported.
+ */
+#ifndef MEM_REPORT_H
+#define MEM_REPORT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MEM_STACK_PAINT 0xC0FFEE5Au
+
+typedef struct
+{
+    const char *name;
+    size_t used; /* bytes in use (high-water for TFLM arenas) */
+    size_t size; /* bytes reserved */
+} mem_arena_usage_t;
+
+/** Paint the stack below the caller's frame. Call once, early in main(). */
+void mem_paint_stack(void);
+
+/** Deepest stack use since mem_paint_stack(), in bytes (0 off target). */
+size_t mem_stack_high_water(void);
+
+/** Stack bytes reserved by the linker script (0 off target). */
+size_t mem_stack_size(void);
+
+/** Heap bytes taken from sbrk so far (0 off target). */
+size_t mem_heap_high_water(void);
+
+/** Print stack / heap high-water, .tcm/.data/.bss/.shared_bss sizes and the given arenas. */
+void mem_report(const mem_arena_usage_t *arenas, int arena_count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MEM_REPORT_H */
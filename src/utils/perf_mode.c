@@ -0,0 +1,312 @@
+/**
+ * CPU performance mode manager (see perf_mode.h).
+ */
+#if !defined(__arm__)
+#define _POSIX_C_SOURCE 199309L /* clock_gettime for the simulated clock */
+#endif
+
+#include "perf_mode.h"
+
+#include <stddef.h>
+
+#ifdef PROFILING
+#include "profiler.h"
+#endif
+#ifdef TRACE
+#include "trace.h"
+#endif
+
+#define PERF_MODE_LP_HZ 96000000u
+#define PERF_MODE_HP_HZ 192000000u
+
+#if defined(__arm__)
+
+#include "am_mcu_apollo.h"
+#include "am_util.h"
+
+#define perf_mode_log am_util_stdio_printf
+
+static int hw_select(perf_mode_t mode)
+{
+    am_hal_pwrctrl_mcu_mode_e hw = (mode == PERF_MODE_HIGH_PERFORMANCE) ? AM_HAL_PWRCTRL_MCU_MODE_HIGH_PERFORMANCE
+                                                                        : AM_HAL_PWRCTRL_MCU_MODE_LOW_POWER;
+    return (am_hal_pwrctrl_mcu_mode_select(hw) == AM_HAL_STATUS_SUCCESS) ? 0 : -1;
+}
+
+static perf_mode_t hw_status(void)
+{
+    am_hal_pwrctrl_mcu_mode_e hw;
+    if (am_hal_pwrctrl_mcu_mode_status(&hw) != AM_HAL_STATUS_SUCCESS)
+        return PERF_MODE_LOW_POWER;
+    return (hw == AM_HAL_PWRCTRL_MCU_MODE_HIGH_PERFORMANCE) ? PERF_MODE_HIGH_PERFORMANCE : PERF_MODE_LOW_POWER;
+}
+
+/* STIMER from the 3 MHz HFRC divider: keeps its rate across core clock switches */
+static void timer_start(void)
+{
+    am_hal_stimer_config(AM_HAL_STIMER_CFG_CLEAR | AM_HAL_STIMER_CFG_FREEZE);
+    am_hal_stimer_config(AM_HAL_STIMER_HFRC_3MHZ);
+}
+
+uint32_t perf_mode_timer(void)
+{
+    return am_hal_stimer_counter_get();
+}
+
+#else /* simulated clock */
+
+#include <stdio.h>
+#include <time.h>
+
+#define perf_mode_log printf
+
+static perf_mode_t sim_mode = PERF_MODE_LOW_POWER;
+static uint64_t sim_base_cycles = 0;
+static uint64_t sim_base_ns = 0;
+
+static uint64_t host_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t mode_hz(perf_mode_t mode);
+
+uint64_t perf_mode_sim_cycles(void)
+{
+    uint64_t ns = host_ns();
+    if (sim_base_ns == 0)
+        sim_base_ns = ns;
+    return sim_base_cycles + (uint64_t)((double)(ns - sim_base_ns) * mode_hz(sim_mode) / 1e9);
+}
+
+static int hw_select(perf_mode_t mode)
+{
+    /* Cycles so far were counted at the old clock */
+    sim_base_cycles = perf_mode_sim_cycles();
+    sim_base_ns = host_ns();
+    sim_mode = mode;
+    return 0;
+}
+
+static perf_mode_t hw_status(void)
+{
+    return sim_mode;
+}
+
+static void timer_start(void)
+{
+}
+
+uint32_t perf_mode_timer(void)
+{
+    return (uint32_t)(host_ns() * (PERF_MODE_TIMER_HZ / 1000000u) / 1000u);
+}
+
+#endif
+
+#ifdef PERF_MODE_TURBO
+static int burst_enabled = 1;
+#else
+static int burst_enabled = 0;
+#endif
+static int burst_supported = 0;
+static perf_mode_t base_mode = PERF_MODE_LOW_POWER; /* outside bursts */
+static perf_mode_t current = PERF_MODE_LOW_POWER;
+static int burst_depth = 0;
+static int io_depth = 0;
+
+#ifdef PROFILING
+static uint32_t bursts = 0;
+static uint32_t switches = 0;
+static uint64_t switch_cycles = 0;
+static uint64_t mode_cycles[PERF_MODE_COUNT]; /* cycles counted in each mode up to mode_since */
+static uint64_t mode_since = 0;
+#endif
+
+static uint32_t mode_hz(perf_mode_t mode)
+{
+    return (mode == PERF_MODE_HIGH_PERFORMANCE) ? PERF_MODE_HP_HZ : PERF_MODE_LP_HZ;
+}
+
+static int switch_to(perf_mode_t mode)
+{
+#ifdef PROFILING
+    perf_mode_t previous = current;
+    uint32_t t0 = profiler_get_cycles();
+#endif
+    int status = hw_select(mode);
+    if (status == 0)
+        current = mode;
+#ifdef TRACE
+    trace_set_clock(mode_hz(current));
+#endif
+#ifdef PROFILING
+    uint32_t t1 = profiler_get_cycles();
+    switches++;
+    switch_cycles += t1 - t0;
+    /* The switch itself is counted in the old mode */
+    uint64_t now = profiler_now();
+    mode_cycles[previous] += now - mode_since;
+    mode_since = now;
+#endif
+    return status;
+}
+
+/* Mode a burst runs in */
+static perf_mode_t burst_mode(void)
+{
+    return (burst_enabled && burst_supported) ? PERF_MODE_HIGH_PERFORMANCE : base_mode;
+}
+
+static void apply(void)
+{
+    perf_mode_t want = base_mode;
+    if (io_depth > 0)
+        want = PERF_MODE_LOW_POWER;
+    else if (burst_depth > 0)
+        want = burst_mode();
+    if (want != current)
+        switch_to(want);
+}
+
+int perf_mode_init(void)
+{
+    burst_depth = 0;
+    io_depth = 0;
+    base_mode = PERF_MODE_LOW_POWER;
+    timer_start();
+    if (hw_select(PERF_MODE_HIGH_PERFORMANCE) == 0 && hw_status() == PERF_MODE_HIGH_PERFORMANCE)
+        burst_supported = 1;
+    if (hw_select(PERF_MODE_LOW_POWER) != 0)
+    {
+        perf_mode_log("Failed to select low power mode\r\n");
+        return -1;
+    }
+    current = PERF_MODE_LOW_POWER;
+#ifdef TRACE
+    trace_set_clock(PERF_MODE_LP_HZ);
+#endif
+#ifdef PROFILING
+    mode_cycles[PERF_MODE_LOW_POWER] = 0;
+    mode_cycles[PERF_MODE_HIGH_PERFORMANCE] = 0;
+    mode_since = profiler_now();
+#endif
+    if (!burst_supported)
+        perf_mode_log("High performance mode not available, staying at 96 MHz\r\n");
+    return 0;
+}
+
+int perf_mode_set(perf_mode_t mode)
+{
+    if (burst_depth > 0 || io_depth > 0)
+        return -1;
+    if (mode == PERF_MODE_HIGH_PERFORMANCE && !burst_supported)
+        return -1;
+    base_mode = mode;
+    return (mode == current) ? 0 : switch_to(mode);
+}
+
+perf_mode_t perf_mode_get(void)
+{
+    return hw_status();
+}
+
+uint32_t perf_mode_clock_hz(void)
+{
+    return mode_hz(hw_status());
+}
+
+uint32_t perf_mode_hz(perf_mode_t mode)
+{
+    return mode_hz(mode);
+}
+
+uint32_t perf_mode_burst_hz(void)
+{
+    return mode_hz(burst_mode());
+}
+
+uint32_t perf_mode_io_hz(void)
+{
+    return PERF_MODE_LP_HZ;
+}
+
+int perf_mode_burst_enable(int enabled)
+{
+    int previous = burst_enabled;
+    burst_enabled = enabled;
+    apply();
+    return previous;
+}
+
+void perf_mode_burst_begin(void)
+{
+#ifdef PROFILING
+    if (burst_depth == 0)
+        bursts++;
+#endif
+    burst_depth++;
+    apply();
+}
+
+void perf_mode_burst_end(void)
+{
+    if (burst_depth > 0)
+        burst_depth--;
+    apply();
+}
+
+void perf_mode_io_begin(void)
+{
+    io_depth++;
+    apply();
+}
+
+void perf_mode_io_end(void)
+{
+    if (io_depth > 0)
+        io_depth--;
+    apply();
+}
+
+uint32_t perf_mode_timer_us(uint32_t ticks)
+{
+    return ticks / (PERF_MODE_TIMER_HZ / 1000000u);
+}
+
+#ifdef PROFILING
+void perf_mode_cycles(uint64_t cycles[PERF_MODE_COUNT])
+{
+    cycles[PERF_MODE_LOW_POWER] = mode_cycles[PERF_MODE_LOW_POWER];
+    cycles[PERF_MODE_HIGH_PERFORMANCE] = mode_cycles[PERF_MODE_HIGH_PERFORMANCE];
+    cycles[current] += profiler_now() - mode_since;
+}
+
+uint64_t perf_mode_cycles_at(const uint64_t cycles[PERF_MODE_COUNT], uint32_t clock_hz)
+{
+    /* In double: cycles * clock_hz overflows 64 bits after a few minutes */
+    return (uint64_t)((double)cycles[PERF_MODE_LOW_POWER] * clock_hz / PERF_MODE_LP_HZ +
+                      (double)cycles[PERF_MODE_HIGH_PERFORMANCE] * clock_hz / PERF_MODE_HP_HZ + 0.5);
+}
+
+uint64_t perf_mode_burst_cycles(void)
+{
+    uint64_t cycles[PERF_MODE_COUNT];
+    perf_mode_cycles(cycles);
+    return perf_mode_cycles_at(cycles, perf_mode_burst_hz());
+}
+
+void perf_mode_report(void)
+{
+    uint64_t cycles[PERF_MODE_COUNT];
+    perf_mode_cycles(cycles);
+    uint64_t hp = cycles[PERF_MODE_HIGH_PERFORMANCE];
+    perf_mode_log("\r\n--- Perf mode (bursts %s, %lu MHz) ---\r\n", burst_enabled ? "on" : "off",
+                  (unsigned long)(perf_mode_burst_hz() / 1000000u));
+    perf_mode_log("bursts: %lu, mode switches: %lu (avg %lu cyc)\r\n", (unsigned long)bursts,
+                  (unsigned long)switches, (unsigned long)(switches ? switch_cycles / switches : 0));
+    perf_mode_log("time at 192 MHz: %.2f ms\r\n", profiler_cycles_to_ms(hp, PERF_MODE_HP_HZ));
+}
+#endif
@@ -0,0 +1,100 @@
+/**
+ * CPU performance mode: 96 MHz low power, 192 MHz high performance (TurboSPOT burst).
+ *
+ * Compute-bound phases (Invoke(), IVF search) run inside perf_mode_burst_begin/end and
+ * get the 192 MHz clock; everything else stays at 96 MHz. SD transfers inside a burst
+ * are wrapped in perf_mode_io_begin/end (diskio.c) and drop back to 96 MHz while the
+ * core only waits on SPI. Both pairs nest; the mode only changes when the outcome does.
+ *
+ * DWT cycles count core clocks, so convert them to time with the clock of the mode they
+ * were measured in: perf_mode_burst_hz() for code inside a burst, perf_mode_io_hz() for SD
+ * transfers (profiler_cycles_to_ms). For an interval that spans switches (a burst with
+ * SD reads in it), take perf_mode_cycles() at both ends: it counts cycles per mode, and
+ * perf_mode_cycles_at() turns the difference into cycles at a single clock.
+ *
+ * For wall time that does not depend on the core clock (or on PROFILING), use the
+ * fixed-rate timer: perf_mode_timer() ticks at PERF_MODE_TIMER_HZ (STIMER).
+ *
+ * Off target (no __arm__) the same API runs on a simulated clock: mode switches only
+ * change the rate at which profiler_get_cycles() advances.
+ */
+#ifndef PERF_MODE_H
+#define PERF_MODE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PERF_MODE_TIMER_HZ 3000000u
+
+typedef enum
+{
+    PERF_MODE_LOW_POWER = 0,        /* 96 MHz */
+    PERF_MODE_HIGH_PERFORMANCE = 1  /* 192 MHz */
+} perf_mode_t;
+
+#define PERF_MODE_COUNT 2
+
+/** Start in low power mode and probe the burst clock. Returns 0 on success, -1 on error. */
+int perf_mode_init(void);
+
+/** Switch now (outside bursts). Returns 0 on success, -1 on error. */
+int perf_mode_set(perf_mode_t mode);
+
+/** Current mode and core clock, as reported by the power controller. */
+perf_mode_t perf_mode_get(void);
+uint32_t perf_mode_clock_hz(void);
+
+/** Core clock of a mode. */
+uint32_t perf_mode_hz(perf_mode_t mode);
+
+/** Core clock inside bursts (96 MHz when bursts are disabled or not supported). */
+uint32_t perf_mode_burst_hz(void);
+
+/** Core clock inside perf_mode_io_begin/end. */
+uint32_t perf_mode_io_hz(void);
+
+/** Allow bursts (make TURBO=0 starts with them disabled). Returns the previous setting. */
+int perf_mode_burst_enable(int enabled);
+
+/** Compute-bound section: high performance mode until the matching _end. */
+void perf_mode_burst_begin(void);
+void perf_mode_burst_end(void);
+
+/** I/O wait inside a burst: low power mode until the matching _end. */
+void perf_mode_io_begin(void);
+void perf_mode_io_end(void);
+
+/** Fixed-rate timer ticks (PERF_MODE_TIMER_HZ, started by perf_mode_init). Wraps after ~23 min: use differences. */
+uint32_t perf_mode_timer(void);
+
+/** Microseconds for a difference of perf_mode_timer() values. */
+uint32_t perf_mode_timer_us(uint32_t ticks);
+
+#if !defined(__arm__)
+/** Simulated DWT->CYCCNT: advances with host time at the simulated core clock. */
+uint64_t perf_mode_sim_cycles(void);
+#endif
+
+#ifdef PROFILING
+/** Cycles counted so far in each mode, indexed by perf_mode_t (profiler_now() time base). */
+void perf_mode_cycles(uint64_t cycles[PERF_MODE_COUNT]);
+
+/** Per-mode cycles (e.g. a difference of perf_mode_cycles()) as cycles at clock_hz: same time. */
+uint64_t perf_mode_cycles_at(const uint64_t cycles[PERF_MODE_COUNT], uint32_t clock_hz);
+
+/** Cycles so far at the burst clock (perf_mode_cycles_at): a counter for intervals that
+ * span mode switches, converted with perf_mode_burst_hz(). */
+uint64_t perf_mode_burst_cycles(void);
+
+/** Bursts, mode switches and their cost so far. */
+void perf_mode_report(void);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PERF_MODE_H */
@@ -1,16 +1,499 @@
 /**
- * Profiling: DWT cycle counter for high-level timing.
+ * Profiling: DWT cycle counter, 64-bit timestamps and named zones (see profiler.h).
  * Only built with PROFILING.
  */
 #include "profiler.h"
 
 #ifdef PROFILING
 
+#include <string.h>
+
+#include "perf_mode.h"
+#include "trace.h"
+
+#define PROFILER_MAX_ZONES 48 /* with TRACE, also one per TFLM op type */
+
+/* Log-linear histogram: values 0..3 exactly, then 4 buckets per power of two up to 2^40 */
+#define PROFILER_HIST_SUB_BITS 2
+#define PROFILER_HIST_SUB (1 << PROFILER_HIST_SUB_BITS)
+#define PROFILER_HIST_MAX_EXP 40
+#define PROFILER_HIST_BUCKETS (PROFILER_HIST_SUB + (PROFILER_HIST_MAX_EXP - PROFILER_HIST_SUB_BITS + 1) * PROFILER_HIST_SUB)
+
+#if defined(__arm__)
+
 #include "am_mcu_apollo.h"
+#include "am_util.h"
+
+#define profiler_log am_util_stdio_printf
+
+static uint32_t last_cycles = 0;
+static uint64_t wraps = 0; /* high word, in units of 2^32 */
+
+void profiler_init(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    last_cycles = 0;
+    wraps = 0;
+}
 
 uint32_t profiler_get_cycles(void)
 {
     return DWT->CYCCNT;
 }
 
+uint64_t profiler_now(void)
+{
+    uint32_t state = am_hal_interrupt_master_disable();
+    uint32_t now = DWT->CYCCNT;
+    if (now < last_cycles)
+        wraps += 1ull << 32;
+    last_cycles = now;
+    uint64_t t = wraps | now;
+    am_hal_interrupt_master_set(state);
+    return t;
+}
+
+#else /* host: simulated core clock (perf_mode.c), from CLOCK_MONOTONIC */
+
+#include <stdio.h>
+
+#define profiler_log printf
+
+static uint64_t start_cycles = 0;
+
+void profiler_init(void)
+{
+    start_cycles = perf_mode_sim_cycles();
+}
+
+uint32_t profiler_get_cycles(void)
+{
+    return (uint32_t)profiler_now();
+}
+
+uint64_t profiler_now(void)
+{
+    return perf_mode_sim_cycles() - start_cycles;
+}
+
+#endif
+
+typedef struct
+{
+    const char *name;
+    uint64_t start[PERF_MODE_COUNT]; /* perf_mode_cycles() at begin */
+    uint32_t count;
+    uint64_t total;
+    uint64_t min;
+    uint64_t max;
+    uint64_t last;
+    uint32_t clock_hz;
+    uint32_t hist[PROFILER_HIST_BUCKETS];
+#ifdef PROFILER_COUNTERS
+    profiler_counters_t counters; /* raw window sums */
+#endif
+} profiler_zone_data_t;
+
+static profiler_zone_data_t zones[PROFILER_MAX_ZONES];
+static int zone_count = 0;
+
+#ifdef PROFILER_COUNTERS
+
+#define PROFILER_MAX_DEPTH 8       /* open zones a counter window is added to */
+#define PROFILER_WINDOW_CYCLES 128 /* SysTick reload for a window; with entry/exit it stays < 256 */
+#define PROFILER_CALIBRATION_WINDOWS 64
+
+/* Open zones, innermost last (read by the SysTick handler) */
+static volatile profiler_zone_t active_zones[PROFILER_MAX_DEPTH];
+static volatile int active_depth = 0;
+
+/* Window sums over the calibration loop: the sampler's own cost */
+static profiler_counters_t overhead;
+
+static void active_push(profiler_zone_t zone)
+{
+    if (active_depth < PROFILER_MAX_DEPTH)
+        active_zones[active_depth] = zone;
+    active_depth++;
+}
+
+static void active_pop(void)
+{
+    if (active_depth > 0)
+        active_depth--;
+}
+
+static void counters_add(profiler_counters_t *sum, const profiler_counters_t *window)
+{
+    sum->samples += window->samples;
+    sum->cycles += window->cycles;
+    sum->cpi += window->cpi;
+    sum->lsu += window->lsu;
+    sum->exc += window->exc;
+    sum->sleep += window->sleep;
+    sum->fold += window->fold;
+}
+
+/* sum minus samples x mean overhead, clamped at 0 */
+static uint64_t counter_correct(uint64_t sum, uint32_t samples, uint64_t overhead_sum)
+{
+    uint64_t cost = overhead.samples ? overhead_sum * samples / overhead.samples : 0;
+    return (sum > cost) ? sum - cost : 0;
+}
+
+#if defined(__arm__)
+
+typedef struct
+{
+    uint32_t cycles;
+    uint8_t cpi, lsu, exc, sleep, fold;
+} dwt_snapshot_t;
+
+static volatile int sampler_running = 0;
+static volatile int calibrating = 0;
+static int window_open = 0;
+static dwt_snapshot_t window_start;
+static uint32_t sampler_seed = 0x2545F491u;
+
+static inline void dwt_snapshot(dwt_snapshot_t *s)
+{
+    s->cycles = DWT->CYCCNT;
+    s->cpi = (uint8_t)DWT->CPICNT;
+    s->lsu = (uint8_t)DWT->LSUCNT;
+    s->exc = (uint8_t)DWT->EXCCNT;
+    s->sleep = (uint8_t)DWT->SLEEPCNT;
+    s->fold = (uint8_t)DWT->FOLDCNT;
+}
+
+/* Jittered so the windows don't lock onto a loop's period */
+static uint32_t next_period(void)
+{
+    sampler_seed ^= sampler_seed << 13;
+    sampler_seed ^= sampler_seed >> 17;
+    sampler_seed ^= sampler_seed << 5;
+    uint32_t base = calibrating ? PROFILER_SAMPLE_PERIOD / 16 : PROFILER_SAMPLE_PERIOD;
+    return base + (sampler_seed & 4095u);
+}
+
+static void window_add(const dwt_snapshot_t *start, const dwt_snapshot_t *end)
+{
+    profiler_counters_t window;
+    window.cycles = end->cycles - start->cycles;
+    if (window.cycles >= 256)
+        return; /* another interrupt ran long: the 8-bit counters may have wrapped */
+    window.samples = 1;
+    window.cpi = (uint8_t)(end->cpi - start->cpi);
+    window.lsu = (uint8_t)(end->lsu - start->lsu);
+    window.exc = (uint8_t)(end->exc - start->exc);
+    window.sleep = (uint8_t)(end->sleep - start->sleep);
+    window.fold = (uint8_t)(end->fold - start->fold);
+    if (calibrating)
+    {
+        counters_add(&overhead, &window);
+        return;
+    }
+    int depth = (active_depth < PROFILER_MAX_DEPTH) ? active_depth : PROFILER_MAX_DEPTH;
+    for (int i = 0; i < depth; i++)
+    {
+        profiler_zone_t zone = active_zones[i];
+        if (zone >= 0 && zone < zone_count)
+            counters_add(&zones[zone].counters, &window);
+    }
+}
+
+/* Alternates a long gap and a PROFILER_WINDOW_CYCLES window; the window is measured from
+ * the last read here to the first read in the next interrupt. */
+void SysTick_Handler(void)
+{
+    if (window_open)
+    {
+        dwt_snapshot_t end;
+        dwt_snapshot(&end);
+        SysTick->LOAD = next_period() - 1;
+        SysTick->VAL = 0;
+        window_open = 0;
+        window_add(&window_start, &end);
+    }
+    else
+    {
+        SysTick->LOAD = PROFILER_WINDOW_CYCLES - 1;
+        SysTick->VAL = 0;
+        window_open = 1;
+        dwt_snapshot(&window_start);
+    }
+}
+
+#define NOP8 "nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n"
+
+/* Windows over straight-line NOPs: whatever they count is the sampler's own cost */
+static void calibrate(void)
+{
+    memset(&overhead, 0, sizeof(overhead));
+    calibrating = 1;
+    for (uint32_t i = 0; i < 100000u && overhead.samples < PROFILER_CALIBRATION_WINDOWS; i++)
+        __asm volatile(NOP8 NOP8 NOP8 NOP8 NOP8 NOP8 NOP8 NOP8);
+    calibrating = 0;
+}
+
+int profiler_counters_enable(int enabled)
+{
+    int previous = sampler_running;
+    if (enabled && !previous)
+    {
+        DWT->CPICNT = 0;
+        DWT->LSUCNT = 0;
+        DWT->EXCCNT = 0;
+        DWT->SLEEPCNT = 0;
+        DWT->FOLDCNT = 0;
+        DWT->CTRL |= DWT_CTRL_CPIEVTENA_Msk | DWT_CTRL_LSUEVTENA_Msk | DWT_CTRL_EXCEVTENA_Msk |
+                     DWT_CTRL_SLEEPEVTENA_Msk | DWT_CTRL_FOLDEVTENA_Msk;
+        window_open = 0;
+        NVIC_SetPriority(SysTick_IRQn, (1u << __NVIC_PRIO_BITS) - 1u);
+        SysTick->LOAD = next_period() - 1;
+        SysTick->VAL = 0;
+        SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_ENABLE_Msk;
+        sampler_running = 1;
+        if (overhead.samples == 0)
+            calibrate();
+    }
+    else if (!enabled && previous)
+    {
+        SysTick->CTRL = 0;
+        sampler_running = 0;
+    }
+    return previous;
+}
+
+#else /* host: no DWT event counters */
+
+int profiler_counters_enable(int enabled)
+{
+    (void)enabled;
+    return 0;
+}
+
+#endif
+
+int profiler_zone_counters(profiler_zone_t zone, profiler_counters_t *counters)
+{
+    if (zone < 0 || zone >= zone_count || counters == NULL)
+        return -1;
+    const profiler_counters_t *raw = &zones[zone].counters;
+    counters->samples = raw->samples;
+    counters->cycles = counter_correct(raw->cycles, raw->samples, overhead.exc); /* entry/exit of the sampler */
+    counters->cpi = counter_correct(raw->cpi, raw->samples, overhead.cpi);
+    counters->lsu = counter_correct(raw->lsu, raw->samples, overhead.lsu);
+    counters->exc = counter_correct(raw->exc, raw->samples, overhead.exc);
+    counters->sleep = counter_correct(raw->sleep, raw->samples, overhead.sleep);
+    counters->fold = counter_correct(raw->fold, raw->samples, overhead.fold);
+    return 0;
+}
+
+static double counter_share(uint64_t count, uint64_t cycles)
+{
+    return cycles ? 100.0 * (double)count / (double)cycles : 0.0;
+}
+
+static void counters_report(void)
+{
+    profiler_log("--- DWT counters (%% of sampled cycles; cycles per call estimated from the mean) ---\r\n");
+    profiler_log("%-20s %7s %7s %7s %7s %7s %7s %12s %12s\r\n", "zone", "samples", "stall%", "lsu%", "exc%",
+                 "sleep%", "fold%", "stall/call", "lsu/call");
+    for (int i = 0; i < zone_count; i++)
+    {
+        profiler_counters_t c;
+        if (profiler_zone_counters(i, &c) != 0 || c.samples == 0 || zones[i].count == 0)
+            continue;
+        uint64_t mean = zones[i].total / zones[i].count;
+        double stall = counter_share(c.cpi, c.cycles);
+        double lsu = counter_share(c.lsu, c.cycles);
+        profiler_log("%-20s %7lu %7.1f %7.1f %7.1f %7.1f %7.1f %12llu %12llu\r\n", zones[i].name,
+                     (unsigned long)c.samples, stall, lsu, counter_share(c.exc, c.cycles),
+                     counter_share(c.sleep, c.cycles), counter_share(c.fold, c.cycles),
+                     (unsigned long long)(mean * stall / 100.0), (unsigned long long)(mean * lsu / 100.0));
+    }
+}
+
+#endif /* PROFILER_COUNTERS */
+
+double profiler_cycles_to_ms(uint64_t cycles, uint32_t clock_hz)
+{
+    return (clock_hz > 0) ? (double)cycles * 1000.0 / (double)clock_hz : 0.0;
+}
+
+static int hist_bucket(uint64_t v)
+{
+    if (v < PROFILER_HIST_SUB)
+        return (int)v;
+    int e = 63 - __builtin_clzll(v);
+    if (e > PROFILER_HIST_MAX_EXP)
+        return PROFILER_HIST_BUCKETS - 1;
+    int m = (int)(v >> (e - PROFILER_HIST_SUB_BITS)) & (PROFILER_HIST_SUB - 1);
+    return PROFILER_HIST_SUB + (e - PROFILER_HIST_SUB_BITS) * PROFILER_HIST_SUB + m;
+}
+
+/* Middle of a bucket's value range */
+static uint64_t hist_value(int bucket)
+{
+    if (bucket < PROFILER_HIST_SUB)
+        return (uint64_t)bucket;
+    int e = (bucket - PROFILER_HIST_SUB) / PROFILER_HIST_SUB + PROFILER_HIST_SUB_BITS;
+    uint64_t m = (uint64_t)((bucket - PROFILER_HIST_SUB) % PROFILER_HIST_SUB);
+    uint64_t low = (PROFILER_HIST_SUB + m) << (e - PROFILER_HIST_SUB_BITS);
+    uint64_t width = 1ull << (e - PROFILER_HIST_SUB_BITS);
+    return low + width / 2;
+}
+
+static uint64_t percentile(const profiler_zone_data_t *z, uint32_t pct)
+{
+    uint32_t rank = (uint32_t)(((uint64_t)z->count * pct + 99) / 100); /* 1-based */
+    uint32_t seen = 0;
+    for (int b = 0; b < PROFILER_HIST_BUCKETS; b++)
+    {
+        seen += z->hist[b];
+        if (seen >= rank)
+        {
+            uint64_t v = hist_value(b);
+            return (v < z->min) ? z->min : (v > z->max) ? z->max : v;
+        }
+    }
+    return z->max;
+}
+
+profiler_zone_t profiler_zone(const char *name)
+{
+    for (int i = 0; i < zone_count; i++)
+    {
+        if (zones[i].name == name)
+            return i;
+    }
+    for (int i = 0; i < zone_count; i++)
+    {
+        if (strcmp(zones[i].name, name) == 0)
+            return i;
+    }
+    if (zone_count >= PROFILER_MAX_ZONES)
+        return -1;
+    memset(&zones[zone_count], 0, sizeof(zones[zone_count]));
+    zones[zone_count].name = name;
+    return zone_count++;
+}
+
+int profiler_zone_count(void)
+{
+    return zone_count;
+}
+
+const char *profiler_zone_name(profiler_zone_t zone)
+{
+    return (zone >= 0 && zone < zone_count) ? zones[zone].name : NULL;
+}
+
+void profiler_zone_begin(profiler_zone_t zone)
+{
+    if (zone >= 0 && zone < zone_count)
+        perf_mode_cycles(zones[zone].start);
+#ifdef TRACE
+    trace_record(TRACE_EVENT_BEGIN, zone, 0);
+#endif
+#ifdef PROFILER_COUNTERS
+    active_push(zone);
+#endif
+}
+
+/*
+ * A zone may span mode switches (a burst with SD reads in it), so the elapsed cycles are
+ * taken per mode and expressed at one clock: the zone's clock once it has samples,
+ * otherwise the fastest clock the zone ran at.
+ */
+void profiler_zone_end(profiler_zone_t zone)
+{
+    uint64_t now[PERF_MODE_COUNT];
+    perf_mode_cycles(now);
+#ifdef PROFILER_COUNTERS
+    active_pop();
+#endif
+#ifdef TRACE
+    trace_record(TRACE_EVENT_END, zone, 0);
+#endif
+    if (zone < 0 || zone >= zone_count)
+        return;
+    profiler_zone_data_t *z = &zones[zone];
+    uint64_t elapsed[PERF_MODE_COUNT];
+    for (int m = 0; m < PERF_MODE_COUNT; m++)
+        elapsed[m] = now[m] - z->start[m];
+    uint32_t hz = z->clock_hz;
+    if (z->count == 0 || hz == 0)
+        hz = perf_mode_hz(elapsed[PERF_MODE_HIGH_PERFORMANCE] > 0 ? PERF_MODE_HIGH_PERFORMANCE : PERF_MODE_LOW_POWER);
+    profiler_zone_add(zone, perf_mode_cycles_at(elapsed, hz), hz);
+}
+
+void profiler_zone_add(profiler_zone_t zone, uint64_t cycles, uint32_t clock_hz)
+{
+    if (zone < 0 || zone >= zone_count)
+        return;
+    profiler_zone_data_t *z = &zones[zone];
+    if (z->count == 0 || cycles < z->min)
+        z->min = cycles;
+    if (cycles > z->max)
+        z->max = cycles;
+    z->count++;
+    z->total += cycles;
+    z->last = cycles;
+    z->clock_hz = clock_hz;
+    z->hist[hist_bucket(cycles)]++;
+}
+
+int profiler_zone_stats(profiler_zone_t zone, profiler_stats_t *stats)
+{
+    if (zone < 0 || zone >= zone_count || stats == NULL)
+        return -1;
+    const profiler_zone_data_t *z = &zones[zone];
+    memset(stats, 0, sizeof(*stats));
+    stats->count = z->count;
+    stats->clock_hz = z->clock_hz;
+    if (z->count == 0)
+        return 0;
+    stats->min = z->min;
+    stats->max = z->max;
+    stats->mean = z->total / z->count;
+    stats->last = z->last;
+    stats->p50 = percentile(z, 50);
+    stats->p99 = percentile(z, 99);
+    return 0;
+}
+
+void profiler_report(void)
+{
+    profiler_log("\r\n--- Profile (cycles; ms at each zone's clock) ---\r\n");
+    profiler_log("%-20s %6s %12s %12s %12s %12s %12s %9s %9s\r\n", "zone", "count", "mean", "min", "max", "p50",
+                 "p99", "mean ms", "p99 ms");
+    for (int i = 0; i < zone_count; i++)
+    {
+        profiler_stats_t s;
+        if (profiler_zone_stats(i, &s) != 0 || s.count == 0)
+            continue;
+        profiler_log("%-20s %6lu %12llu %12llu %12llu %12llu %12llu %9.2f %9.2f\r\n", zones[i].name,
+                     (unsigned long)s.count, (unsigned long long)s.mean, (unsigned long long)s.min,
+                     (unsigned long long)s.max, (unsigned long long)s.p50, (unsigned long long)s.p99,
+                     profiler_cycles_to_ms(s.mean, s.clock_hz), profiler_cycles_to_ms(s.p99, s.clock_hz));
+    }
+#ifdef PROFILER_COUNTERS
+    counters_report();
+#endif
+    profiler_log("--- End Profile ---\r\n\r\n");
+}
+
+void profiler_reset(void)
+{
+    for (int i = 0; i < zone_count; i++)
+    {
+        const char *name = zones[i].name;
+        memset(&zones[i], 0, sizeof(zones[i]));
+        zones[i].name = name;
+    }
+}
+
 #endif /* PROFILING */
@@ -1,6 +1,30 @@
 /**
- * Profiling helpers: DWT cycle counter for high-level timing.
- * Only active when PROFILING is defined.
+ * Profiling: DWT cycle counter, 64-bit timestamps and named zones.
+ * Only active when PROFILING is defined; the macros compile away otherwise.
+ *
+ * A zone collects samples (cycles between begin and end, or added directly) and keeps
+ * count / min / max / mean and a log-linear histogram for p50 / p99. profiler_report()
+ * prints every zone. From C:
+ *
+ *     PROFILE_BEGIN("ivf");  ...  PROFILE_END("ivf");
+ *
+ * from C++, for the rest of the enclosing block:
+ *
+ *     PROFILE_SCOPE("tflite");
+ *
+ * Zone ids are looked up once per call site. A zone can't be nested in itself. Timestamps extend the 32-bit DWT->CYCCNT (wraps after
+ * ~44 s at 96 MHz) to 64 bits; the extension sees every wrap as long as profiler_now()
+ * (any zone begin/end) runs at least once per wrap period. The host build counts cycles
+ * of the simulated core clock (perf_mode.h) from a monotonic clock.
+ *
+ * With PROFILER_COUNTERS (make COUNTERS=1) zones also collect the DWT event counters:
+ * stall (CPICNT), load/store (LSUCNT), exception (EXCCNT), sleep (SLEEPCNT) and folded
+ * instruction (FOLDCNT) cycles. Those counters are only 8 bits wide, so they can't be
+ * read at zone begin/end; instead SysTick opens a short window (< 256 cycles) every
+ * PROFILER_SAMPLE_PERIOD cycles or so and adds the counter deltas to every zone open at
+ * that moment. The report gives each counter as a share of the sampled cycles, after
+ * subtracting the sampling interrupt's own cost (measured over a NOP loop at enable).
+ * Target only; the host build samples nothing.
  */
 #ifndef PROFILER_H
 #define PROFILER_H
@@ -13,13 +37,133 @@ extern "C" {
 
 #ifdef PROFILING
 
-/** Return current CPU cycle count (DWT). Call profiler_init() first. */
+typedef int profiler_zone_t;
+
+typedef struct
+{
+    uint32_t count;
+    uint64_t min;
+    uint64_t max;
+    uint64_t mean;
+    uint64_t p50; /* histogram estimates, within [min, max] */
+    uint64_t p99;
+    uint64_t last;     /* most recent sample */
+    uint32_t clock_hz; /* core clock of the last sample */
+} profiler_stats_t;
+
+/** Enable and clear the DWT cycle counter. Call once at startup. */
+void profiler_init(void);
+
+/** Return current CPU cycle count (DWT, 32-bit: use for short differences only). */
 uint32_t profiler_get_cycles(void);
 
+/** Cycles since profiler_init(), 64-bit. */
+uint64_t profiler_now(void);
+
+/**
+ * Milliseconds for cycles counted at clock_hz: perf_mode_burst_hz() for Invoke() / IVF
+ * (they run in bursts), perf_mode_clock_hz() for code measured in the current mode.
+ */
+double profiler_cycles_to_ms(uint64_t cycles, uint32_t clock_hz);
+
+/** Zone id for name (created on first use; name must outlive the profiler). -1 if full. */
+profiler_zone_t profiler_zone(const char *name);
+
+/** Number of zones and the name of one (nullptr if unknown). */
+int profiler_zone_count(void);
+const char *profiler_zone_name(profiler_zone_t zone);
+
+/** Start / stop timing a zone; stop adds the elapsed cycles as one sample. Time at 96 and
+ * 192 MHz inside the zone is counted separately (perf_mode_cycles()), so the sample is
+ * right for zones that span a mode switch; it is given in cycles of the zone's clock. */
+void profiler_zone_begin(profiler_zone_t zone);
+void profiler_zone_end(profiler_zone_t zone);
+
+/** Add a sample measured elsewhere (e.g. the IVF step breakdown), counted at clock_hz. */
+void profiler_zone_add(profiler_zone_t zone, uint64_t cycles, uint32_t clock_hz);
+
+/** Statistics of a zone so far. Returns 0 on success, -1 for an unknown zone. */
+int profiler_zone_stats(profiler_zone_t zone, profiler_stats_t *stats);
+
+/** Print count, mean, min, max, p50 and p99 (cycles and ms) of every zone with samples
+ * (and the counter shares, with PROFILER_COUNTERS). */
+void profiler_report(void);
+
+/** Clear the samples of every zone (zones stay registered). */
+void profiler_reset(void);
+
+#ifdef PROFILER_COUNTERS
+
+#ifndef PROFILER_SAMPLE_PERIOD
+#define PROFILER_SAMPLE_PERIOD 20000 /* core cycles between windows, plus up to 4095 of jitter */
+#endif
+
+/** DWT counter samples of a zone: sums over the windows taken while it was open. */
+typedef struct
+{
+    uint32_t samples; /* windows */
+    uint64_t cycles;  /* sampled cycles, sampling overhead removed */
+    uint64_t cpi;     /* extra cycles of multi-cycle instructions (stalls, excluding load/store) */
+    uint64_t lsu;     /* extra cycles of load/store instructions */
+    uint64_t exc;     /* exception entry / exit cycles (other interrupts) */
+    uint64_t sleep;   /* cycles asleep */
+    uint64_t fold;    /* folded (zero-cycle) instructions */
+} profiler_counters_t;
+
+/** Start / stop the SysTick sampler (calibrates on first start). Returns the previous setting. */
+int profiler_counters_enable(int enabled);
+
+/** Counter samples of a zone, overhead-corrected. Returns 0 on success, -1 for an unknown zone. */
+int profiler_zone_counters(profiler_zone_t zone, profiler_counters_t *counters);
+
+#endif /* PROFILER_COUNTERS */
+
+/* The zone id is looked up once per call site */
+#define PROFILE_ZONE_CALL_(fn, name)               \
+    do                                             \
+    {                                              \
+        static profiler_zone_t profile_zone_ = -1; \
+        if (profile_zone_ < 0)                     \
+            profile_zone_ = profiler_zone(name);   \
+        fn(profile_zone_);                         \
+    } while (0)
+#define PROFILE_BEGIN(name) PROFILE_ZONE_CALL_(profiler_zone_begin, name)
+#define PROFILE_END(name) PROFILE_ZONE_CALL_(profiler_zone_end, name)
+
+#else
+
+#define PROFILE_BEGIN(name) ((void)0)
+#define PROFILE_END(name) ((void)0)
+
 #endif /* PROFILING */
 
 #ifdef __cplusplus
 }
 #endif
 
+#ifdef __cplusplus
+#ifdef PROFILING
+/** Times the enclosing scope as one sample of a zone. */
+class ProfileScope
+{
+public:
+    explicit ProfileScope(profiler_zone_t zone) : zone_(zone) { profiler_zone_begin(zone_); }
+    ~ProfileScope() { profiler_zone_end(zone_); }
+    ProfileScope(const ProfileScope &) = delete;
+    ProfileScope &operator=(const ProfileScope &) = delete;
+
+private:
+    profiler_zone_t zone_;
+};
+
+#define PROFILE_SCOPE_CONCAT_(a, b) a##b
+#define PROFILE_SCOPE_NAME_(prefix, line) PROFILE_SCOPE_CONCAT_(prefix, line)
+#define PROFILE_SCOPE(name)                                                                          \
+    static const profiler_zone_t PROFILE_SCOPE_NAME_(profile_zone_, __LINE__) = profiler_zone(name); \
+    ProfileScope PROFILE_SCOPE_NAME_(profile_scope_, __LINE__)(PROFILE_SCOPE_NAME_(profile_zone_, __LINE__))
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#endif
+#endif
+
 #endif /* PROFILER_H */
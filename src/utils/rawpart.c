@@ -0,0 +1,130 @@
+/**
+ * Raw data partition reader (see rawpart.h).
+ */
+#include "rawpart.h"
+
+#include <string.h>
+
+#include "am_util.h"
+#include "crc32.h"
+#include "ff.h"
+#include "diskio.h"
+
+#define MBR_TABLE 446
+#define MBR_ENTRY_SIZE 16
+#define MBR_ENTRIES 4
+
+static struct
+{
+    int mounted;
+    uint8_t pdrv;
+    LBA_t lba; /* first sector of the partition */
+    rawpart_superblock_t sb;
+} part;
+
+static uint8_t sector_buf[RAWPART_SECTOR] __attribute__((aligned(4)));
+
+static uint32_t load_le32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/* Extents must lie inside the partition, after the superblock */
+static int check_superblock(const rawpart_superblock_t *sb, uint32_t sectors)
+{
+    if (sb->magic != RAWPART_MAGIC || sb->extent_count > RAWPART_MAX_EXTENTS || sb->sectors != sectors)
+        return -1;
+    if (crc32_update(0, sb->extents, sb->extent_count * sizeof(rawpart_extent_t)) != sb->crc32)
+        return -1;
+    for (uint32_t i = 0; i < sb->extent_count; i++)
+    {
+        const rawpart_extent_t *e = &sb->extents[i];
+        if (e->start == 0 || e->start > sectors || e->sectors > sectors - e->start ||
+            e->bytes > (uint64_t)e->sectors * RAWPART_SECTOR)
+            return -1;
+    }
+    return 0;
+}
+
+int rawpart_mount(uint8_t pdrv)
+{
+    part.mounted = 0;
+    if (disk_read(pdrv, sector_buf, 0, 1) != RES_OK || sector_buf[510] != 0x55 || sector_buf[511] != 0xAA)
+        return -1;
+    for (int i = 0; i < MBR_ENTRIES; i++)
+    {
+        const uint8_t *entry = sector_buf + MBR_TABLE + i * MBR_ENTRY_SIZE;
+        if (entry[4] != RAWPART_MBR_TYPE)
+            continue;
+        LBA_t lba = load_le32(entry + 8);
+        uint32_t sectors = load_le32(entry + 12);
+        if (disk_read(pdrv, sector_buf, lba, 1) != RES_OK)
+        {
+            am_util_stdio_printf("[rawpart] Cannot read superblock at LBA %lu\r\n", (unsigned long)lba);
+            return -1;
+        }
+        memcpy(&part.sb, sector_buf, sizeof(part.sb));
+        if (check_superblock(&part.sb, sectors) != 0)
+        {
+            am_util_stdio_printf("[rawpart] Bad superblock at LBA %lu\r\n", (unsigned long)lba);
+            return -1;
+        }
+        part.pdrv = pdrv;
+        part.lba = lba;
+        part.mounted = 1;
+        return 0;
+    }
+    return -1;
+}
+
+const rawpart_extent_t *rawpart_find(const char *name)
+{
+    if (!part.mounted)
+        return NULL;
+    for (uint32_t i = 0; i < part.sb.extent_count; i++)
+    {
+        if (strncmp(part.sb.extents[i].name, name, RAWPART_NAME_LEN) == 0)
+            return &part.sb.extents[i];
+    }
+    return NULL;
+}
+
+/* Part of one sector, through the bounce buffer */
+static int read_partial(LBA_t lba, uint32_t skip, uint8_t *dst, uint32_t len)
+{
+    if (disk_read(part.pdrv, sector_buf, lba, 1) != RES_OK)
+        return -1;
+    memcpy(dst, sector_buf + skip, len);
+    return 0;
+}
+
+int rawpart_read(const rawpart_extent_t *extent, uint32_t offset, void *buf, uint32_t len)
+{
+    if (!part.mounted || offset > extent->bytes || len > extent->bytes - offset)
+        return -1;
+    uint8_t *dst = (uint8_t *)buf;
+    LBA_t lba = part.lba + extent->start + offset / RAWPART_SECTOR;
+    uint32_t skip = offset % RAWPART_SECTOR;
+    if (skip != 0 && len > 0)
+    {
+        uint32_t n = RAWPART_SECTOR - skip < len ? RAWPART_SECTOR - skip : len;
+        if (read_partial(lba, skip, dst, n) != 0)
+            return -1;
+        dst += n;
+        len -= n;
+        lba++;
+    }
+    /* Whole sectors: one multi-block transfer straight into buf */
+    uint32_t sectors = len / RAWPART_SECTOR;
+    if (sectors > 0)
+    {
+        if (disk_read(part.pdrv, dst, lba, sectors) != RES_OK)
+            return -1;
+        dst += sectors * RAWPART_SECTOR;
+        len -= sectors * RAWPART_SECTOR;
+        lba += sectors;
+    }
+    if (len > 0 && read_partial(lba, 0, dst, len) != 0)
+        return -1;
+    return 0;
+}
@@ -0,0 +1,64 @@
+/**
+ * Raw data partition: read-only bulk data addressed by LBA, next to the FAT volume.
+ *
+ * The SD card keeps its FAT/exFAT partition (config, model.bin, logs) and gets a second
+ * MBR partition of type RAWPART_MBR_TYPE (written by python_scripts/make_sd_image.py).
+ * Its first sector is a rawpart_superblock_t listing named extents: contiguous sector
+ * runs holding e.g. a packed image dataset (dataset_open_raw()). Reads go straight to
+ * disk_read(), i.e. one sd_spi_read_multi_block() per call, without FatFs cluster-chain
+ * lookups or its sector buffer; only a partial first / last sector goes through a
+ * 512-byte bounce buffer.
+ *
+ * Call rawpart_mount() after f_mount() (which initializes the card). One raw partition
+ * is mounted at a time.
+ */
+#ifndef RAWPART_H
+#define RAWPART_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RAWPART_MAGIC 0x31574152u /* "RAW1" */
+#define RAWPART_MBR_TYPE 0xDA     /* "non-FS data" */
+#define RAWPART_SECTOR 512u
+#define RAWPART_MAX_EXTENTS 15
+#define RAWPART_NAME_LEN 16
+
+typedef struct
+{
+    char name[RAWPART_NAME_LEN]; /* NUL-padded */
+    uint32_t start;              /* first sector, from the start of the partition */
+    uint32_t sectors;            /* sectors reserved */
+    uint32_t bytes;              /* data bytes (<= sectors * 512) */
+    uint32_t crc32;              /* CRC-32 of the data bytes (checked by the host tool, not at mount) */
+} rawpart_extent_t;
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t extent_count;
+    uint32_t sectors; /* partition size, as in the MBR */
+    uint32_t crc32;   /* CRC-32 of extents[0 .. extent_count - 1] */
+    rawpart_extent_t extents[RAWPART_MAX_EXTENTS];
+} rawpart_superblock_t; /* 496 bytes, fits the first sector */
+
+/**
+ * Find the raw partition on physical drive pdrv and check its superblock.
+ * Returns 0; -1 if the card has none (silent) or it is corrupt (reason printed).
+ */
+int rawpart_mount(uint8_t pdrv);
+
+/** Extent called name, or NULL (also when nothing is mounted). */
+const rawpart_extent_t *rawpart_find(const char *name);
+
+/** Read len bytes at offset within extent into buf. Returns 0, or -1 on a range or disk error. */
+int rawpart_read(const rawpart_extent_t *extent, uint32_t offset, void *buf, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RAWPART_H */
@@ -0,0 +1,18 @@
+/**
+ * TCM code/data load (see tcm.h). The prebuilt startup code only copies .data, so the
+ * .tcm section is copied here.
+ */
+#include "tcm.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/* libs/linker_script.ld */
+extern uint32_t _stcm;
+extern uint32_t _etcm;
+extern uint32_t _tcm_load;
+
+void tcm_init(void)
+{
+    memcpy(&_stcm, &_tcm_load, (size_t)((uint8_t *)&_etcm - (uint8_t *)&_stcm));
+}
@@ -0,0 +1,35 @@
+/**
+ * Code and data placement in TCM (0-wait-state, vs MRAM for .text).
+ *
+ * TCM_TEXT / TCM_DATA put a function or initialized variable in the .tcm output section
+ * (libs/linker_script.ld). Its load image stays in MRAM and tcm_init() copies it at the
+ * top of main(), so nothing placed there may run or be read before that. Zero-initialized
+ * variables need no annotation: .bss is already in TCM.
+ *
+ * Library code (CMSIS-NN kernels) is placed by input section name through
+ * libs/tcm_sections.ld, generated from a map file and a profile by
+ * python_scripts/tcm_plan.py. The build prints TCM usage (python_scripts/tcm_report.py).
+ */
+#ifndef TCM_H
+#define TCM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(__arm__)
+/* MRAM (0x00018000) and TCM (0x10000000) are further apart than a BL can reach */
+#define TCM_TEXT __attribute__((section(".tcm_text"), noinline, long_call))
+#else
+#define TCM_TEXT __attribute__((section(".tcm_text"), noinline))
+#endif
+#define TCM_DATA __attribute__((section(".tcm_data")))
+
+/** Copy the .tcm load image from MRAM. Call first thing in main(). */
+void tcm_init(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TCM_H */
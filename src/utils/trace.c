@@ -0,0 +1,88 @@
+/**
+ * Event trace ring buffer (see trace.h). Only built with TRACE.
+ */
+#include "trace.h"
+
+#ifdef TRACE
+
+#include <string.h>
+
+#if (TRACE_EVENTS & (TRACE_EVENTS - 1)) != 0
+#error "TRACE_EVENTS must be a power of two"
+#endif
+
+#if defined(__arm__)
+#define TRACE_BSS __attribute__((section(".shared_bss")))
+#else
+#define TRACE_BSS
+#endif
+
+static trace_event_t events[TRACE_EVENTS] TRACE_BSS;
+static uint32_t written = 0; /* total since the last clear; next slot = written % TRACE_EVENTS */
+static int enabled = 1;
+static uint8_t clock_mhz = 96;
+
+void trace_record(uint8_t type, profiler_zone_t zone, uint32_t arg)
+{
+    if (!enabled || zone < 0)
+        return;
+    trace_event_t *e = &events[written++ & (TRACE_EVENTS - 1)];
+    e->timestamp = profiler_now();
+    e->zone = (uint16_t)zone;
+    e->type = type;
+    e->clock_mhz = clock_mhz;
+    e->arg = arg;
+}
+
+void trace_set_clock(uint32_t clock_hz)
+{
+    clock_mhz = (uint8_t)(clock_hz / 1000000u);
+    TRACE_EVENT_(TRACE_EVENT_CLOCK, "clock", clock_hz);
+}
+
+int trace_enable(int enable)
+{
+    int previous = enabled;
+    enabled = enable;
+    return previous;
+}
+
+void trace_clear(void)
+{
+    written = 0;
+}
+
+uint32_t trace_dump(void (*write)(const uint8_t *data, uint32_t len))
+{
+    int was_enabled = trace_enable(0);
+    uint32_t count = (written < TRACE_EVENTS) ? written : TRACE_EVENTS;
+    uint32_t first = written - count;
+
+    trace_dump_header_t header;
+    header.magic = TRACE_MAGIC;
+    header.zone_count = (uint32_t)profiler_zone_count();
+    header.event_count = count;
+    header.dropped = first;
+    write((const uint8_t *)&header, sizeof(header));
+    for (int i = 0; i < (int)header.zone_count; i++)
+    {
+        const char *name = profiler_zone_name(i);
+        size_t len = strlen(name);
+        uint8_t len8 = (uint8_t)((len < 255) ? len : 255);
+        write(&len8, 1);
+        write((const uint8_t *)name, len8);
+    }
+
+    /* Oldest first: [first % N .. end) then [0 .. rest) */
+    uint32_t start = first & (TRACE_EVENTS - 1);
+    uint32_t tail = (count < TRACE_EVENTS - start) ? count : TRACE_EVENTS - start;
+    write((const uint8_t *)&events[start], tail * sizeof(trace_event_t));
+    if (count > tail)
+        write((const uint8_t *)&events[0], (count - tail) * sizeof(trace_event_t));
+
+    trace_clear();
+    trace_enable(was_enabled);
+    return count;
+}
+
+#endif /* TRACE */
@@ -0,0 +1,100 @@
+/**
+ * Event trace: fixed-size ring buffer of begin / end / instant events for Chrome
+ * trace_event JSON (Perfetto), built with make TRACE=1 (implies PROFILING).
+ *
+ * Every profiler zone begin/end (profiler.h) is recorded, plus one begin/end per TFLM op
+ * (the kernel trampolines in model_partial.cc), SD transfers (diskio.c) and core clock switches (perf_mode.c).
+ * When the ring is full the oldest events are overwritten. An event is a 64-bit cycle
+ * timestamp, the zone id, the core clock and a 32-bit argument; recording one costs a
+ * timestamp read and a 16-byte store.
+ *
+ * trace_dump() streams the zone names and the events as compact binary (UART 'T' command);
+ * python_scripts/trace_dump.py converts that to JSON. Recording is not interrupt safe:
+ * record from thread mode only.
+ */
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+#include "profiler.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef TRACE
+
+#ifndef TRACE_EVENTS
+#define TRACE_EVENTS 2048 /* power of two; 16 bytes each, in SHARED_SRAM */
+#endif
+
+#define TRACE_MAGIC 0x31435254u /* "TRC1" */
+
+enum
+{
+    TRACE_EVENT_BEGIN = 0,
+    TRACE_EVENT_END = 1,
+    TRACE_EVENT_INSTANT = 2,
+    TRACE_EVENT_CLOCK = 3 /* arg = new core clock in Hz */
+};
+
+typedef struct
+{
+    uint64_t timestamp; /* profiler_now() cycles */
+    uint16_t zone;      /* profiler zone id */
+    uint8_t type;       /* TRACE_EVENT_* */
+    uint8_t clock_mhz;  /* core clock from this event on */
+    uint32_t arg;
+} trace_event_t;
+
+/** Dump header, followed by zone_count x {uint8 len, name[len]} and event_count events, oldest first. */
+typedef struct __attribute__((packed))
+{
+    uint32_t magic;
+    uint32_t zone_count;
+    uint32_t event_count;
+    uint32_t dropped; /* overwritten before the dump */
+} trace_dump_header_t;
+
+/** Record one event (thread mode only). */
+void trace_record(uint8_t type, profiler_zone_t zone, uint32_t arg);
+
+/** Core clock for the following events; records a TRACE_EVENT_CLOCK. Called by perf_mode.c. */
+void trace_set_clock(uint32_t clock_hz);
+
+/** Pause / resume recording. Returns the previous setting. */
+int trace_enable(int enabled);
+
+/** Drop all recorded events. */
+void trace_clear(void);
+
+/** Stream the trace through write() (recording is paused meanwhile) and clear it. Returns events sent. */
+uint32_t trace_dump(void (*write)(const uint8_t *data, uint32_t len));
+
+/* Trace-only events (no zone statistics); the zone id is looked up once per call site */
+#define TRACE_EVENT_(type, name, arg)                       \
+    do                                                      \
+    {                                                       \
+        static profiler_zone_t trace_zone_ = -1;            \
+        if (trace_zone_ < 0)                                \
+            trace_zone_ = profiler_zone(name);              \
+        trace_record((type), trace_zone_, (uint32_t)(arg)); \
+    } while (0)
+#define TRACE_BEGIN(name, arg) TRACE_EVENT_(TRACE_EVENT_BEGIN, name, arg)
+#define TRACE_END(name, arg) TRACE_EVENT_(TRACE_EVENT_END, name, arg)
+#define TRACE_INSTANT(name, arg) TRACE_EVENT_(TRACE_EVENT_INSTANT, name, arg)
+
+#else
+
+#define TRACE_BEGIN(name, arg) ((void)0)
+#define TRACE_END(name, arg) ((void)0)
+#define TRACE_INSTANT(name, arg) ((void)0)
+
+#endif /* TRACE */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TRACE_H */